@@ -93,6 +93,14 @@ typedef struct RcclComm_t* rcclComm_t;
 //! for each gpu
 typedef struct RcclUniqueId* rcclUniqueId;
 
+//! rcclRegHandle_t is returned when a buffer is registered with a communicator
+//! and is used to deregister it
+typedef struct RcclRegHandle_t* rcclRegHandle_t;
+
+//! rcclPlan_t holds an op whose arguments are checked and whose kernels are
+//! selected once, so that it can be launched many times
+typedef struct RcclPlan_t* rcclPlan_t;
+
 //! Returns RCCL API status as string
 
 //! \param [in] result
@@ -143,6 +151,26 @@ rcclResult_t rcclCommCount(rcclComm_t comm, int* count);
 //! \param [in] comm Communicator to be destroyed
 rcclResult_t rcclCommDestroy(rcclComm_t comm);
 
+//! Register device buffer ptr of size bytes with communicator. Ops whose
+//! buffers lie in registered buffers do not publish the buffer pointers to
+//! peer gpus again if the same buffers were published by the previous op
+//! using the same sync slot. Ops still start with a barrier among the gpus,
+//! as it also makes sure peers are done writing their buffers before they are
+//! read. Buffer must stay allocated until it is deregistered
+
+//! \param [in] comm Communicator for current gpu
+//! \param [in] ptr Device buffer to be registered
+//! \param [in] bytes Size of buffer in bytes
+//! \param [out] handle Memory location to rcclRegHandle_t of the registration
+rcclResult_t rcclCommRegister(rcclComm_t comm, void* ptr, size_t bytes,
+                              rcclRegHandle_t* handle);
+
+//! Deregister buffer registered with rcclCommRegister
+
+//! \param [in] comm Communicator the buffer is registered with
+//! \param [in] handle rcclRegHandle_t returned by rcclCommRegister
+rcclResult_t rcclCommDeregister(rcclComm_t comm, rcclRegHandle_t handle);
+
 //! Does reduction op on sendbuff on all gpus and store the result to all gpus
 //! on recvbuff Reduction op (rcclRedOp_t) is done on data (of data type
 //! rcclDataType_t) in sendbuff of length = count on all gpus and stored in
@@ -161,6 +189,66 @@ rcclResult_t rcclAllReduce(const void* sendbuff, void* recvbuff, int count,
                            rcclDataType_t datatype, rcclRedOp_t op,
                            rcclComm_t comm, hipStream_t stream);
 
+//! Same as rcclAllReduce with a size_t number of elements. Buffers with more
+//! than 2^30 elements are reduced in chunks, launched one after another
+
+//! \param [in] sendbuff Source buffer
+//! \param [in] recvbuff Destination buffer
+//! \param [in] count Number of elements in buffer
+//! \param [in] datatype Data type of buffers
+//! \param [in] op Reduction operation on buffers
+//! \param [in] comm Communicator for current gpu
+//! \param [in] stream HIP stream the op launches on
+rcclResult_t rcclAllReduce64(const void* sendbuff, void* recvbuff, size_t count,
+                             rcclDataType_t datatype, rcclRedOp_t op,
+                             rcclComm_t comm, hipStream_t stream);
+
+//! Does rcclAllReduce on a batch of ntensors tensors. Tensor i has counts[i]
+//! elements in sendbuffs[i] and recvbuffs[i]. All tensors are reduced by the
+//! same kernel with one sync phase for the whole batch, which is faster than
+//! calling rcclAllReduce for each tensor when tensors are small
+
+//! \param [in] sendbuffs Source buffer of each tensor
+//! \param [in] recvbuffs Destination buffer of each tensor
+//! \param [in] counts Number of elements in each tensor
+//! \param [in] ntensors Number of tensors
+//! \param [in] datatype Data type of buffers
+//! \param [in] op Reduction operation on buffers
+//! \param [in] comm Communicator for current gpu
+//! \param [in] stream HIP stream the op launches on
+rcclResult_t rcclAllReduceMulti(const void** sendbuffs, void** recvbuffs,
+                                const size_t* counts, int ntensors,
+                                rcclDataType_t datatype, rcclRedOp_t op,
+                                rcclComm_t comm, hipStream_t stream);
+
+//! Create plan of rcclAllReduce with given arguments. Arguments are checked
+//! and algorithm and kernels are selected when the plan is created. Executing
+//! the plan is same as calling rcclAllReduce with the arguments, plans are
+//! executed in the same order as other ops on all gpus
+
+//! \param [in] sendbuff Source buffer
+//! \param [in] recvbuff Destination buffer
+//! \param [in] count Number of elements in buffer
+//! \param [in] datatype Data type of buffers
+//! \param [in] op Reduction operation on buffers
+//! \param [in] comm Communicator for current gpu
+//! \param [out] plan Memory location to rcclPlan_t created
+rcclResult_t rcclAllReducePlanCreate(const void* sendbuff, void* recvbuff,
+                                     int count, rcclDataType_t datatype,
+                                     rcclRedOp_t op, rcclComm_t comm,
+                                     rcclPlan_t* plan);
+
+//! Launch op of plan on stream
+
+//! \param [in] plan Plan to be executed
+//! \param [in] stream HIP stream the op launches on
+rcclResult_t rcclPlanExecute(rcclPlan_t plan, hipStream_t stream);
+
+//! Destroy plan
+
+//! \param [in] plan Plan to be destroyed
+rcclResult_t rcclPlanDestroy(rcclPlan_t plan);
+
 //! Data (of data type rcclDataType_t) present in root gpus buff of length count
 //! is broadcasted to all other gpus. The operation is launched on stream
 //! provided.
@@ -173,6 +261,19 @@ rcclResult_t rcclAllReduce(const void* sendbuff, void* recvbuff, int count,
 rcclResult_t rcclBcast(void* buff, int count, rcclDataType_t datatype, int root,
                        rcclComm_t comm, hipStream_t stream);
 
+//! Same as rcclBcast with a size_t number of elements. Buffers with more than
+//! 2^30 elements are broadcasted in chunks, launched one after another
+
+//! \param [in] buff Source buffer for root gpu, destination buffer for non-root
+//! gpus
+//! \param [in] count Number of elements in buffer
+//! \param [in] datatype Data type of buffers
+//! \param [in] root HIP device index of the root gpu
+//! \param [in] comm Communicator for current gpu
+//! \param [in] stream HIP stream the op launches on
+rcclResult_t rcclBcast64(void* buff, size_t count, rcclDataType_t datatype,
+                         int root, rcclComm_t comm, hipStream_t stream);
+
 //! Does reduction op on sendbuff on all gpus and stores result in recvbuff of
 //! root gpu Reduction op (rcclRedOp_t) is done on data (of data type
 //! rcclDataType_t) in sendbuff of length = count on all gpus and store in
@@ -191,6 +292,21 @@ rcclResult_t rcclReduce(const void* sendbuff, void* recvbuff, int count,
                         rcclDataType_t datatype, rcclRedOp_t op, int root,
                         rcclComm_t comm, hipStream_t stream);
 
+//! Same as rcclReduce with a size_t number of elements. Buffers with more
+//! than 2^30 elements are reduced in chunks, launched one after another
+
+//! \param [in] sendbuff Source buffer
+//! \param [in] recvbuff Destination buffer
+//! \param [in] count Number of elements in buffer
+//! \param [in] datatype Data type of buffers
+//! \param [in] op Reduction operation on buffers
+//! \param [in] root HIP device index of the root gpu
+//! \param [in] comm Communicator for current gpu
+//! \param [in] stream HIP stream the op launches on
+rcclResult_t rcclReduce64(const void* sendbuff, void* recvbuff, size_t count,
+                          rcclDataType_t datatype, rcclRedOp_t op, int root,
+                          rcclComm_t comm, hipStream_t stream);
+
 //! Each gpu gathers values from other gpus' sendbuff into its recvbuff.
 //! Size of recvbuff needs to be count*num_of_gpus.
 //! The data is ordered by comm's device ranking.
@@ -204,6 +320,37 @@ rcclResult_t rcclReduce(const void* sendbuff, void* recvbuff, int count,
 rcclResult_t rcclAllGather(const void* sendbuff, int count, rcclDataType_t datatype,
                             void* recvbuff, rcclComm_t comm, hipStream_t stream);
 
+//! Same as rcclAllGather with a size_t number of elements. If there are more
+//! than 2^30 elements, chunks of slot of each gpu are broadcasted from it with
+//! rcclBcast one after another, and each gpu copies its own slot. Such an
+//! allgather can not be made between rcclGroupStart and rcclGroupEnd, it
+//! returns rcclInvalidArgument there
+
+//! \param [in] sendbuff Source buffer
+//! \param [in] count Number of elements in buffer
+//! \param [in] datatype Data type of buffers
+//! \param [in] recvbuff Destination buffer
+//! \param [in] comm Communicator for current gpu
+//! \param [in] stream HIP stream the op launches on
+rcclResult_t rcclAllGather64(const void* sendbuff, size_t count,
+                             rcclDataType_t datatype, void* recvbuff,
+                             rcclComm_t comm, hipStream_t stream);
+
+//! Start a group of ops. Ops made by the calling thread until matching
+//! rcclGroupEnd are checked and recorded, but not launched. Groups can be
+//! nested, ops are launched when the outermost group ends
+rcclResult_t rcclGroupStart();
+
+//! End a group of ops. Ops of the group are launched in the order they were
+//! made, ops of each device from a separate thread so that a single thread
+//! driving all gpus does not serialize their launches. Groups are per thread.
+//! If a single thread makes ops on communicators of all gpus of a clique in
+//! one group, consecutive small rcclAllReduce ops are launched as a single op,
+//! a multi-tensor one if their buffers do not follow each other. Groups of
+//! programs running one thread per gpu only see one communicator of the
+//! clique and are never fused
+rcclResult_t rcclGroupEnd();
+
 #ifdef __cplusplus
 }  // end extern "C"
 #endif
@@ -13,9 +13,11 @@ All rights reserved.
  * @author Aditya Atluri
  */
 
+#include "rcclAlgo.h"
 #include "rcclHelper.h"
 #include "rcclTracker.h"
 
+#include <algorithm>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -52,6 +54,22 @@ const char *get_env_val = getenv("RCCL_TRACE_RT");
 //! @brief Get debug trace level from environment variable
 int RCCL_TRACE_RT = get_env_val != nullptr ? atoi(get_env_val) : 0;
 
+//! @brief Get algorithm forced by user from environment variable RCCL_ALGO
+RcclAlgo_t RCCL_ALGO = RcclGetAlgoFromName(getenv("RCCL_ALGO"));
+
+//! @brief Get value of environment variable RCCL_FUSED
+const char *get_env_fused = getenv("RCCL_FUSED");
+//! @brief Launch one kernel per collective per gpu if set
+int RCCL_FUSED = get_env_fused != nullptr ? atoi(get_env_fused) : 0;
+
+//! @brief Get value of environment variable RCCL_NONTEMPORAL_BYTES
+const char *get_env_nontemporal = getenv("RCCL_NONTEMPORAL_BYTES");
+//! @brief Size of buffer from which kernels use non-temporal accesses, 4 MB
+//! by default
+size_t RCCL_NONTEMPORAL_BYTES =
+    get_env_nontemporal != nullptr ? strtoull(get_env_nontemporal, nullptr, 0)
+                                   : size_t(4) << 20;
+
 //! @brief Implementation of rcclGetErrorString
 const char *rcclGetErrorString(rcclResult_t result) {
     switch (result) {
@@ -126,7 +144,7 @@ rcclResult_t rcclCommInitRank(rcclComm_t *comm, int ndev, rcclUniqueId commId,
         return rcclInvalidRank;
     }
 
-    if (ndev < 1) {
+    if (ndev < 1 || ndev > kmax_gpus) {
         return rcclUnsupportedDeviceCount;
     }
 
@@ -176,7 +194,7 @@ rcclResult_t rcclCommInitAll(rcclComm_t *comm, int ndev, int *devlist) {
     //! Check if the system contains number of gpus requested
     int device_count;
     HIPCHECK(hipGetDeviceCount(&device_count));
-    if (ndev > device_count) {
+    if (ndev > device_count || ndev > kmax_gpus) {
         return rcclUnsupportedDeviceCount;
     }
 
@@ -206,23 +224,29 @@ rcclResult_t rcclCommInitAll(rcclComm_t *comm, int ndev, int *devlist) {
     //! Create pool of RingNode_ts
     RingNodePool_t *ppool = new RingNodePool_t(devlist, ndev);
 
-    RingNode_t *ptrack;
-
     //! Populate rcclComm_t using RingNodePool_t
     for (int i = 0; i < ndev; i++) {
         pcomm = new RcclComm_t;
-        ptrack = ppool->GetPoolByDeviceIndex(devlist[i]);
         pcomm->pool_ = ppool;
-        pcomm->track_ = ptrack;
         pcomm->device_ = devlist[i];
         pcomm->rank_ = i;
         pcomm->num_devices_ = ndev;
-        pcomm->this_time_ = 0;
-        pcomm->stream_ = NULL;
         comm[i] = pcomm;
         HIPCHECK(hipSetDevice(devlist[i]));
-        HIPCHECK(
-            hipEventCreateWithFlags(&pcomm->event_, hipEventReleaseToSystem));
+        for (int slot = 0; slot < knum_sync_slots; slot++) {
+            RcclCommSlot_t *pslot = &(pcomm->slots_[slot]);
+            pslot->track_ = ppool->GetPoolByDeviceIndex(devlist[i], slot);
+            pslot->stream_ = NULL;
+            pslot->this_time_ = 0;
+            pslot->p2p_time_ = 0;
+            pslot->tensors_ = nullptr;
+            pslot->max_tensors_ = 0;
+            HIPCHECK(hipMalloc(&pslot->scratch_, kone_shot_round_bytes));
+            HIPCHECK(hipEventCreateWithFlags(&pslot->event_,
+                                             hipEventReleaseToSystem));
+        }
+        pcomm->slot_ = &(pcomm->slots_[0]);
+        pcomm->seq_ = 0;
     }
 
     //! Restore saved device user
@@ -285,17 +309,78 @@ rcclResult_t rcclCommDestroy(rcclComm_t comm) {
     return rcclSuccess;
 }
 
+//! @brief Declaration of rcclCommRegister
+rcclResult_t rcclCommRegister(rcclComm_t comm, void *ptr, size_t bytes,
+                              rcclRegHandle_t *handle) {
+    if ((RCCL_TRACE_RT & krccl_print_api) == krccl_print_api) {
+        fprintf(stderr,
+                "%s<<rccl-api: %s comm:%p ptr:%p bytes:%zu handle:%p%s\n",
+                API_COLOR, __func__, comm, ptr, bytes, handle, API_COLOR_END);
+    }
+
+    //! Check if pointers and size are valid
+    if (comm == nullptr || handle == nullptr || bytes == 0) {
+        return rcclInvalidArgument;
+    }
+    if (ptr == nullptr) {
+        return rcclInvalidDevicePointer;
+    }
+    RcclComm_t *pcomm = comm;
+
+    RcclRegHandle_t *phandle = new RcclRegHandle_t;
+    phandle->ptr = static_cast<const char *>(ptr);
+    phandle->bytes = bytes;
+    pcomm->registered_.push_back(phandle);
+
+    *handle = phandle;
+    return rcclSuccess;
+}
+
+//! @brief Declaration of rcclCommDeregister
+rcclResult_t rcclCommDeregister(rcclComm_t comm, rcclRegHandle_t handle) {
+    if ((RCCL_TRACE_RT & krccl_print_api) == krccl_print_api) {
+        fprintf(stderr, "%s<<rccl-api: %s comm:%p handle:%p%s\n", API_COLOR,
+                __func__, comm, handle, API_COLOR_END);
+    }
+
+    if (comm == nullptr || handle == nullptr) {
+        return rcclInvalidArgument;
+    }
+    RcclComm_t *pcomm = comm;
+
+    //! Check if handle was registered with the communicator
+    auto it = std::find(pcomm->registered_.begin(), pcomm->registered_.end(),
+                        handle);
+    if (it == pcomm->registered_.end()) {
+        return rcclInvalidArgument;
+    }
+    pcomm->registered_.erase(it);
+    delete handle;
+    return rcclSuccess;
+}
+
+//! @brief Declaration of SetRegisteredBuffers
+void SetRegisteredBuffers(RcclComm_t *pcomm, const void *sendbuff,
+                          size_t send_bytes, const void *recvbuff,
+                          size_t recv_bytes) {
+    pcomm->slot_->track_->registered =
+        pcomm->IsRegistered(sendbuff, send_bytes) &&
+        (recvbuff == nullptr || pcomm->IsRegistered(recvbuff, recv_bytes));
+}
+
 //! @brief Declaration of PostEnqueueEventRecord
 void PostEnqueueEventRecord(RcclComm_t *pcomm, hipStream_t stream) {
-    if (stream != pcomm->stream_) {
-        hipEventRecord(pcomm->event_, stream);
-    }
+    hipEventRecord(pcomm->slot_->event_, stream);
 }
 
 //! @brief Declaration of PreEnqueueEventRecord
 void PreEnqueueEventRecord(RcclComm_t *pcomm, hipStream_t stream) {
-    if (stream != pcomm->stream_) {
-        hipStreamWaitEvent(stream, pcomm->event_, 0);
-        pcomm->stream_ = stream;
+    pcomm->slot_ = pcomm->NextSlot();
+    pcomm->seq_++;
+
+    RcclCommSlot_t *pslot = pcomm->slot_;
+    if (stream != pslot->stream_) {
+        hipStreamWaitEvent(stream, pslot->event_, 0);
+        pslot->stream_ = stream;
     }
 }
@@ -0,0 +1,44 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+/**
+ * @file rcclAlgo.cpp
+ * @brief Implementation of rcclAlgo.h
+ *
+ * This file contains implementation of helpers declared in rcclAlgo.h
+ */
+
+#include "rcclAlgo.h"
+
+#include <cstdio>
+#include <cstring>
+
+//! @brief Holds names of algorithms, indexed by RcclAlgo_t
+static const char *kalgo_names[krccl_num_algos] = {
+    "default", "mesh", "ring", "tree", "rhd", "oneshot"};
+
+//! @brief Definition of RcclGetAlgoFromName
+RcclAlgo_t RcclGetAlgoFromName(const char *name) {
+    if (name == nullptr) {
+        return krccl_algo_default;
+    }
+
+    for (int i = 0; i < krccl_num_algos; i++) {
+        if (strcmp(name, kalgo_names[i]) == 0) {
+            return static_cast<RcclAlgo_t>(i);
+        }
+    }
+
+    fprintf(stderr, "rccl: unknown algorithm \"%s\", using default\n", name);
+    return krccl_algo_default;
+}
+
+//! @brief Definition of RcclGetAlgoName
+const char *RcclGetAlgoName(RcclAlgo_t algo) {
+    if (algo < 0 || algo >= krccl_num_algos) {
+        return "unknown";
+    }
+    return kalgo_names[algo];
+}
@@ -0,0 +1,51 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+/**
+ * @file rcclAlgo.h
+ * @brief Algorithms available to implement rccl collectives
+ *
+ * This file contains the list of algorithms a collective can be implemented
+ * with and helpers to convert them from and to strings. It does not depend on
+ * HIP so that it can be used from host only code.
+ */
+
+#pragma once
+
+//! @brief Algorithms used to implement collectives
+//! RCCL_ALGO environment variable can be used to force one of them
+enum RcclAlgo_t {
+    //! Let rccl pick the algorithm
+    krccl_algo_default = 0,
+    //! Each gpu reads its slice from all the peers at the same time
+    krccl_algo_mesh,
+    //! Reduce-scatter followed by allgather over RingNode_t::next_gpu ring
+    krccl_algo_ring,
+    //! Pipelined reduce and broadcast over two complementary binary trees
+    krccl_algo_tree,
+    //! Recursive halving reduce-scatter followed by recursive doubling
+    //! allgather, only for power of two number of gpus
+    krccl_algo_rhd,
+    //! Single kernel, each gpu reads the whole buffer from all the peers
+    krccl_algo_oneshot,
+    //! Total number of algorithms
+    krccl_num_algos
+};
+
+//! Get algorithm from its name (for example, "ring"). If the name is nullptr
+//! or not recognized, krccl_algo_default is returned
+
+//! \param [in] name Name of the algorithm
+RcclAlgo_t RcclGetAlgoFromName(const char* name);
+
+//! Get name of the algorithm
+
+//! \param [in] algo Algorithm
+const char* RcclGetAlgoName(RcclAlgo_t algo);
+
+//! @brief Check if number of gpus can be used with recursive halving/doubling
+inline bool RcclIsPowerOfTwo(int num_gpus) {
+    return num_gpus > 0 && (num_gpus & (num_gpus - 1)) == 0;
+}
@@ -0,0 +1,422 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+/**
+ * @file rcclAlgoSelector.cpp
+ * @brief Implementation of rcclAlgoSelector.h
+ *
+ * This file contains implementation of cost model and tuning table declared
+ * in rcclAlgoSelector.h
+ */
+
+#include "rcclAlgoSelector.h"
+#include "rcclChannel.h"
+#include "rcclTree.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <string>
+
+//! @brief Holds names of collectives, indexed by RcclCollective_t
+static const char *kcoll_names[krccl_num_colls] = {"allreduce", "bcast",
+                                                   "reduce", "allgather"};
+
+//! @brief Holds names of topologies, indexed by RcclTopology_t
+static const char *ktopo_names[krccl_num_topos] = {"pcie", "xgmi"};
+
+//! @brief Algorithms implemented for each collective
+static const bool kimplemented[krccl_num_colls][krccl_num_algos] = {
+    //! default, mesh, ring, tree, rhd, oneshot
+    {false, true, true, true, true, true},
+    {false, true, false, false, false, false},
+    {false, true, false, false, false, false},
+    {false, true, true, false, false, false}};
+
+//! @brief Definition of RcclGetCollectiveFromName
+RcclCollective_t RcclGetCollectiveFromName(const char *name) {
+    for (int i = 0; name != nullptr && i < krccl_num_colls; i++) {
+        if (strcmp(name, kcoll_names[i]) == 0) {
+            return static_cast<RcclCollective_t>(i);
+        }
+    }
+    return krccl_num_colls;
+}
+
+//! @brief Definition of RcclGetTopologyFromName
+RcclTopology_t RcclGetTopologyFromName(const char *name) {
+    for (int i = 0; name != nullptr && i < krccl_num_topos; i++) {
+        if (strcmp(name, ktopo_names[i]) == 0) {
+            return static_cast<RcclTopology_t>(i);
+        }
+    }
+    return krccl_num_topos;
+}
+
+//! @brief Default constructor
+//! Default parameters assume a single pcie link (~12 GB/s) or xgmi link
+//! (~20 GB/s) per gpu, and ~10 us per kernel launch and barrier.
+//! Mesh and one-shot read from all peers at the same time, which contends
+//! over pcie but spreads over all the links with xgmi. One-shot synchronizes
+//! inside a single kernel, so its steps are cheaper. With xgmi, ring
+//! algorithms use several channels to spread over the links. Writes over
+//! pcie are posted while reads stall for a round trip, so mesh kernels push
+//! data to peers there. Xgmi reads are cheap and pulling keeps remote traffic
+//! of a gpu on its own kernel. One-shot moves (n - 1) times the buffer, with
+//! two gpus as much as mesh, so the model alone would pick it at any size. It
+//! is capped at 64KB, the expected crossover with mesh on both topologies,
+//! which is also one round of RcclKernelAllReduceOneShot
+RcclAlgoSelector_t::RcclAlgoSelector_t() {
+    num_channels_[krccl_topo_pcie] = 1;
+    num_channels_[krccl_topo_xgmi] = 4;
+    push_[krccl_topo_pcie] = true;
+    push_[krccl_topo_xgmi] = false;
+    max_oneshot_bytes_[krccl_topo_pcie] = 1 << 16;
+    max_oneshot_bytes_[krccl_topo_xgmi] = 1 << 16;
+
+    for (int coll = 0; coll < krccl_num_colls; coll++) {
+        for (int algo = 0; algo < krccl_num_algos; algo++) {
+            RcclAlgoCost_t* pcie = &costs_[coll][krccl_topo_pcie][algo];
+            RcclAlgoCost_t* xgmi = &costs_[coll][krccl_topo_xgmi][algo];
+
+            pcie->alpha = 10.0;
+            pcie->beta = 1.0 / 12e3;
+            xgmi->alpha = 8.0;
+            xgmi->beta = 1.0 / 20e3;
+
+            if (algo == krccl_algo_mesh || algo == krccl_algo_oneshot) {
+                pcie->beta = 1.0 / 8e3;
+                xgmi->beta = 1.0 / 50e3;
+            }
+
+            if (algo == krccl_algo_oneshot) {
+                pcie->alpha = 4.0;
+                xgmi->alpha = 3.0;
+            }
+        }
+    }
+}
+
+//! @brief Definition of SetCost
+void RcclAlgoSelector_t::SetCost(RcclCollective_t coll, RcclTopology_t topo,
+                                 RcclAlgo_t algo, RcclAlgoCost_t cost) {
+    costs_[coll][topo][algo] = cost;
+}
+
+//! @brief Definition of GetCost
+RcclAlgoCost_t RcclAlgoSelector_t::GetCost(RcclCollective_t coll,
+                                           RcclTopology_t topo,
+                                           RcclAlgo_t algo) const {
+    return costs_[coll][topo][algo];
+}
+
+//! @brief Definition of SetNumChannels
+void RcclAlgoSelector_t::SetNumChannels(RcclTopology_t topo,
+                                        int num_channels) {
+    num_channels_[topo] = std::min(std::max(num_channels, 1), kmax_channels);
+}
+
+//! @brief Definition of GetNumChannels
+int RcclAlgoSelector_t::GetNumChannels(RcclTopology_t topo) const {
+    return num_channels_[topo];
+}
+
+//! @brief Definition of SetPush
+void RcclAlgoSelector_t::SetPush(RcclTopology_t topo, bool push) {
+    push_[topo] = push;
+}
+
+//! @brief Definition of GetPush
+bool RcclAlgoSelector_t::GetPush(RcclTopology_t topo) const {
+    return push_[topo];
+}
+
+//! @brief Definition of SetMaxOneShotBytes
+void RcclAlgoSelector_t::SetMaxOneShotBytes(RcclTopology_t topo,
+                                            size_t bytes) {
+    max_oneshot_bytes_[topo] = bytes;
+}
+
+//! @brief Definition of GetMaxOneShotBytes
+size_t RcclAlgoSelector_t::GetMaxOneShotBytes(RcclTopology_t topo) const {
+    return max_oneshot_bytes_[topo];
+}
+
+//! @brief Definition of IsSupported
+bool RcclAlgoSelector_t::IsSupported(RcclCollective_t coll, RcclAlgo_t algo,
+                                     int num_gpus) const {
+    if (coll < 0 || coll >= krccl_num_colls || algo < 0 ||
+        algo >= krccl_num_algos || !kimplemented[coll][algo]) {
+        return false;
+    }
+
+    //! Recursive halving/doubling needs power of two number of gpus
+    if (algo == krccl_algo_rhd) {
+        return RcclIsPowerOfTwo(num_gpus);
+    }
+
+    return true;
+}
+
+//! @brief Definition of EstimateTime
+//! Number of steps and bytes moved by a gpu follow the schedule of each
+//! algorithm, see Rccl*Runtime.h
+double RcclAlgoSelector_t::EstimateTime(RcclCollective_t coll,
+                                        RcclAlgo_t algo, RcclTopology_t topo,
+                                        size_t bytes, int num_gpus) const {
+    if (!IsSupported(coll, algo, num_gpus) ||
+        (algo == krccl_algo_oneshot && bytes > max_oneshot_bytes_[topo])) {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    double n = num_gpus;
+    double size = static_cast<double>(bytes);
+    double steps = 0.0, moved = 0.0;
+
+    switch (coll) {
+    case krccl_coll_allreduce: {
+        //! Reduce-scatter and allgather phases both move (n - 1) / n of the
+        //! buffer
+        double scatter_gather = 2.0 * (n - 1.0) / n * size;
+        switch (algo) {
+        case krccl_algo_mesh: {
+            steps = 3.0;
+            moved = scatter_gather;
+            break;
+        }
+        case krccl_algo_ring: {
+            steps = 2.0 * n - 1.0;
+            moved = scatter_gather;
+            break;
+        }
+        case krccl_algo_rhd: {
+            int log2_n = 0;
+            while ((1 << log2_n) < num_gpus) log2_n++;
+            steps = 2.0 * log2_n + 1.0;
+            moved = scatter_gather;
+            break;
+        }
+        case krccl_algo_tree: {
+            //! Same chunking as RcclInternalAllReduceTree, each extra level
+            //! of the tree adds a pipeline step to both phases. Interior node
+            //! reads its half from both children and every gpu reads both
+            //! halves from parents
+            RcclTreeNode_t node;
+            RcclGetTreeNode(num_gpus, 0, 0, &node);
+            size_t half = bytes - bytes / 2;
+            int chunks = static_cast<int>((half + ktree_chunk_bytes - 1) /
+                                          ktree_chunk_bytes);
+            chunks = std::min(std::max(chunks, 1), kmax_tree_chunks);
+            double pipeline = chunks + node.tree_height - 1;
+            steps = 2.0 * pipeline + 1.0;
+            moved = 2.0 * size * pipeline / chunks;
+            break;
+        }
+        case krccl_algo_oneshot: {
+            steps = 2.0;
+            moved = (n - 1.0) * size;
+            break;
+        }
+        default: { break; }
+        }
+        break;
+    }
+    case krccl_coll_bcast: {
+        steps = 2.0;
+        moved = size;
+        break;
+    }
+    case krccl_coll_reduce: {
+        steps = 2.0;
+        moved = (n - 1.0) * size;
+        break;
+    }
+    case krccl_coll_allgather: {
+        steps = algo == krccl_algo_ring ? n : 2.0;
+        moved = (n - 1.0) * size;
+        break;
+    }
+    default: { break; }
+    }
+
+    //! Channels of ring algorithms read from different peers, which only
+    //! helps when each pair of gpus has its own link
+    if (algo == krccl_algo_ring && topo == krccl_topo_xgmi) {
+        moved /= RcclGetNumChannelPeers(num_gpus, num_channels_[topo]);
+    }
+
+    const RcclAlgoCost_t& cost = costs_[coll][topo][algo];
+    return cost.alpha * steps + cost.beta * moved;
+}
+
+//! @brief Definition of Select
+RcclAlgo_t RcclAlgoSelector_t::Select(RcclCollective_t coll, size_t type_size,
+                                      size_t count, int num_gpus,
+                                      RcclTopology_t topo,
+                                      RcclAlgo_t forced) const {
+    if (forced != krccl_algo_default && IsSupported(coll, forced, num_gpus)) {
+        return forced;
+    }
+
+    size_t bytes = type_size * count;
+    RcclAlgo_t best = krccl_algo_mesh;
+    double best_time = std::numeric_limits<double>::infinity();
+
+    for (int i = krccl_algo_mesh; i < krccl_num_algos; i++) {
+        RcclAlgo_t algo = static_cast<RcclAlgo_t>(i);
+        double time = EstimateTime(coll, algo, topo, bytes, num_gpus);
+        if (time < best_time) {
+            best = algo;
+            best_time = time;
+        }
+    }
+
+    return best;
+}
+
+//! @brief Definition of LoadTuningFile
+//! Each line is "<collective> <topology> <algorithm> <alpha> <beta>" or
+//! "channels <topology> <number of channels>" or "push <topology> <0 or 1>"
+//! or "oneshot_bytes <topology> <bytes>", empty lines and lines starting with
+//! '#' are ignored. Lines are applied to a copy of the selector, which
+//! replaces it once the whole file is parsed
+bool RcclAlgoSelector_t::LoadTuningFile(const char *path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    RcclAlgoSelector_t parsed = *this;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string coll_name, topo_name, algo_name;
+        RcclAlgoCost_t cost;
+
+        if (!(fields >> coll_name) || coll_name[0] == '#') {
+            continue;
+        }
+
+        if (coll_name == "channels") {
+            int num_channels = 0;
+            if (!(fields >> topo_name >> num_channels)) {
+                return false;
+            }
+            RcclTopology_t topo = RcclGetTopologyFromName(topo_name.c_str());
+            if (topo == krccl_num_topos || num_channels < 1) {
+                return false;
+            }
+            parsed.SetNumChannels(topo, num_channels);
+            continue;
+        }
+
+        if (coll_name == "push") {
+            int push = 0;
+            if (!(fields >> topo_name >> push)) {
+                return false;
+            }
+            RcclTopology_t topo = RcclGetTopologyFromName(topo_name.c_str());
+            if (topo == krccl_num_topos || (push != 0 && push != 1)) {
+                return false;
+            }
+            parsed.SetPush(topo, push == 1);
+            continue;
+        }
+
+        if (coll_name == "oneshot_bytes") {
+            long long bytes = 0;
+            if (!(fields >> topo_name >> bytes)) {
+                return false;
+            }
+            RcclTopology_t topo = RcclGetTopologyFromName(topo_name.c_str());
+            if (topo == krccl_num_topos || bytes < 0) {
+                return false;
+            }
+            parsed.SetMaxOneShotBytes(topo, static_cast<size_t>(bytes));
+            continue;
+        }
+
+        if (!(fields >> topo_name >> algo_name >> cost.alpha >> cost.beta)) {
+            return false;
+        }
+
+        RcclCollective_t coll = RcclGetCollectiveFromName(coll_name.c_str());
+        RcclTopology_t topo = RcclGetTopologyFromName(topo_name.c_str());
+        RcclAlgo_t algo = RcclGetAlgoFromName(algo_name.c_str());
+        if (coll == krccl_num_colls || topo == krccl_num_topos ||
+            algo == krccl_algo_default) {
+            return false;
+        }
+
+        parsed.SetCost(coll, topo, algo, cost);
+    }
+
+    *this = parsed;
+    return true;
+}
+
+//! @brief Definition of SaveTuningFile
+bool RcclAlgoSelector_t::SaveTuningFile(const char *path) const {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    file << "# collective topology algorithm alpha(us) beta(us/byte)\n";
+    file.precision(std::numeric_limits<double>::max_digits10);
+    for (int topo = 0; topo < krccl_num_topos; topo++) {
+        file << "channels " << ktopo_names[topo] << " " << num_channels_[topo]
+             << "\n";
+        file << "push " << ktopo_names[topo] << " " << (push_[topo] ? 1 : 0)
+             << "\n";
+        file << "oneshot_bytes " << ktopo_names[topo] << " "
+             << max_oneshot_bytes_[topo] << "\n";
+    }
+    for (int coll = 0; coll < krccl_num_colls; coll++) {
+        for (int topo = 0; topo < krccl_num_topos; topo++) {
+            for (int algo = 0; algo < krccl_num_algos; algo++) {
+                if (!kimplemented[coll][algo]) {
+                    continue;
+                }
+                const RcclAlgoCost_t& cost = costs_[coll][topo][algo];
+                file << kcoll_names[coll] << " " << ktopo_names[topo] << " "
+                     << RcclGetAlgoName(static_cast<RcclAlgo_t>(algo)) << " "
+                     << cost.alpha << " " << cost.beta << "\n";
+            }
+        }
+    }
+
+    return static_cast<bool>(file);
+}
+
+//! @brief Definition of RcclGetAlgoSelector
+RcclAlgoSelector_t &RcclGetAlgoSelector() {
+    static RcclAlgoSelector_t selector = [] {
+        RcclAlgoSelector_t s;
+        const char *path = getenv("RCCL_TUNING_FILE");
+        if (path != nullptr && !s.LoadTuningFile(path)) {
+            fprintf(stderr, "rccl: failed to load tuning file \"%s\"\n", path);
+        }
+        const char *num_channels = getenv("RCCL_NCHANNELS");
+        if (num_channels != nullptr) {
+            for (int topo = 0; topo < krccl_num_topos; topo++) {
+                s.SetNumChannels(static_cast<RcclTopology_t>(topo),
+                                 atoi(num_channels));
+            }
+        }
+        const char *push = getenv("RCCL_PUSH");
+        if (push != nullptr) {
+            for (int topo = 0; topo < krccl_num_topos; topo++) {
+                s.SetPush(static_cast<RcclTopology_t>(topo), atoi(push) != 0);
+            }
+        }
+        return s;
+    }();
+    return selector;
+}
@@ -0,0 +1,130 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+/**
+ * @file rcclAlgoSelector.h
+ * @brief Cost model used to pick an algorithm for a collective
+ *
+ * This file contains an alpha-beta cost model which estimates time taken by
+ * each algorithm of a collective and picks the cheapest one. Parameters of the
+ * model can be loaded from (and saved to) a tuning table file. It does not
+ * depend on HIP so that it can be used from host only code.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include "rcclAlgo.h"
+
+//! @brief Collectives which can be implemented with more than one algorithm
+enum RcclCollective_t {
+    krccl_coll_allreduce = 0,
+    krccl_coll_bcast,
+    krccl_coll_reduce,
+    krccl_coll_allgather,
+    //! Total number of collectives
+    krccl_num_colls
+};
+
+//! @brief How gpus in a clique are connected to each other
+enum RcclTopology_t {
+    //! At least one pair of gpus talks over pcie (or through host)
+    krccl_topo_pcie = 0,
+    //! Every pair of gpus is connected directly with xgmi
+    krccl_topo_xgmi,
+    //! Total number of topologies
+    krccl_num_topos
+};
+
+//! @brief Parameters of alpha-beta cost model for one algorithm
+//! Time taken by an algorithm is alpha * steps + beta * bytes, where steps is
+//! the number of multi-gpu synchronizations and bytes is the amount of data a
+//! gpu moves on the critical path
+struct RcclAlgoCost_t {
+    //! Latency of one step (kernel launch and barrier) in us
+    double alpha;
+    //! Time to move one byte in us
+    double beta;
+};
+
+//! @brief Definition of RcclAlgoSelector_t
+//! Holds cost model parameters for each (collective, topology, algorithm)
+//! and picks algorithm for a collective call
+class RcclAlgoSelector_t {
+  private:
+    //! Parameters of cost model
+    RcclAlgoCost_t costs_[krccl_num_colls][krccl_num_topos][krccl_num_algos];
+    //! Number of channels ring algorithms split a buffer into
+    int num_channels_[krccl_num_topos];
+    //! Mesh kernels write data into peer buffers (push) instead of reading it
+    //! from them (pull)
+    bool push_[krccl_num_topos];
+    //! Largest buffer in bytes one-shot allreduce is picked for. Each gpu
+    //! reads the whole buffer from every peer in a single kernel, which stops
+    //! paying off once the buffer no longer fits in a few round trips
+    size_t max_oneshot_bytes_[krccl_num_topos];
+
+  public:
+    //! Construct selector with default parameters
+    RcclAlgoSelector_t();
+    //! Set cost model parameters of an algorithm
+    void SetCost(RcclCollective_t coll, RcclTopology_t topo, RcclAlgo_t algo,
+                 RcclAlgoCost_t cost);
+    //! Get cost model parameters of an algorithm
+    RcclAlgoCost_t GetCost(RcclCollective_t coll, RcclTopology_t topo,
+                           RcclAlgo_t algo) const;
+    //! Set number of channels used with a topology
+    void SetNumChannels(RcclTopology_t topo, int num_channels);
+    //! Get number of channels used with a topology
+    int GetNumChannels(RcclTopology_t topo) const;
+    //! Set if mesh kernels push data to peers with a topology
+    void SetPush(RcclTopology_t topo, bool push);
+    //! Check if mesh kernels push data to peers with a topology
+    bool GetPush(RcclTopology_t topo) const;
+    //! Set largest buffer one-shot allreduce is picked for with a topology
+    void SetMaxOneShotBytes(RcclTopology_t topo, size_t bytes);
+    //! Get largest buffer one-shot allreduce is picked for with a topology
+    size_t GetMaxOneShotBytes(RcclTopology_t topo) const;
+    //! Check if algorithm is implemented for collective and number of gpus
+    bool IsSupported(RcclCollective_t coll, RcclAlgo_t algo,
+                     int num_gpus) const;
+    //! Estimate time taken by algorithm in us, bytes is the size of buffer
+    //! passed to collective by a gpu. One-shot allreduce of more than
+    //! max_oneshot_bytes_ takes infinite time
+    double EstimateTime(RcclCollective_t coll, RcclAlgo_t algo,
+                        RcclTopology_t topo, size_t bytes, int num_gpus) const;
+    //! Pick algorithm for collective. If forced is not krccl_algo_default and
+    //! it is supported, it is returned as is. Every gpu must pick the same
+    //! algorithm, while only the gpu itself knows if its op is in place, so
+    //! every algorithm that can be returned must be correct in place
+    RcclAlgo_t Select(RcclCollective_t coll, size_t type_size, size_t count,
+                      int num_gpus, RcclTopology_t topo,
+                      RcclAlgo_t forced) const;
+    //! Load parameters from tuning table file, return false if file can not
+    //! be opened or has a malformed line. Parameters are only changed if the
+    //! whole file is valid, parameters not in file keep their value
+    bool LoadTuningFile(const char* path);
+    //! Save parameters to tuning table file, return false if it fails
+    bool SaveTuningFile(const char* path) const;
+};
+
+//! Get selector used by rccl collectives. It is created on first use and
+//! loads tuning table pointed by RCCL_TUNING_FILE environment variable.
+//! RCCL_NCHANNELS environment variable overrides number of channels and
+//! RCCL_PUSH (0 or 1) overrides push mode
+RcclAlgoSelector_t& RcclGetAlgoSelector();
+
+//! Get collective from its name (for example, "allreduce"), return
+//! krccl_num_colls if name is not recognized
+
+//! \param [in] name Name of the collective
+RcclCollective_t RcclGetCollectiveFromName(const char* name);
+
+//! Get topology from its name (for example, "xgmi"), return krccl_num_topos
+//! if name is nullptr or not recognized
+
+//! \param [in] name Name of the topology
+RcclTopology_t RcclGetTopologyFromName(const char* name);
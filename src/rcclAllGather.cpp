@@ -11,11 +11,14 @@ All rights reserved.
  *
  */
 
+#include "rcclAlgoSelector.h"
 #include "rcclDataTypes.h"
+#include "rcclGroup.h"
 #include "rcclHelper.h"
 #include "rcclSetKernels.h"
 #include "rcclTracker.h"
 
+#include "rcclRingAllGatherRuntime.h"
 #include "rcclScalarAllGatherRuntime.h"
 
 #include <string>
@@ -24,8 +27,78 @@ All rights reserved.
 extern std::unordered_map<int, std::string> umap_datatype;
 
 extern int RCCL_TRACE_RT;
+extern RcclAlgo_t RCCL_ALGO;
+
+//! @brief Definition of RcclAllGatherAlgo
+//! Launch rcclAllGather on current gpu using algorithm algo
+template <typename DataType_t, typename VectorType_t>
+void RcclAllGatherAlgo(RcclAlgo_t algo, RcclComm_t *pcomm, const void *sendbuff,
+                       void *recvbuff, hipStream_t stream, int count) {
+    RcclCommSlot_t *pslot = pcomm->slot_;
+    switch (algo) {
+    case krccl_algo_ring: {
+        RcclInternalAllGatherRing<DataType_t, VectorType_t>(
+            pcomm->pool_, pslot->track_, sendbuff, recvbuff, stream, count,
+            pcomm->num_devices_, pcomm->rank_,
+            RcclGetAlgoSelector().GetNumChannels(pcomm->pool_->GetTopology()),
+            pslot->event_, &(pslot->this_time_));
+        break;
+    }
+    default: {
+        RcclInternalAllGather<DataType_t, VectorType_t>(
+            pslot->track_, sendbuff, recvbuff, stream, count,
+            pcomm->num_devices_, pcomm->rank_,
+            RcclGetAlgoSelector().GetPush(pcomm->pool_->GetTopology()),
+            &(pslot->this_time_));
+        break;
+    }
+    }
+}
+
+//! @brief Definition of RcclGetAllGatherLauncher
+//! Get RcclAllGatherAlgo for data type, nullptr if data type is not valid
+RcclLauncher_t RcclGetAllGatherLauncher(rcclDataType_t datatype) {
+    switch (datatype) {
+    case rcclChar: {
+        return RcclAllGatherAlgo<signed char, rccl_char16_t>;
+    }
+    case rcclUchar: {
+        return RcclAllGatherAlgo<unsigned char, rccl_uchar16_t>;
+    }
+    case rcclShort: {
+        return RcclAllGatherAlgo<signed short, rccl_short8_t>;
+    }
+    case rcclUshort: {
+        return RcclAllGatherAlgo<unsigned short, rccl_ushort8_t>;
+    }
+    case rcclHalf: {
+        return RcclAllGatherAlgo<__fp16, rccl_half8_t>;
+    }
+    case rcclInt: {
+        return RcclAllGatherAlgo<signed int, rccl_int4_t>;
+    }
+    case rcclUint: {
+        return RcclAllGatherAlgo<unsigned int, rccl_uint4_t>;
+    }
+    case rcclFloat: {
+        return RcclAllGatherAlgo<float, rccl_float4_t>;
+    }
+    case rcclLong: {
+        return RcclAllGatherAlgo<signed long, rccl_long2_t>;
+    }
+    case rcclUlong: {
+        return RcclAllGatherAlgo<unsigned long, rccl_ulong2_t>;
+    }
+    case rcclDouble: {
+        return RcclAllGatherAlgo<double, rccl_double2_t>;
+    }
+    default: { return nullptr; }
+    }
+}
 
 //! @brief Definition of rcclAllGather
+//! All arguments are checked before the op is recorded in a group or takes a
+//! sync slot, see rcclReduce
 rcclResult_t rcclAllGather(const void *sendbuff, int count,
                            rcclDataType_t datatype, void *recvbuff,
                            rcclComm_t comm, hipStream_t stream) {
@@ -44,8 +117,9 @@ rcclResult_t rcclAllGather(const void *sendbuff, int count,
         return rcclInvalidDevicePointer;
     }
 
-    //! Check if data type of buffers is valid or not
-    if (datatype >= rccl_NUM_TYPES) {
+    //! Get kernels for data type, nullptr if data type of buffers is not valid
+    RcclLauncher_t launcher = RcclGetAllGatherLauncher(datatype);
+    if (launcher == nullptr) {
         return rcclInvalidType;
     }
 
@@ -57,131 +131,112 @@ rcclResult_t rcclAllGather(const void *sendbuff, int count,
         return rcclInvalidArgument;
     }
 
-    int rank = pcomm->rank_;
     int num_gpus = pcomm->num_devices_;
-    hipEvent_t event = pcomm->event_;
 
-    //! Get pointer to current barrier
-    int *this_time = &(pcomm->this_time_);
+    //! Inside a group, the op is launched by rcclGroupEnd
+    if (RcclGroupActive()) {
+        RcclGroupAdd({krccl_coll_allgather, sendbuff, recvbuff, count, datatype,
+                      rcclSum, 0, pcomm, stream, nullptr, false});
+        return rcclSuccess;
+    }
 
     //! If same comm is used on a different stream, synchronize it with current
     //! stream before launching op.
     PreEnqueueEventRecord(pcomm, stream);
 
-    //! Get tracker to current gpu
-    RingNode_t *pcurr_track = pcomm->track_;
+    //! Buffers which are registered and already published need not be
+    //! published again
+    size_t bytes = count * RcclGetDataTypeSize(datatype);
+    SetRegisteredBuffers(pcomm, sendbuff, bytes, recvbuff, bytes * num_gpus);
 
     //! If the number of gpus equal to 1, do a simple memory copy
     if (num_gpus == 1) {
-        switch (datatype) {
-        case rcclChar:
-        case rcclUchar: {
-            hipMemcpyAsync(recvbuff, sendbuff, count * sizeof(char),
-                           hipMemcpyDeviceToDevice, stream);
-            break;
-        }
-        case rcclShort:
-        case rcclUshort:
-        case rcclHalf: {
-            hipMemcpyAsync(recvbuff, sendbuff, count * sizeof(short),
-                           hipMemcpyDeviceToDevice, stream);
-            break;
-        }
-        case rcclInt:
-        case rcclUint:
-        case rcclFloat: {
-            hipMemcpyAsync(recvbuff, sendbuff, count * sizeof(int),
-                           hipMemcpyDeviceToDevice, stream);
-            break;
-        }
-        case rcclLong:
-        case rcclUlong:
-        case rcclDouble: {
-            hipMemcpyAsync(recvbuff, sendbuff, count * sizeof(double),
-                           hipMemcpyDeviceToDevice, stream);
-            break;
-        }
-        default: { return rcclInvalidType; }
-        }
-
-        //! Track current stream so that op launched on different stream can be
-        //! synchronized with current stream
-        PostEnqueueEventRecord(pcomm, stream);
-        return rcclSuccess;
+        hipMemcpyAsync(recvbuff, sendbuff, bytes, hipMemcpyDeviceToDevice,
+                       stream);
+    } else {
+        //! Every gpu in the clique must use the same algorithm, so the choice
+        //! can only depend on values which are same across the gpus
+        RcclAlgo_t algo = RcclGetAlgoSelector().Select(
+            krccl_coll_allgather, RcclGetDataTypeSize(datatype), count,
+            num_gpus, pcomm->pool_->GetTopology(), RCCL_ALGO);
+        launcher(algo, pcomm, sendbuff, recvbuff, stream, count);
     }
 
-    switch (datatype) {
-    case rcclChar: {
-        RcclInternalAllGather<signed char, rccl_char16_t>(
-            pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-            event, this_time);
-        break;
-    }
-    case rcclUchar: {
-        RcclInternalAllGather<unsigned char, rccl_uchar16_t>(
-            pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-            event, this_time);
-        break;
-    }
-    case rcclShort: {
-        RcclInternalAllGather<signed short, rccl_short8_t>(
-            pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-            event, this_time);
-        break;
-    }
-    case rcclUshort: {
-        RcclInternalAllGather<unsigned short, rccl_ushort8_t>(
-            pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-            event, this_time);
-        break;
-    }
-    case rcclHalf: {
-        RcclInternalAllGather<__fp16, rccl_half8_t>(
-            pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-            event, this_time);
-        break;
+    //! Track current stream so that op launched on different stream can be
+    //! synchronized with current stream
+    PostEnqueueEventRecord(pcomm, stream);
+    return rcclSuccess;
+}
+
+//! @brief Definition of rcclAllGather64
+rcclResult_t rcclAllGather64(const void *sendbuff, size_t count,
+                             rcclDataType_t datatype, void *recvbuff,
+                             rcclComm_t comm, hipStream_t stream) {
+    if ((RCCL_TRACE_RT & krccl_print_api) == krccl_print_api) {
+        fprintf(stderr,
+                "%s<<rccl-api:%s sendbuff:%p count:%zu datatype:%s "
+                "recvbuff:%p comm:%p stream:%p%s\n",
+                API_COLOR, __func__, sendbuff, count,
+                umap_datatype[datatype].c_str(), recvbuff, comm, stream,
+                API_COLOR_END);
     }
-    case rcclInt: {
-        RcclInternalAllGather<signed int, rccl_int4_t>(
-            pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-            event, this_time);
-        break;
+
+    //! Kernels address slots past 2^31 elements, so a slot up to
+    //! kmax_chunk_count elements is gathered by a single op
+    if (count <= kmax_chunk_count) {
+        return rcclAllGather(sendbuff, static_cast<int>(count), datatype,
+                             recvbuff, comm, stream);
     }
-    case rcclUint: {
-        RcclInternalAllGather<unsigned int, rccl_uint4_t>(
-            pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-            event, this_time);
-        break;
+
+    //! Check arguments used before launching chunks
+    if (sendbuff == nullptr || recvbuff == nullptr) {
+        return rcclInvalidDevicePointer;
     }
-    case rcclFloat: {
-        RcclInternalAllGather<float, rccl_float4_t>(
-            pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-            event, this_time);
-        break;
+    size_t type_size = RcclGetDataTypeSize(datatype);
+    if (type_size == 0) {
+        return rcclInvalidType;
     }
-    case rcclLong: {
-        RcclInternalAllGather<signed long, rccl_long2_t>(
-            pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-            event, this_time);
-        break;
+    if (comm == nullptr) {
+        return rcclInvalidArgument;
     }
-    case rcclUlong: {
-        RcclInternalAllGather<unsigned long, rccl_ulong2_t>(
-            pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-            event, this_time);
-        break;
+
+    //! Copy of own slot below is not an op which can be recorded in a group,
+    //! it would run before broadcasts recorded in the group
+    if (RcclGroupActive()) {
+        return rcclInvalidArgument;
     }
-    case rcclDouble: {
-        RcclInternalAllGather<double, rccl_double2_t>(
-            pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-            event, this_time);
-        break;
+
+    RcclComm_t *pcomm = comm;
+    int rank = pcomm->rank_;
+
+    //! Every gpu broadcasts chunks of its slot from its source buffer, the
+    //! same ops are made on all gpus as count is same
+    size_t offset = 0;
+    while (offset < count) {
+        int chunk_count =
+            static_cast<int>(std::min(count - offset, kmax_chunk_count));
+        for (int root = 0; root < pcomm->num_devices_; root++) {
+            void *buff =
+                root == rank
+                    ? RcclOffsetPtr(sendbuff, offset * type_size)
+                    : RcclOffsetPtr(recvbuff, (root * count + offset) *
+                                                  type_size);
+            rcclResult_t result =
+                rcclBcast(buff, chunk_count, datatype, root, comm, stream);
+            if (result != rcclSuccess) {
+                return result;
+            }
+        }
+        offset += chunk_count;
     }
-    default: { return rcclInvalidType; }
+
+    //! Broadcasts do not write slot of current gpu
+    void *own_slot = RcclOffsetPtr(recvbuff, rank * count * type_size);
+    if (own_slot != sendbuff &&
+        hipMemcpyAsync(own_slot, sendbuff, count * type_size,
+                       hipMemcpyDeviceToDevice, stream) != hipSuccess) {
+        return rcclUnhandledHipError;
     }
 
-    //! Track current stream so that op launched on different stream can be
-    //! synchronized with current stream
-    PostEnqueueEventRecord(pcomm, stream);
     return rcclSuccess;
 }
@@ -12,36 +12,205 @@ All rights reserved.
  * @author Aditya Atluri
  */
 
+#include "rcclAlgoSelector.h"
 #include "rcclDataTypes.h"
+#include "rcclGroup.h"
 #include "rcclHelper.h"
+#include "rcclPlan.h"
 #include "rcclSetKernels.h"
 #include "rcclTracker.h"
 
+#include "rcclMultiAllReduceRuntime.h"
+#include "rcclOneShotAllReduceRuntime.h"
+#include "rcclRhdAllReduceRuntime.h"
+#include "rcclRingAllReduceRuntime.h"
 #include "rcclScalarAllReduceRuntime.h"
+#include "rcclTreeAllReduceRuntime.h"
 
+#include <climits>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 extern std::unordered_map<int, std::string> umap_red_op;
 extern std::unordered_map<int, std::string> umap_datatype;
 
 extern int RCCL_TRACE_RT;
+extern RcclAlgo_t RCCL_ALGO;
 
-//! @brief Definition of rcclAllReduce
-rcclResult_t rcclAllReduce(const void *sendbuff, void *recvbuff, int count,
-                           rcclDataType_t datatype, rcclRedOp_t op,
-                           rcclComm_t comm, hipStream_t stream) {
-    if ((RCCL_TRACE_RT & krccl_print_api) == krccl_print_api) {
-        int dev;
-        hipGetDevice(&dev);
-        fprintf(stderr,
-                "%s<<rccl-api:%s rccl-device:%d sendbuff:%p recvbuff:%p "
-                "count:%d datatype:%s op:%s comm:%p stream:%p%s\n",
-                API_COLOR, __func__, dev, sendbuff, recvbuff, count,
-                umap_datatype[datatype].c_str(), umap_red_op[op].c_str(), comm,
-                stream, API_COLOR_END);
+//! @brief Definition of RcclAllReduceMesh
+//! Launch mesh allreduce on current gpu, with kernels unrolled for NumGpus
+//! gpus if it is not 0. pconfig is launch configuration computed by a plan,
+//! or nullptr
+template <typename DataType_t, typename VectorType_t, rcclRedOp_t Op,
+          int NumGpus>
+void RcclAllReduceMesh(RcclComm_t *pcomm, const void *sendbuff, void *recvbuff,
+                       hipStream_t stream, int count,
+                       const RcclAllReduceConfig_t *pconfig) {
+    RcclCommSlot_t *pslot = pcomm->slot_;
+    RcclInternalAllReduce<DataType_t, VectorType_t, Op, NumGpus>(
+        pslot->track_, sendbuff, recvbuff, stream, count, pcomm->num_devices_,
+        pcomm->rank_,
+        RcclGetAlgoSelector().GetPush(pcomm->pool_->GetTopology()),
+        &(pslot->this_time_), pconfig);
+}
+
+//! @brief Definition of RcclAllReduceAlgo
+//! Launch rcclAllReduce on current gpu using algorithm algo. Algorithms use
+//! launch configuration pconfig of the sync slot if it is not nullptr
+template <typename DataType_t, typename VectorType_t, rcclRedOp_t Op>
+void RcclAllReduceAlgo(RcclAlgo_t algo, RcclComm_t *pcomm, const void *sendbuff,
+                       void *recvbuff, hipStream_t stream, int count,
+                       const RcclAllReduceAlgoConfig_t *palgo_config) {
+    RcclCommSlot_t *pslot = pcomm->slot_;
+    bool planned = palgo_config != nullptr;
+    switch (algo) {
+    case krccl_algo_ring: {
+        RcclInternalAllReduceRing<DataType_t, VectorType_t, Op>(
+            pcomm->pool_, pslot->track_, sendbuff, recvbuff, stream, count,
+            pcomm->num_devices_, pcomm->rank_,
+            RcclGetAlgoSelector().GetNumChannels(pcomm->pool_->GetTopology()),
+            &(pslot->p2p_time_), planned ? &(palgo_config->ring) : nullptr);
+        break;
+    }
+    case krccl_algo_tree: {
+        RcclInternalAllReduceTree<DataType_t, VectorType_t, Op>(
+            pcomm->pool_, pslot->track_, sendbuff, recvbuff, stream, count,
+            pcomm->num_devices_, pcomm->rank_, &(pslot->p2p_time_),
+            planned ? &(palgo_config->tree) : nullptr);
+        break;
+    }
+    case krccl_algo_rhd: {
+        RcclInternalAllReduceRhd<DataType_t, VectorType_t, Op>(
+            pcomm->pool_, pslot->track_, sendbuff, recvbuff, stream, count,
+            pcomm->num_devices_, pcomm->rank_, &(pslot->this_time_),
+            planned ? &(palgo_config->rhd) : nullptr);
+        break;
+    }
+    case krccl_algo_oneshot: {
+        RcclInternalAllReduceOneShot<DataType_t, VectorType_t, Op>(
+            pslot->track_, sendbuff, recvbuff, pslot->scratch_, stream,
+            count, pcomm->num_devices_, &(pslot->this_time_),
+            planned ? &(palgo_config->oneshot) : nullptr);
+        break;
+    }
+    default: {
+        const RcclAllReduceConfig_t *pconfig =
+            planned ? &(palgo_config->mesh) : nullptr;
+        //! Use kernels specialized on number of gpus in clique if there are
+        //! any, generic ones otherwise
+        switch (pcomm->num_devices_) {
+        case 2: {
+            RcclAllReduceMesh<DataType_t, VectorType_t, Op, 2>(
+                pcomm, sendbuff, recvbuff, stream, count, pconfig);
+            break;
+        }
+        case 3: {
+            RcclAllReduceMesh<DataType_t, VectorType_t, Op, 3>(
+                pcomm, sendbuff, recvbuff, stream, count, pconfig);
+            break;
+        }
+        case 4: {
+            RcclAllReduceMesh<DataType_t, VectorType_t, Op, 4>(
+                pcomm, sendbuff, recvbuff, stream, count, pconfig);
+            break;
+        }
+        case 6: {
+            RcclAllReduceMesh<DataType_t, VectorType_t, Op, 6>(
+                pcomm, sendbuff, recvbuff, stream, count, pconfig);
+            break;
+        }
+        case 8: {
+            RcclAllReduceMesh<DataType_t, VectorType_t, Op, 8>(
+                pcomm, sendbuff, recvbuff, stream, count, pconfig);
+            break;
+        }
+        case 16: {
+            RcclAllReduceMesh<DataType_t, VectorType_t, Op, 16>(
+                pcomm, sendbuff, recvbuff, stream, count, pconfig);
+            break;
+        }
+        default: {
+            RcclAllReduceMesh<DataType_t, VectorType_t, Op, 0>(
+                pcomm, sendbuff, recvbuff, stream, count, pconfig);
+            break;
+        }
+        }
+        break;
+    }
+    }
+}
+
+//! @brief Definition of RcclGetAllReduceLauncher
+//! Get RcclAllReduceAlgo for data type with reduction op Op, nullptr if data
+//! type is not valid
+template <rcclRedOp_t Op>
+RcclAllReduceLauncher_t RcclGetAllReduceLauncher(rcclDataType_t datatype) {
+    switch (datatype) {
+    case rcclChar: {
+        return RcclAllReduceAlgo<signed char, rccl_char16_t, Op>;
+    }
+    case rcclUchar: {
+        return RcclAllReduceAlgo<unsigned char, rccl_uchar16_t, Op>;
+    }
+    case rcclShort: {
+        return RcclAllReduceAlgo<signed short, rccl_short8_t, Op>;
     }
+    case rcclUshort: {
+        return RcclAllReduceAlgo<unsigned short, rccl_ushort8_t, Op>;
+    }
+    case rcclHalf: {
+        return RcclAllReduceAlgo<__fp16, rccl_half8_t, Op>;
+    }
+    case rcclInt: {
+        return RcclAllReduceAlgo<signed int, rccl_int4_t, Op>;
+    }
+    case rcclUint: {
+        return RcclAllReduceAlgo<unsigned int, rccl_uint4_t, Op>;
+    }
+    case rcclFloat: {
+        return RcclAllReduceAlgo<float, rccl_float4_t, Op>;
+    }
+    case rcclLong: {
+        return RcclAllReduceAlgo<signed long, rccl_long2_t, Op>;
+    }
+    case rcclUlong: {
+        return RcclAllReduceAlgo<unsigned long, rccl_ulong2_t, Op>;
+    }
+    case rcclDouble: {
+        return RcclAllReduceAlgo<double, rccl_double2_t, Op>;
+    }
+    default: { return nullptr; }
+    }
+}
 
+//! @brief Definition of RcclGetAllReduceLauncher
+//! Get RcclAllReduceAlgo for data type and reduction op, nullptr if any of
+//! them is not valid
+RcclAllReduceLauncher_t RcclGetAllReduceLauncher(rcclDataType_t datatype,
+                                        rcclRedOp_t op) {
+    switch (op) {
+    case rcclSum: {
+        return RcclGetAllReduceLauncher<rcclSum>(datatype);
+    }
+    case rcclProd: {
+        return RcclGetAllReduceLauncher<rcclProd>(datatype);
+    }
+    case rcclMax: {
+        return RcclGetAllReduceLauncher<rcclMax>(datatype);
+    }
+    case rcclMin: {
+        return RcclGetAllReduceLauncher<rcclMin>(datatype);
+    }
+    default: { return nullptr; }
+    }
+}
+
+//! @brief Definition of RcclCheckAllReduceArgs
+//! Check arguments of rcclAllReduce
+rcclResult_t RcclCheckAllReduceArgs(const void *sendbuff, void *recvbuff,
+                                    int count, rcclDataType_t datatype,
+                                    rcclRedOp_t op, rcclComm_t comm) {
     //! Check if buffer pointers are not null
     if (sendbuff == nullptr || recvbuff == nullptr) {
         return rcclInvalidDevicePointer;
@@ -57,357 +226,576 @@ rcclResult_t rcclAllReduce(const void *sendbuff, void *recvbuff, int count,
         return rcclInvalidOperation;
     }
 
-    //! Get internal communicator from rcclComm_t
-    RcclComm_t *pcomm = comm;
-
     //! Check if communicator is valid or number of elements is > 0
-    if (pcomm == nullptr || count <= 0) {
+    if (comm == nullptr || count <= 0) {
         return rcclInvalidArgument;
     }
 
-    int rank = pcomm->rank_;
-    int num_gpus = pcomm->num_devices_;
-    hipEvent_t event = pcomm->event_;
+    return rcclSuccess;
+}
 
-    //! Get pointer to current barrier
-    int *this_time = &(pcomm->this_time_);
+//! @brief Definition of RcclSelectAllReduceAlgo
+//! Every gpu in the clique must use the same algorithm, so the choice can
+//! only depend on values which are same across the gpus
+RcclAlgo_t RcclSelectAllReduceAlgo(RcclComm_t *pcomm, rcclDataType_t datatype,
+                                   int count) {
+    return RcclGetAlgoSelector().Select(
+        krccl_coll_allreduce, RcclGetDataTypeSize(datatype), count,
+        pcomm->num_devices_, pcomm->pool_->GetTopology(), RCCL_ALGO);
+}
+
+//! @brief Definition of RcclGetAllReduceAlgoConfig
+//! Compute launch configuration of algorithm algo of rcclAllReduce for sync
+//! slot slot of current gpu, with elements of type_size bytes. Peers are taken
+//! from RingNodePool_t::pool_, so all gpus of the clique must have joined it
+void RcclGetAllReduceAlgoConfig(RcclComm_t *pcomm, RcclAlgo_t algo,
+                                const void *sendbuff, const void *recvbuff,
+                                int count, size_t type_size, int slot,
+                                RcclAllReduceAlgoConfig_t *pconfig) {
+    RingNode_t *pcurr_track = pcomm->slots_[slot].track_;
+    RcclTopology_t topology = pcomm->pool_->GetTopology();
+    switch (algo) {
+    case krccl_algo_ring: {
+        RcclGetRingAllReduceConfig(
+            pcomm->pool_, pcurr_track, count, type_size, pcomm->num_devices_,
+            pcomm->rank_, RcclGetAlgoSelector().GetNumChannels(topology),
+            &(pconfig->ring));
+        break;
+    }
+    case krccl_algo_tree: {
+        RcclGetTreeAllReduceConfig(pcomm->pool_, pcurr_track, count, type_size,
+                                   pcomm->num_devices_, pcomm->rank_,
+                                   &(pconfig->tree));
+        break;
+    }
+    case krccl_algo_rhd: {
+        RcclGetRhdAllReduceConfig(pcomm->pool_, pcurr_track, count,
+                                  pcomm->num_devices_, pcomm->rank_,
+                                  &(pconfig->rhd));
+        break;
+    }
+    case krccl_algo_oneshot: {
+        RcclGetOneShotAllReduceConfig(pcurr_track, count, type_size,
+                                      &(pconfig->oneshot));
+        break;
+    }
+    default: {
+        RcclGetAllReduceConfig(pcurr_track, sendbuff, recvbuff, count,
+                               type_size, pcomm->num_devices_, pcomm->rank_,
+                               RcclGetAlgoSelector().GetPush(topology),
+                               &(pconfig->mesh));
+        break;
+    }
+    }
+    pconfig->ready = true;
+}
 
+//! @brief Definition of RcclEnqueueAllReduce
+//! Launch rcclAllReduce with checked arguments on stream. If fixed_buffers is
+//! set, buffers are treated as registered (see rcclCommRegister). pconfig is
+//! launch configuration computed by a plan for the sync slot the op is
+//! launched on, or nullptr
+void RcclEnqueueAllReduce(RcclComm_t *pcomm, RcclAllReduceLauncher_t launcher,
+                          RcclAlgo_t algo, const void *sendbuff,
+                          void *recvbuff, int count, size_t bytes,
+                          bool fixed_buffers,
+                          const RcclAllReduceAlgoConfig_t *pconfig,
+                          hipStream_t stream) {
     //! If same comm is used on a different stream, synchronize it with current
     //! stream before launching op.
     PreEnqueueEventRecord(pcomm, stream);
 
-    //! Get tracker to current gpu
-    RingNode_t *pcurr_track = pcomm->track_;
+    //! Buffers which are registered and already published need not be
+    //! published again
+    if (fixed_buffers) {
+        pcomm->slot_->track_->registered = true;
+    } else {
+        SetRegisteredBuffers(pcomm, sendbuff, bytes, recvbuff, bytes);
+    }
 
     //! If the number of gpus equal to 1, do a simple memory copy
-    if (num_gpus == 1) {
-        switch (datatype) {
-        case rcclChar:
-        case rcclUchar: {
-            hipMemcpyAsync(recvbuff, sendbuff, count * sizeof(char),
-                           hipMemcpyDeviceToDevice, stream);
-            break;
-        }
-        case rcclShort:
-        case rcclUshort:
-        case rcclHalf: {
-            hipMemcpyAsync(recvbuff, sendbuff, count * sizeof(short),
-                           hipMemcpyDeviceToDevice, stream);
-            break;
-        }
-        case rcclInt:
-        case rcclUint:
-        case rcclFloat: {
-            hipMemcpyAsync(recvbuff, sendbuff, count * sizeof(int),
-                           hipMemcpyDeviceToDevice, stream);
-            break;
-        }
-        case rcclLong:
-        case rcclUlong:
-        case rcclDouble: {
-            hipMemcpyAsync(recvbuff, sendbuff, count * sizeof(double),
-                           hipMemcpyDeviceToDevice, stream);
-            break;
-        }
-        default: { return rcclInvalidType; }
-        }
+    if (pcomm->num_devices_ == 1) {
+        hipMemcpyAsync(recvbuff, sendbuff, bytes, hipMemcpyDeviceToDevice,
+                       stream);
+    } else {
+        launcher(algo, pcomm, sendbuff, recvbuff, stream, count, pconfig);
+    }
+
+    //! Track current stream so that op launched on different stream can be
+    //! synchronized with current stream
+    PostEnqueueEventRecord(pcomm, stream);
+}
+
+//! @brief Definition of rcclAllReduce
+rcclResult_t rcclAllReduce(const void *sendbuff, void *recvbuff, int count,
+                           rcclDataType_t datatype, rcclRedOp_t op,
+                           rcclComm_t comm, hipStream_t stream) {
+    if ((RCCL_TRACE_RT & krccl_print_api) == krccl_print_api) {
+        int dev;
+        hipGetDevice(&dev);
+        fprintf(stderr,
+                "%s<<rccl-api:%s rccl-device:%d sendbuff:%p recvbuff:%p "
+                "count:%d datatype:%s op:%s comm:%p stream:%p%s\n",
+                API_COLOR, __func__, dev, sendbuff, recvbuff, count,
+                umap_datatype[datatype].c_str(), umap_red_op[op].c_str(), comm,
+                stream, API_COLOR_END);
+    }
 
-        //! Track current stream so that op launched on different stream can be
-        //! synchronized with current stream
-        PostEnqueueEventRecord(pcomm, stream);
+    rcclResult_t result =
+        RcclCheckAllReduceArgs(sendbuff, recvbuff, count, datatype, op, comm);
+    if (result != rcclSuccess) {
+        return result;
+    }
+
+    //! Inside a group, the op is launched by rcclGroupEnd
+    if (RcclGroupActive()) {
+        RcclGroupAdd({krccl_coll_allreduce, sendbuff, recvbuff, count, datatype,
+                      op, 0, comm, stream, nullptr, false});
         return rcclSuccess;
     }
 
-    //! Check which op to launch
-    if (op == rcclSum) {
-        switch (datatype) {
-        case rcclChar: {
-            RcclInternalAllReduce<signed char, rccl_char16_t, rcclSum>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclUchar: {
-            RcclInternalAllReduce<unsigned char, rccl_uchar16_t, rcclSum>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclShort: {
-            RcclInternalAllReduce<signed short, rccl_short8_t, rcclSum>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclUshort: {
-            RcclInternalAllReduce<unsigned short, rccl_ushort8_t, rcclSum>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclHalf: {
-            RcclInternalAllReduce<__fp16, rccl_half8_t, rcclSum>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclInt: {
-            RcclInternalAllReduce<signed int, rccl_int4_t, rcclSum>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclUint: {
-            RcclInternalAllReduce<unsigned int, rccl_uint4_t, rcclSum>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclFloat: {
-            RcclInternalAllReduce<float, rccl_float4_t, rcclSum>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclLong: {
-            RcclInternalAllReduce<signed long, rccl_long2_t, rcclSum>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclUlong: {
-            RcclInternalAllReduce<unsigned long, rccl_ulong2_t, rcclSum>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclDouble: {
-            RcclInternalAllReduce<double, rccl_double2_t, rcclSum>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        default: { return rcclInvalidType; }
-        }
+    //! Get internal communicator from rcclComm_t
+    RcclComm_t *pcomm = comm;
+
+    RcclEnqueueAllReduce(pcomm, RcclGetAllReduceLauncher(datatype, op),
+                         RcclSelectAllReduceAlgo(pcomm, datatype, count),
+                         sendbuff, recvbuff, count,
+                         count * RcclGetDataTypeSize(datatype), false,
+                         nullptr, stream);
+    return rcclSuccess;
+}
+
+//! @brief Launch rcclAllReduceMulti on current gpu, with kernels of a data
+//! type and reduction op
+typedef void (*RcclMultiLauncher_t)(RcclComm_t *pcomm, int num_tensors,
+                                    int max_count, hipStream_t stream);
+
+//! @brief Definition of RcclAllReduceMultiOnGpu
+//! Launch rcclAllReduceMulti on current gpu once table of tensors is in
+//! RcclCommSlot_t::tensors_ of the slot. Kernels are unrolled for number of
+//! gpus if there is a specialization for it
+template <typename DataType_t, typename VectorType_t, rcclRedOp_t Op>
+void RcclAllReduceMultiOnGpu(RcclComm_t *pcomm, int num_tensors, int max_count,
+                             hipStream_t stream) {
+    RcclCommSlot_t *pslot = pcomm->slot_;
+    switch (pcomm->num_devices_) {
+    case 2: {
+        RcclInternalAllReduceMulti<DataType_t, VectorType_t, Op, 2>(
+            pslot->track_, pslot->tensors_, num_tensors, max_count, stream,
+            pcomm->num_devices_, pcomm->rank_, pslot->event_,
+            &(pslot->this_time_));
+        break;
     }
-    if (op == rcclProd) {
-        switch (datatype) {
-        case rcclChar: {
-            RcclInternalAllReduce<signed char, rccl_char16_t, rcclProd>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclUchar: {
-            RcclInternalAllReduce<unsigned char, rccl_uchar16_t, rcclProd>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclShort: {
-            RcclInternalAllReduce<signed short, rccl_short8_t, rcclProd>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclUshort: {
-            RcclInternalAllReduce<unsigned short, rccl_ushort8_t, rcclProd>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclHalf: {
-            RcclInternalAllReduce<__fp16, rccl_half8_t, rcclProd>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclInt: {
-            RcclInternalAllReduce<signed int, rccl_int4_t, rcclProd>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclUint: {
-            RcclInternalAllReduce<unsigned int, rccl_uint4_t, rcclProd>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclFloat: {
-            RcclInternalAllReduce<float, rccl_float4_t, rcclProd>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclLong: {
-            RcclInternalAllReduce<signed long, rccl_long2_t, rcclProd>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclUlong: {
-            RcclInternalAllReduce<unsigned long, rccl_ulong2_t, rcclProd>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclDouble: {
-            RcclInternalAllReduce<double, rccl_double2_t, rcclProd>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        default: { return rcclInvalidType; }
-        }
+    case 3: {
+        RcclInternalAllReduceMulti<DataType_t, VectorType_t, Op, 3>(
+            pslot->track_, pslot->tensors_, num_tensors, max_count, stream,
+            pcomm->num_devices_, pcomm->rank_, pslot->event_,
+            &(pslot->this_time_));
+        break;
+    }
+    case 4: {
+        RcclInternalAllReduceMulti<DataType_t, VectorType_t, Op, 4>(
+            pslot->track_, pslot->tensors_, num_tensors, max_count, stream,
+            pcomm->num_devices_, pcomm->rank_, pslot->event_,
+            &(pslot->this_time_));
+        break;
+    }
+    case 6: {
+        RcclInternalAllReduceMulti<DataType_t, VectorType_t, Op, 6>(
+            pslot->track_, pslot->tensors_, num_tensors, max_count, stream,
+            pcomm->num_devices_, pcomm->rank_, pslot->event_,
+            &(pslot->this_time_));
+        break;
     }
+    case 8: {
+        RcclInternalAllReduceMulti<DataType_t, VectorType_t, Op, 8>(
+            pslot->track_, pslot->tensors_, num_tensors, max_count, stream,
+            pcomm->num_devices_, pcomm->rank_, pslot->event_,
+            &(pslot->this_time_));
+        break;
+    }
+    case 16: {
+        RcclInternalAllReduceMulti<DataType_t, VectorType_t, Op, 16>(
+            pslot->track_, pslot->tensors_, num_tensors, max_count, stream,
+            pcomm->num_devices_, pcomm->rank_, pslot->event_,
+            &(pslot->this_time_));
+        break;
+    }
+    default: {
+        RcclInternalAllReduceMulti<DataType_t, VectorType_t, Op, 0>(
+            pslot->track_, pslot->tensors_, num_tensors, max_count, stream,
+            pcomm->num_devices_, pcomm->rank_, pslot->event_,
+            &(pslot->this_time_));
+        break;
+    }
+    }
+}
 
-    if (op == rcclMax) {
-        switch (datatype) {
-        case rcclChar: {
-            RcclInternalAllReduce<signed char, rccl_char16_t, rcclMax>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclUchar: {
-            RcclInternalAllReduce<unsigned char, rccl_uchar16_t, rcclMax>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclShort: {
-            RcclInternalAllReduce<signed short, rccl_short8_t, rcclMax>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclUshort: {
-            RcclInternalAllReduce<unsigned short, rccl_ushort8_t, rcclMax>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclHalf: {
-            RcclInternalAllReduce<__fp16, rccl_half8_t, rcclMax>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclInt: {
-            RcclInternalAllReduce<signed int, rccl_int4_t, rcclMax>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclUint: {
-            RcclInternalAllReduce<unsigned int, rccl_uint4_t, rcclMax>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclFloat: {
-            RcclInternalAllReduce<float, rccl_float4_t, rcclMax>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclLong: {
-            RcclInternalAllReduce<signed long, rccl_long2_t, rcclMax>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclUlong: {
-            RcclInternalAllReduce<unsigned long, rccl_ulong2_t, rcclMax>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclDouble: {
-            RcclInternalAllReduce<double, rccl_double2_t, rcclMax>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        default: { return rcclInvalidType; }
-        }
+//! @brief Definition of RcclGetAllReduceMultiLauncher
+//! Get RcclAllReduceMultiOnGpu for data type with reduction op Op, nullptr if
+//! data type is not valid
+template <rcclRedOp_t Op>
+RcclMultiLauncher_t RcclGetAllReduceMultiLauncher(rcclDataType_t datatype) {
+    switch (datatype) {
+    case rcclChar: {
+        return RcclAllReduceMultiOnGpu<signed char, rccl_char16_t, Op>;
+    }
+    case rcclUchar: {
+        return RcclAllReduceMultiOnGpu<unsigned char, rccl_uchar16_t, Op>;
+    }
+    case rcclShort: {
+        return RcclAllReduceMultiOnGpu<signed short, rccl_short8_t, Op>;
+    }
+    case rcclUshort: {
+        return RcclAllReduceMultiOnGpu<unsigned short, rccl_ushort8_t, Op>;
+    }
+    case rcclHalf: {
+        return RcclAllReduceMultiOnGpu<__fp16, rccl_half8_t, Op>;
+    }
+    case rcclInt: {
+        return RcclAllReduceMultiOnGpu<signed int, rccl_int4_t, Op>;
+    }
+    case rcclUint: {
+        return RcclAllReduceMultiOnGpu<unsigned int, rccl_uint4_t, Op>;
+    }
+    case rcclFloat: {
+        return RcclAllReduceMultiOnGpu<float, rccl_float4_t, Op>;
+    }
+    case rcclLong: {
+        return RcclAllReduceMultiOnGpu<signed long, rccl_long2_t, Op>;
+    }
+    case rcclUlong: {
+        return RcclAllReduceMultiOnGpu<unsigned long, rccl_ulong2_t, Op>;
+    }
+    case rcclDouble: {
+        return RcclAllReduceMultiOnGpu<double, rccl_double2_t, Op>;
+    }
+    default: { return nullptr; }
+    }
+}
+
+//! @brief Definition of RcclGetAllReduceMultiLauncher
+//! Get RcclAllReduceMultiOnGpu for data type and reduction op, nullptr if any
+//! of them is not valid
+RcclMultiLauncher_t RcclGetAllReduceMultiLauncher(rcclDataType_t datatype,
+                                                  rcclRedOp_t op) {
+    switch (op) {
+    case rcclSum: {
+        return RcclGetAllReduceMultiLauncher<rcclSum>(datatype);
+    }
+    case rcclProd: {
+        return RcclGetAllReduceMultiLauncher<rcclProd>(datatype);
+    }
+    case rcclMax: {
+        return RcclGetAllReduceMultiLauncher<rcclMax>(datatype);
+    }
+    case rcclMin: {
+        return RcclGetAllReduceMultiLauncher<rcclMin>(datatype);
     }
+    default: { return nullptr; }
+    }
+}
 
-    if (op == rcclMin) {
-        switch (datatype) {
-        case rcclChar: {
-            RcclInternalAllReduce<signed char, rccl_char16_t, rcclMin>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclUchar: {
-            RcclInternalAllReduce<unsigned char, rccl_uchar16_t, rcclMin>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclShort: {
-            RcclInternalAllReduce<signed short, rccl_short8_t, rcclMin>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclUshort: {
-            RcclInternalAllReduce<unsigned short, rccl_ushort8_t, rcclMin>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclHalf: {
-            RcclInternalAllReduce<__fp16, rccl_half8_t, rcclMin>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclInt: {
-            RcclInternalAllReduce<signed int, rccl_int4_t, rcclMin>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclUint: {
-            RcclInternalAllReduce<unsigned int, rccl_uint4_t, rcclMin>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclFloat: {
-            RcclInternalAllReduce<float, rccl_float4_t, rcclMin>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclLong: {
-            RcclInternalAllReduce<signed long, rccl_long2_t, rcclMin>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclUlong: {
-            RcclInternalAllReduce<unsigned long, rccl_ulong2_t, rcclMin>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
-        }
-        case rcclDouble: {
-            RcclInternalAllReduce<double, rccl_double2_t, rcclMin>(
-                pcurr_track, sendbuff, recvbuff, stream, count, num_gpus, rank,
-                event, this_time);
-            break;
+//! @brief Definition of RcclReserveTensors
+//! Make sure table of tensors of the slot holds at least num_tensors entries.
+//! hipFree waits for the gpu, so peers are done with the old table. Returns
+//! false if the table can not be allocated
+bool RcclReserveTensors(RcclCommSlot_t *pslot, int num_tensors) {
+    if (pslot->max_tensors_ >= num_tensors) {
+        return true;
+    }
+    if (pslot->tensors_ != nullptr) {
+        HIPCHECK(hipFree(pslot->tensors_));
+    }
+    pslot->tensors_ = nullptr;
+    pslot->max_tensors_ = 0;
+    if (hipMalloc(&(pslot->tensors_), num_tensors * sizeof(RcclTensor_t)) !=
+        hipSuccess) {
+        pslot->tensors_ = nullptr;
+        return false;
+    }
+    pslot->max_tensors_ = num_tensors;
+    return true;
+}
+
+//! @brief Definition of RcclGetTensorStage
+//! Get a pinned host table of the slot holding at least num_tensors entries
+//! whose previous copy to the gpu is done, adding one if there is none. The
+//! host does not wait for the gpu, which may only finish previous ops once
+//! peers launched them. Returns nullptr if the table can not be allocated
+RcclTensorStage_t *RcclGetTensorStage(RcclCommSlot_t *pslot,
+                                      int num_tensors) {
+    for (RcclTensorStage_t &stage : pslot->stages_) {
+        if (stage.max_tensors >= num_tensors &&
+            hipEventQuery(stage.event) == hipSuccess) {
+            return &stage;
         }
-        default: { return rcclInvalidType; }
+    }
+
+    RcclTensorStage_t stage;
+    if (hipHostMalloc(&(stage.tensors), num_tensors * sizeof(RcclTensor_t)) !=
+        hipSuccess) {
+        return nullptr;
+    }
+    if (hipEventCreateWithFlags(&(stage.event), hipEventDisableTiming) !=
+        hipSuccess) {
+        HIPCHECK(hipHostFree(stage.tensors));
+        return nullptr;
+    }
+    stage.max_tensors = num_tensors;
+    pslot->stages_.push_back(stage);
+    return &(pslot->stages_.back());
+}
+
+//! @brief Definition of rcclAllReduceMulti
+rcclResult_t rcclAllReduceMulti(const void **sendbuffs, void **recvbuffs,
+                                const size_t *counts, int ntensors,
+                                rcclDataType_t datatype, rcclRedOp_t op,
+                                rcclComm_t comm, hipStream_t stream) {
+    if ((RCCL_TRACE_RT & krccl_print_api) == krccl_print_api) {
+        int dev;
+        hipGetDevice(&dev);
+        fprintf(stderr,
+                "%s<<rccl-api:%s rccl-device:%d sendbuffs:%p recvbuffs:%p "
+                "counts:%p ntensors:%d datatype:%s op:%s comm:%p stream:%p%s\n",
+                API_COLOR, __func__, dev, sendbuffs, recvbuffs, counts,
+                ntensors, umap_datatype[datatype].c_str(),
+                umap_red_op[op].c_str(), comm, stream, API_COLOR_END);
+    }
+
+    //! Check if arrays describing tensors are valid
+    if (sendbuffs == nullptr || recvbuffs == nullptr || counts == nullptr ||
+        ntensors <= 0) {
+        return rcclInvalidArgument;
+    }
+
+    //! Check every tensor as rcclAllReduce does, largest tensor sizes the
+    //! grid
+    int max_count = 0;
+    for (int i = 0; i < ntensors; i++) {
+        if (counts[i] > static_cast<size_t>(INT_MAX)) {
+            return rcclInvalidArgument;
+        }
+        int count = static_cast<int>(counts[i]);
+        rcclResult_t result = RcclCheckAllReduceArgs(
+            sendbuffs[i], recvbuffs[i], count, datatype, op, comm);
+        if (result != rcclSuccess) {
+            return result;
+        }
+        max_count = std::max(max_count, count);
+    }
+
+    //! Get kernels for data type and op, both are valid once tensors are
+    //! checked
+    RcclMultiLauncher_t launcher = RcclGetAllReduceMultiLauncher(datatype, op);
+
+    //! Inside a group, the op is launched by rcclGroupEnd
+    if (RcclGroupActive()) {
+        RcclGroupOp_t gop = {krccl_coll_allreduce, nullptr, nullptr, 0,
+                             datatype, op, 0, comm, stream, nullptr, false};
+        gop.sendbuffs.assign(sendbuffs, sendbuffs + ntensors);
+        gop.recvbuffs.assign(recvbuffs, recvbuffs + ntensors);
+        gop.counts.assign(counts, counts + ntensors);
+        RcclGroupAdd(gop);
+        return rcclSuccess;
+    }
+
+    //! Get internal communicator from rcclComm_t
+    RcclComm_t *pcomm = comm;
+
+    //! Grow table of the slot the op is launched on and get a host table to
+    //! stage it in before taking the slot, so that a failed allocation leaves
+    //! slots of current gpu in step with peers
+    RcclTensorStage_t *pstage = nullptr;
+    if (pcomm->num_devices_ > 1) {
+        if (!RcclReserveTensors(pcomm->NextSlot(), ntensors)) {
+            return rcclHipMallocFailed;
+        }
+        pstage = RcclGetTensorStage(pcomm->NextSlot(), ntensors);
+        if (pstage == nullptr) {
+            return rcclHipMallocFailed;
         }
     }
 
+    //! If same comm is used on a different stream, synchronize it with current
+    //! stream before launching op.
+    PreEnqueueEventRecord(pcomm, stream);
+
+    if (pcomm->num_devices_ == 1) {
+        //! If the number of gpus equal to 1, do a simple memory copy
+        size_t type_size = RcclGetDataTypeSize(datatype);
+        for (int i = 0; i < ntensors; i++) {
+            if (sendbuffs[i] != recvbuffs[i]) {
+                hipMemcpyAsync(recvbuffs[i], sendbuffs[i],
+                               counts[i] * type_size, hipMemcpyDeviceToDevice,
+                               stream);
+            }
+        }
+    } else {
+        RcclCommSlot_t *pslot = pcomm->slot_;
+
+        RcclTensor_t *tensors = pstage->tensors;
+        for (int i = 0; i < ntensors; i++) {
+            tensors[i].src_buffer = sendbuffs[i];
+            tensors[i].dst_buffer = recvbuffs[i];
+            tensors[i].count = static_cast<int>(counts[i]);
+        }
+        hipMemcpyAsync(pslot->tensors_, tensors,
+                       ntensors * sizeof(RcclTensor_t), hipMemcpyHostToDevice,
+                       stream);
+        HIPCHECK(hipEventRecord(pstage->event, stream));
+
+        launcher(pcomm, ntensors, max_count, stream);
+    }
+
     //! Track current stream so that op launched on different stream can be
     //! synchronized with current stream
     PostEnqueueEventRecord(pcomm, stream);
     return rcclSuccess;
 }
+
+//! @brief Definition of rcclAllReducePlanCreate
+rcclResult_t rcclAllReducePlanCreate(const void *sendbuff, void *recvbuff,
+                                     int count, rcclDataType_t datatype,
+                                     rcclRedOp_t op, rcclComm_t comm,
+                                     rcclPlan_t *plan) {
+    if ((RCCL_TRACE_RT & krccl_print_api) == krccl_print_api) {
+        fprintf(stderr,
+                "%s<<rccl-api:%s sendbuff:%p recvbuff:%p count:%d datatype:%s "
+                "op:%s comm:%p plan:%p%s\n",
+                API_COLOR, __func__, sendbuff, recvbuff, count,
+                umap_datatype[datatype].c_str(), umap_red_op[op].c_str(), comm,
+                plan, API_COLOR_END);
+    }
+
+    if (plan == nullptr) {
+        return rcclInvalidArgument;
+    }
+
+    rcclResult_t result =
+        RcclCheckAllReduceArgs(sendbuff, recvbuff, count, datatype, op, comm);
+    if (result != rcclSuccess) {
+        return result;
+    }
+
+    RcclPlan_t *pplan = new RcclPlan_t();
+    pplan->comm_ = comm;
+    pplan->sendbuff_ = sendbuff;
+    pplan->recvbuff_ = recvbuff;
+    pplan->count_ = count;
+    pplan->type_size_ = RcclGetDataTypeSize(datatype);
+    pplan->bytes_ = count * pplan->type_size_;
+    pplan->algo_ = RcclSelectAllReduceAlgo(comm, datatype, count);
+    pplan->launcher_ = RcclGetAllReduceLauncher(datatype, op);
+
+    //! Splits, grids, kernel variants and peers of the algorithm depend only
+    //! on the op and the sync slot. Peers are known once all the gpus joined
+    //! the pool, otherwise the configuration of a slot is computed when the
+    //! plan is first executed on it
+    RcclComm_t *pcomm = comm;
+    for (int slot = 0; slot < knum_sync_slots; slot++) {
+        pplan->configs_[slot].ready = false;
+        if (pcomm->num_devices_ > 1 &&
+            pcomm->pool_->pool_[slot].size() ==
+                static_cast<size_t>(pcomm->num_devices_)) {
+            RcclGetAllReduceAlgoConfig(pcomm, pplan->algo_, sendbuff, recvbuff,
+                                       count, pplan->type_size_, slot,
+                                       &(pplan->configs_[slot]));
+        }
+    }
+
+    *plan = pplan;
+    return rcclSuccess;
+}
+
+//! @brief Definition of rcclPlanExecute
+rcclResult_t rcclPlanExecute(rcclPlan_t plan, hipStream_t stream) {
+    if ((RCCL_TRACE_RT & krccl_print_api) == krccl_print_api) {
+        fprintf(stderr, "%s<<rccl-api:%s plan:%p stream:%p%s\n", API_COLOR,
+                __func__, plan, stream, API_COLOR_END);
+    }
+
+    if (plan == nullptr) {
+        return rcclInvalidArgument;
+    }
+
+    //! Inside a group, the op is launched by rcclGroupEnd
+    if (RcclGroupActive()) {
+        RcclGroupAdd({krccl_coll_allreduce, plan->sendbuff_, plan->recvbuff_,
+                      plan->count_, rccl_NUM_TYPES, rccl_NUM_OPS, 0,
+                      plan->comm_, stream, plan, false});
+        return rcclSuccess;
+    }
+
+    //! Op is launched on next sync slot of the communicator, compute its
+    //! launch configuration if it was not known when the plan was created
+    RcclComm_t *pcomm = plan->comm_;
+    int slot = pcomm->seq_ % knum_sync_slots;
+    RcclAllReduceAlgoConfig_t *pconfig = &(plan->configs_[slot]);
+    if (!pconfig->ready && pcomm->num_devices_ > 1) {
+        RcclGetAllReduceAlgoConfig(pcomm, plan->algo_, plan->sendbuff_,
+                                   plan->recvbuff_, plan->count_,
+                                   plan->type_size_, slot, pconfig);
+    }
+
+    //! Buffers of a plan do not change between executions, they are published
+    //! again only if another op used the sync slot in between
+    RcclEnqueueAllReduce(plan->comm_, plan->launcher_, plan->algo_,
+                         plan->sendbuff_, plan->recvbuff_, plan->count_,
+                         plan->bytes_, true, pconfig, stream);
+    return rcclSuccess;
+}
+
+//! @brief Definition of rcclPlanDestroy
+rcclResult_t rcclPlanDestroy(rcclPlan_t plan) {
+    if ((RCCL_TRACE_RT & krccl_print_api) == krccl_print_api) {
+        fprintf(stderr, "%s<<rccl-api:%s plan:%p%s\n", API_COLOR, __func__,
+                plan, API_COLOR_END);
+    }
+
+    if (plan == nullptr) {
+        return rcclInvalidArgument;
+    }
+
+    delete plan;
+    return rcclSuccess;
+}
+
+//! @brief Definition of rcclAllReduce64
+rcclResult_t rcclAllReduce64(const void *sendbuff, void *recvbuff, size_t count,
+                             rcclDataType_t datatype, rcclRedOp_t op,
+                             rcclComm_t comm, hipStream_t stream) {
+    if ((RCCL_TRACE_RT & krccl_print_api) == krccl_print_api) {
+        fprintf(stderr,
+                "%s<<rccl-api:%s sendbuff:%p recvbuff:%p count:%zu "
+                "datatype:%s op:%s comm:%p stream:%p%s\n",
+                API_COLOR, __func__, sendbuff, recvbuff, count,
+                umap_datatype[datatype].c_str(), umap_red_op[op].c_str(), comm,
+                stream, API_COLOR_END);
+    }
+
+    //! Buffers up to kmax_chunk_count elements, or with no elements, are
+    //! reduced by a single op which checks the arguments
+    if (count <= kmax_chunk_count) {
+        return rcclAllReduce(sendbuff, recvbuff, static_cast<int>(count),
+                             datatype, op, comm, stream);
+    }
+
+    //! Every chunk is an op of its own, same on all gpus as count is
+    size_t type_size = RcclGetDataTypeSize(datatype);
+    size_t offset = 0;
+    while (offset < count) {
+        int chunk_count =
+            static_cast<int>(std::min(count - offset, kmax_chunk_count));
+        rcclResult_t result = rcclAllReduce(
+            RcclOffsetPtr(sendbuff, offset * type_size),
+            RcclOffsetPtr(recvbuff, offset * type_size), chunk_count, datatype,
+            op, comm, stream);
+        if (result != rcclSuccess) {
+            return result;
+        }
+        offset += chunk_count;
+    }
+
+    return rcclSuccess;
+}
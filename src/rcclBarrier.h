@@ -0,0 +1,141 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+/**
+ * @file rcclBarrier.h
+ * @brief Multi-gpu barrier protocol
+ *
+ * This file contains the barrier used to sync kernels from the same rccl call
+ * across gpus, and point-to-point flags used when a gpu depends on a few of
+ * its peers only. It only uses std::atomic, so the same protocol can be run by
+ * host threads in tests and benchmarks, where it is compiled without HIP.
+ */
+
+#pragma once
+
+#include <atomic>
+
+#if defined(__HIPCC__) || defined(__HIP__)
+#include <hip/hip_runtime.h>
+#define RCCL_HOST_DEVICE __host__ __device__
+#else
+#define RCCL_HOST_DEVICE
+#endif
+
+//! Maximum number of gpus in a clique, kernels keep a table of that size in
+//! LDS
+constexpr int kmax_gpus = 16;
+
+//! @brief Definition of RcclReleaseFence
+//! Called by every workitem of a kernel after its last store to a buffer
+//! peers read. Atomics and fences on gpu are system scope, so data written
+//! before the fence is written back from gpu l2 and visible to other gpus
+//! once the kernel is complete, without recording an event on the stream
+RCCL_HOST_DEVICE inline void RcclReleaseFence() {
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+//! @brief Definition of RcclAcquireFence
+//! Called by every workitem of a kernel before its first load from a buffer
+//! peers wrote, so that data released by them before the barrier or flag the
+//! kernel was ordered after is not read stale from gpu caches
+RCCL_HOST_DEVICE inline void RcclAcquireFence() {
+    std::atomic_thread_fence(std::memory_order_acquire);
+}
+
+//! @brief Multi-GPU barrier
+//! Epoch based barrier. Every gpu uses barrier instances 0, 1, 2, ... in the
+//! same order and owns one entry of arrived, where it stores this_time + 1
+//! when it enters instance this_time. Instance this_time is done once all
+//! entries reached this_time + 1. A gpu can enter next instance before others
+//! left the current one. Entries are only ever stored by their owner, never
+//! read-modify-written, so a gpu can enter and wait on the barrier with stream
+//! memory operations as well as from a kernel. Owned by rcclUniqueId or
+//! RingNodePool_t
+struct Barrier_t {
+    std::atomic<unsigned int> arrived[kmax_gpus];
+};
+
+//! @brief Definition of RcclBarrierArrive
+//! Enter instance this_time of the barrier as gpu of rank rank, writes done
+//! before are released to the other gpus
+RCCL_HOST_DEVICE inline void RcclBarrierArrive(Barrier_t* barrier, int rank,
+                                               int this_time) {
+    std::atomic_store_explicit(&(barrier->arrived[rank]),
+                               static_cast<unsigned int>(this_time) + 1u,
+                               std::memory_order_release);
+}
+
+//! @brief Definition of RcclBarrierIsDone
+//! Check if all get_here gpus entered instance this_time of the barrier.
+//! Entries are compared modulo 2^32, so they can wrap around
+RCCL_HOST_DEVICE inline bool RcclBarrierIsDone(Barrier_t* barrier,
+                                               int this_time, int get_here) {
+    unsigned int target = static_cast<unsigned int>(this_time) + 1u;
+    for (int rank = 0; rank < get_here; rank++) {
+        unsigned int arrived = std::atomic_load_explicit(
+            &(barrier->arrived[rank]), std::memory_order_acquire);
+        if (static_cast<int>(arrived - target) < 0) return false;
+    }
+    return true;
+}
+
+//! @brief Definition of RcclBarrierWaitDone
+//! Wait until all the gpus entered instance this_time of the barrier, without
+//! entering it. This is used by workgroups of a kernel other than the one
+//! which entered the barrier on behalf of the gpu
+RCCL_HOST_DEVICE inline void RcclBarrierWaitDone(Barrier_t* barrier,
+                                                 int this_time, int get_here) {
+    while (!RcclBarrierIsDone(barrier, this_time, get_here)) {
+    }
+}
+
+//! @brief Definition of RcclBarrierWait
+//! Enter instance this_time of the barrier as gpu of rank rank, then spin
+//! until get_here gpus entered it
+RCCL_HOST_DEVICE inline void RcclBarrierWait(Barrier_t* barrier, int rank,
+                                             int this_time, int get_here) {
+    RcclBarrierArrive(barrier, rank, this_time);
+    RcclBarrierWaitDone(barrier, this_time, get_here);
+}
+
+//! @brief Point-to-point flags from one gpu (src) to another (dst)
+//! Both are set by src in memory of dst, so that dst polls them locally.
+//! Like the barrier they are never reset, each collective using them has an
+//! epoch and sets them to epoch + 1. Owned by RcclSyncSlots_t of dst
+struct RcclPeerFlags_t {
+    //! Buffer of src is published and can be accessed by dst
+    std::atomic<unsigned int> ready;
+    //! Src is done accessing buffer of dst
+    std::atomic<unsigned int> done;
+};
+
+//! @brief Definition of RcclFlagSet
+//! Set flag for collective epoch. Writes done before it are released to the
+//! gpu which waits on flag
+RCCL_HOST_DEVICE inline void RcclFlagSet(std::atomic<unsigned int>* flag,
+                                         int epoch) {
+    std::atomic_store_explicit(flag, static_cast<unsigned int>(epoch) + 1u,
+                               std::memory_order_release);
+}
+
+//! @brief Definition of RcclFlagIsSet
+//! Check if flag was set for collective epoch or a later one. Values are
+//! compared modulo 2^32, so they can wrap around
+RCCL_HOST_DEVICE inline bool RcclFlagIsSet(std::atomic<unsigned int>* flag,
+                                           int epoch) {
+    unsigned int target = static_cast<unsigned int>(epoch) + 1u;
+    unsigned int value =
+        std::atomic_load_explicit(flag, std::memory_order_acquire);
+    return static_cast<int>(value - target) >= 0;
+}
+
+//! @brief Definition of RcclFlagWait
+//! Spin until flag is set for collective epoch
+RCCL_HOST_DEVICE inline void RcclFlagWait(std::atomic<unsigned int>* flag,
+                                          int epoch) {
+    while (!RcclFlagIsSet(flag, epoch)) {
+    }
+}
@@ -7,77 +7,98 @@ All rights reserved.
  * @file rcclBarrierKernels.h
  * @brief Barriers implementation in kernels
  *
- * This file contains kernels to implement multi-gpu barriers
+ * This file contains kernels to implement multi-gpu barriers and
+ * point-to-point synchronization between gpus
  *
  * @author Aditya Atluri
  */
 
 #pragma once
 
+#include "rcclBarrier.h"
 #include "rcclTracker.h"
 
+//! @brief Definition of RcclGridBarrierWait
+//! Multi-gpu barrier called by all workitems of all workgroups of a kernel
+//! which does a whole op (fused mode). Writes done by a workgroup before the
+//! call are released to the system. The last workgroup of current gpu to
+//! arrive enters instance this_time of the barrier on behalf of the gpu, the
+//! others wait until all the gpus entered it. All workgroups of the kernel
+//! must be resident, so grid must not be larger than
+//! RingNode_t::max_workgroups.
+__device__ inline void RcclGridBarrierWait(RingNode_t* pcurr_track,
+                                           int this_time, int get_here) {
+    __syncthreads();
+    if (threadIdx.x == 0) {
+        __threadfence_system();
+        int arrived = pcurr_track->slots->exit_count.fetch_add(
+            1, std::memory_order_seq_cst);
+        if (arrived == static_cast<int>(gridDim.x * gridDim.y) - 1) {
+            std::atomic_store_explicit(&(pcurr_track->slots->exit_count), 0,
+                                       std::memory_order_seq_cst);
+            RcclBarrierWait(pcurr_track->barrier, pcurr_track->rank, this_time,
+                            get_here);
+        } else {
+            RcclBarrierWaitDone(pcurr_track->barrier, this_time, get_here);
+        }
+    }
+    __syncthreads();
+}
+
 //! @brief Definition of RcclKernelBarrierWait
-//! This kernel acts a barrier between stream on multiple gpus. In rccl, this
-//! kernel is used to make sure all the gpus done executing the previous
-//! kernels so that the data they updated is visible to all the gpus. The data
-//! structure Barrier_t present in rcclTracker.h is created once and shared
-//! across all the gpus. The elements inside the structure are:
-//! 1. bar_in, it stores the count of number of gpus that entered the barrier
-//! 2. bar_out, it stores the count of number of gpus that exited the barrier
-//! 3. times_done, it stores how many times the barrier has been used
-//! In the kernel, first we check if all the gpus arrived at the same barrier
-//! instance. For example, if one gpu (lets say A) exited the barrier and try to
-//! use the same barrier before other gpus exited, 'A' gpu will wait until all
-//! other gpus have exited the barrier and their local counter to number of
-//! times used is incremented by 1. Once all the gpus are entering the same
-//! instance of barrier, they increment bar_in atomic signaling other gpus that
-//! it entered the barrier and get the value of how many gpus entered the
-//! barrier before it entered. Now, it waits until all the gpus have entered the
-//! barrier. Once all the gpus have entered the barrier, exit the barrier by
-//! incremenet bar_out. Check if final gpu is exiting the barrier, this done by
-//! checking if the last gpus old_val is one less than number of gpus. If yes,
-//! then we wait until all the gpus have exited the barrier and reset all the
-//! barrier in and out flags. Finally, increment the barrier instance usage
-//! count by 1.
+//! Kernel version of RcclBarrierWait, launched with one workitem
 __global__ void RcclKernelBarrierWait(RingNode_t* pcurr_track, int this_time,
                                       int get_here) {
-    int val = 1;
+    RcclBarrierWait(pcurr_track->barrier, pcurr_track->rank, this_time,
+                    get_here);
+}
 
-    //! Wait until all gpus exited barrier and entered new barrier instance
-    while (std::atomic_load_explicit(&(pcurr_track->barrier->times_done),
-                                     std::memory_order_seq_cst) != this_time) {
-    }
+//! @brief Flags of RcclPeerFlags_t
+enum RcclPeerFlag_t {
+    //! RcclPeerFlags_t::ready
+    krccl_peer_ready = 0,
+    //! RcclPeerFlags_t::done
+    krccl_peer_done
+};
 
-    //! Enter barrier and signal all gpus that it entered the barrier (by
-    //! incrementing bar_in)
-    int old_val =
-        pcurr_track->barrier->bar_in.fetch_add(val, std::memory_order_seq_cst);
+//! @brief Definition of RcclGetPeerFlag
+//! Get flag set by gpu of rank src_rank in slots of another gpu
+__device__ inline std::atomic<unsigned int>* RcclGetPeerFlag(
+    RcclSyncSlots_t* slots, int src_rank, RcclPeerFlag_t flag) {
+    RcclPeerFlags_t* flags = &(slots->peer_flags[src_rank]);
+    return flag == krccl_peer_ready ? &(flags->ready) : &(flags->done);
+}
 
-    //! Wait until all gpus entered barrier
-    while (std::atomic_load_explicit(&(pcurr_track->barrier->bar_in),
-                                     std::memory_order_seq_cst) != get_here) {
+//! @brief Definition of RcclKernelSignalPeers
+//! Set flag of current gpu for collective epoch in slots of ppeer_track, or of
+//! every other gpu in the clique if ppeer_track is nullptr. Writes done by
+//! kernels launched before are released to the peers. Launched with one
+//! workitem
+__global__ void RcclKernelSignalPeers(RingNode_t* pcurr_track,
+                                      RingNode_t* ppeer_track,
+                                      RcclPeerFlag_t flag, int epoch) {
+    __threadfence_system();
+    int rank = pcurr_track->rank;
+    RingNode_t* pnode =
+        ppeer_track != nullptr ? ppeer_track : pcurr_track->next_gpu;
+    for (; pnode != pcurr_track; pnode = pnode->next_gpu) {
+        RcclFlagSet(RcclGetPeerFlag(pnode->slots, rank, flag), epoch);
+        if (ppeer_track != nullptr) break;
     }
+}
 
-    //! Exit barrier and signal all gpus that it exited the barrier (by
-    //! incrementing bar_ou)
-    pcurr_track->barrier->bar_out.fetch_add(val, std::memory_order_seq_cst);
-
-    //! For last gpu exiting the barrier, clean up barrier variables
-    if (old_val + val == get_here) {
-        //! Wait until all gpus exited barrier
-        while (std::atomic_load_explicit(&(pcurr_track->barrier->bar_out),
-                                         std::memory_order_seq_cst) !=
-               get_here) {
-        }
-
-        //! Reset all bar_in and bar_out
-        std::atomic_store_explicit(&(pcurr_track->barrier->bar_in), 0,
-                                   std::memory_order_seq_cst);
-        std::atomic_store_explicit(&(pcurr_track->barrier->bar_out), 0,
-                                   std::memory_order_seq_cst);
-
-        //! Increment number of times a barrier is used by one
-        pcurr_track->barrier->times_done.fetch_add(val,
-                                                   std::memory_order_seq_cst);
+//! @brief Definition of RcclKernelWaitPeers
+//! Wait until ppeer_track, or every other gpu in the clique if ppeer_track is
+//! nullptr, set flag for collective epoch in slots of current gpu. Launched
+//! with one workitem
+__global__ void RcclKernelWaitPeers(RingNode_t* pcurr_track,
+                                    RingNode_t* ppeer_track,
+                                    RcclPeerFlag_t flag, int epoch) {
+    RcclSyncSlots_t* slots = pcurr_track->slots;
+    RingNode_t* pnode =
+        ppeer_track != nullptr ? ppeer_track : pcurr_track->next_gpu;
+    for (; pnode != pcurr_track; pnode = pnode->next_gpu) {
+        RcclFlagWait(RcclGetPeerFlag(slots, pnode->rank, flag), epoch);
+        if (ppeer_track != nullptr) break;
     }
 }
@@ -12,7 +12,9 @@ All rights reserved.
  * @author Aditya Atluri
  */
 
+#include "rcclAlgoSelector.h"
 #include "rcclDataTypes.h"
+#include "rcclGroup.h"
 #include "rcclHelper.h"
 #include "rcclSetKernels.h"
 #include "rcclTracker.h"
@@ -27,7 +29,86 @@ extern std::unordered_map<int, std::string> umap_datatype;
 
 extern int RCCL_TRACE_RT;
 
+//! @brief Definition of RcclBcastOnGpu
+//! Launch rcclBcast on current gpu, which is either root or a non-root gpu
+template <typename DataType_t, typename VectorType_t>
+void RcclBcastOnGpu(RcclComm_t *pcomm, void *buff, int count, int root,
+                    hipStream_t stream) {
+    RcclCommSlot_t *pslot = pcomm->slot_;
+
+    //! Get RingNode for current gpu
+    RingNode_t *pcurr_track = pslot->track_;
+
+    //! Write data to peers instead of reading it, depending on topology
+    bool push = RcclGetAlgoSelector().GetPush(pcomm->pool_->GetTopology());
+
+    //! If current gpu is root, call internal implementation for root
+    if (pcomm->rank_ == root) {
+        RcclInternalBroadcastRoot<DataType_t, VectorType_t>(
+            pcurr_track, stream, buff, count, push, &(pslot->this_time_),
+            &(pslot->p2p_time_), pcomm->num_devices_);
+        return;
+    }
+
+    //! Get RingNode for root gpu
+    RingNode_t *proot_track = pcurr_track->next_gpu;
+    while (proot_track->rank != root) {
+        proot_track = proot_track->next_gpu;
+    }
+
+    RcclInternalBroadcast<DataType_t, VectorType_t>(
+        pcurr_track, proot_track, count, stream, buff, push,
+        &(pslot->this_time_), &(pslot->p2p_time_), pcomm->num_devices_);
+}
+
+//! @brief Launch rcclBcast on current gpu, with kernels of a data type
+typedef void (*RcclBcastLauncher_t)(RcclComm_t *pcomm, void *buff, int count,
+                                    int root, hipStream_t stream);
+
+//! @brief Definition of RcclGetBcastLauncher
+//! Get RcclBcastOnGpu for data type, nullptr if data type is not valid
+RcclBcastLauncher_t RcclGetBcastLauncher(rcclDataType_t datatype) {
+    switch (datatype) {
+    case rcclChar: {
+        return RcclBcastOnGpu<signed char, rccl_char16_t>;
+    }
+    case rcclUchar: {
+        return RcclBcastOnGpu<unsigned char, rccl_uchar16_t>;
+    }
+    case rcclShort: {
+        return RcclBcastOnGpu<signed short, rccl_short8_t>;
+    }
+    case rcclUshort: {
+        return RcclBcastOnGpu<unsigned short, rccl_ushort8_t>;
+    }
+    case rcclHalf: {
+        return RcclBcastOnGpu<__fp16, rccl_half8_t>;
+    }
+    case rcclInt: {
+        return RcclBcastOnGpu<signed int, rccl_int4_t>;
+    }
+    case rcclUint: {
+        return RcclBcastOnGpu<unsigned int, rccl_uint4_t>;
+    }
+    case rcclFloat: {
+        return RcclBcastOnGpu<float, rccl_float4_t>;
+    }
+    case rcclLong: {
+        return RcclBcastOnGpu<signed long, rccl_long2_t>;
+    }
+    case rcclUlong: {
+        return RcclBcastOnGpu<unsigned long, rccl_ulong2_t>;
+    }
+    case rcclDouble: {
+        return RcclBcastOnGpu<double, rccl_double2_t>;
+    }
+    default: { return nullptr; }
+    }
+}
+
 //! @brief Definition of rcclBcast
+//! All arguments are checked before the op is recorded in a group or takes a
+//! sync slot, see rcclReduce
 rcclResult_t rcclBcast(void *buff, int count, rcclDataType_t datatype, int root,
                        rcclComm_t comm, hipStream_t stream) {
     if ((RCCL_TRACE_RT & krccl_print_api) == krccl_print_api) {
@@ -46,8 +127,9 @@ rcclResult_t rcclBcast(void *buff, int count, rcclDataType_t datatype, int root,
         return rcclInvalidDevicePointer;
     }
 
-    //! Check if data type of buffers is valid or not
-    if (datatype >= rccl_NUM_TYPES) {
+    //! Get kernels for data type, nullptr if data type of buffers is not valid
+    RcclBcastLauncher_t launcher = RcclGetBcastLauncher(datatype);
+    if (launcher == nullptr) {
         return rcclInvalidType;
     }
 
@@ -66,103 +148,63 @@ rcclResult_t rcclBcast(void *buff, int count, rcclDataType_t datatype, int root,
         return rcclInvalidArgument;
     }
 
-    //! Get current value of barrier
-    int *this_time = &(pcomm->this_time_);
+    //! Inside a group, the op is launched by rcclGroupEnd
+    if (RcclGroupActive()) {
+        RcclGroupAdd({krccl_coll_bcast, nullptr, buff, count, datatype, rcclSum,
+                      root, pcomm, stream, nullptr, false});
+        return rcclSuccess;
+    }
 
     //! If same comm is used on a different stream,
     //! synchronize it with current stream before launching op.
     PreEnqueueEventRecord(pcomm, stream);
 
-    //! Get RingNode for current gpu
-    RingNode_t *pcurr_track = pcomm->track_;
+    //! Buffers which are registered and already published need not be
+    //! published again
+    SetRegisteredBuffers(pcomm, buff, count * RcclGetDataTypeSize(datatype),
+                         nullptr, 0);
 
-    //! Check if current gpu is root or not
-    bool is_root = pcomm->track_->rank == root;
+    launcher(pcomm, buff, count, root, stream);
 
-    //! If current gpu is root, call internal implementation for root
-    if (is_root) {
-        RcclInternalBroadcastRoot(pcurr_track, stream, buff, this_time,
-                                  num_gpus);
-    }
-    //! If current gpu is not root, call internal implementation
-    else {
-        //! Get RingNode for root gpu
-        RingNode_t *proot_track = pcurr_track->next_gpu;
-        while (proot_track->rank != root) {
-            proot_track = proot_track->next_gpu;
-        }
+    //! Track current stream so that op launched on different stream can be
+    //! synchronized with current stream
+    PostEnqueueEventRecord(pcomm, stream);
+    return rcclSuccess;
+}
 
-        //! Call functions depending on the data type
-        switch (datatype) {
-        case rcclChar: {
-            RcclInternalBroadcast<signed char>(pcurr_track, proot_track, count,
-                                               stream, buff, this_time,
-                                               num_gpus);
-            break;
-        }
-        case rcclUchar: {
-            RcclInternalBroadcast<unsigned char>(pcurr_track, proot_track,
-                                                 count, stream, buff, this_time,
-                                                 num_gpus);
-            break;
-        }
-        case rcclShort: {
-            RcclInternalBroadcast<signed short>(pcurr_track, proot_track, count,
-                                                stream, buff, this_time,
-                                                num_gpus);
-            break;
-        }
-        case rcclUshort: {
-            RcclInternalBroadcast<unsigned short>(pcurr_track, proot_track,
-                                                  count, stream, buff,
-                                                  this_time, num_gpus);
-            break;
-        }
-        case rcclHalf: {
-            RcclInternalBroadcast<__fp16>(pcurr_track, proot_track, count,
-                                          stream, buff, this_time, num_gpus);
-            break;
-        }
-        case rcclInt: {
-            RcclInternalBroadcast<signed int>(pcurr_track, proot_track, count,
-                                              stream, buff, this_time,
-                                              num_gpus);
-            break;
-        }
-        case rcclUint: {
-            RcclInternalBroadcast<unsigned int>(pcurr_track, proot_track, count,
-                                                stream, buff, this_time,
-                                                num_gpus);
-            break;
-        }
-        case rcclFloat: {
-            RcclInternalBroadcast<float>(pcurr_track, proot_track, count,
-                                         stream, buff, this_time, num_gpus);
-            break;
-        }
-        case rcclLong: {
-            RcclInternalBroadcast<signed long>(pcurr_track, proot_track, count,
-                                               stream, buff, this_time,
-                                               num_gpus);
-            break;
-        }
-        case rcclUlong: {
-            RcclInternalBroadcast<unsigned long>(pcurr_track, proot_track,
-                                                 count, stream, buff, this_time,
-                                                 num_gpus);
-            break;
-        }
-        case rcclDouble: {
-            RcclInternalBroadcast<double>(pcurr_track, proot_track, count,
-                                          stream, buff, this_time, num_gpus);
-            break;
-        }
-        default: { return rcclInvalidType; }
+//! @brief Definition of rcclBcast64
+rcclResult_t rcclBcast64(void *buff, size_t count, rcclDataType_t datatype,
+                         int root, rcclComm_t comm, hipStream_t stream) {
+    if ((RCCL_TRACE_RT & krccl_print_api) == krccl_print_api) {
+        fprintf(stderr,
+                "%s<<rccl-api:%s buff:%p count:%zu datatype:%s root:%d "
+                "comm:%p stream:%p%s\n",
+                API_COLOR, __func__, buff, count,
+                umap_datatype[datatype].c_str(), root, comm, stream,
+                API_COLOR_END);
+    }
+
+    //! Buffers up to kmax_chunk_count elements, or with no elements, are
+    //! broadcasted by a single op which checks the arguments
+    if (count <= kmax_chunk_count) {
+        return rcclBcast(buff, static_cast<int>(count), datatype, root, comm,
+                         stream);
+    }
+
+    //! Every chunk is an op of its own, same on all gpus as count is
+    size_t type_size = RcclGetDataTypeSize(datatype);
+    size_t offset = 0;
+    while (offset < count) {
+        int chunk_count =
+            static_cast<int>(std::min(count - offset, kmax_chunk_count));
+        rcclResult_t result =
+            rcclBcast(RcclOffsetPtr(buff, offset * type_size), chunk_count,
+                      datatype, root, comm, stream);
+        if (result != rcclSuccess) {
+            return result;
         }
+        offset += chunk_count;
     }
 
-    //! Track current stream so that op launched on different stream can be
-    //! synchronized with current stream
-    PostEnqueueEventRecord(pcomm, stream);
     return rcclSuccess;
 }
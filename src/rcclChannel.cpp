@@ -0,0 +1,80 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+/**
+ * @file rcclChannel.cpp
+ * @brief Implementation of rcclChannel.h
+ *
+ * This file contains implementation of channel rings declared in
+ * rcclChannel.h
+ */
+
+#include "rcclChannel.h"
+
+#include <set>
+
+//! @brief Get greatest common divisor of a and b
+static int RcclGetGcd(int a, int b) {
+    while (b != 0) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+//! @brief Definition of RcclGetChannelStride
+int RcclGetChannelStride(int num_ranks, int channel) {
+    if (num_ranks <= 2) {
+        return 1;
+    }
+
+    //! Count forward strides up to num_ranks / 2 which are coprime with
+    //! num_ranks, larger ones are the backward ones
+    int num_strides = 0;
+    for (int stride = 1; stride <= num_ranks / 2; stride++) {
+        if (RcclGetGcd(stride, num_ranks) == 1) num_strides++;
+    }
+
+    int index = (channel / 2) % num_strides;
+    int stride = 0;
+    for (stride = 1; stride <= num_ranks / 2; stride++) {
+        if (RcclGetGcd(stride, num_ranks) == 1 && index-- == 0) break;
+    }
+
+    return channel % 2 == 0 ? stride : num_ranks - stride;
+}
+
+//! @brief Definition of RcclGetChannelRing
+void RcclGetChannelRing(int num_ranks, int rank, int channel,
+                        RcclChannelRing_t* ring) {
+    int stride = RcclGetChannelStride(num_ranks, channel);
+
+    ring->stride = stride;
+    ring->prev = (rank - stride + num_ranks) % num_ranks;
+    ring->next = (rank + stride) % num_ranks;
+
+    //! Rank at position p is p * stride mod num_ranks
+    ring->position = 0;
+    while (RcclGetChannelRank(num_ranks, channel, ring->position) != rank) {
+        ring->position++;
+    }
+}
+
+//! @brief Definition of RcclGetChannelRank
+int RcclGetChannelRank(int num_ranks, int channel, int position) {
+    int stride = RcclGetChannelStride(num_ranks, channel);
+    return static_cast<int>((static_cast<long>(position) * stride) %
+                            num_ranks);
+}
+
+//! @brief Definition of RcclGetNumChannelPeers
+int RcclGetNumChannelPeers(int num_ranks, int num_channels) {
+    std::set<int> strides;
+    for (int channel = 0; channel < num_channels; channel++) {
+        strides.insert(RcclGetChannelStride(num_ranks, channel));
+    }
+    return static_cast<int>(strides.size());
+}
@@ -0,0 +1,69 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+/**
+ * @file rcclChannel.h
+ * @brief Rings used by multi-channel collectives
+ *
+ * A collective can split its buffer into channels, contiguous ranges which
+ * are processed at the same time by separate sets of workgroups. Each channel
+ * goes around the gpus in a different order, so that channels read from
+ * different peers and use different links. This file contains helpers which
+ * compute ring of a channel on host only and do not depend on HIP.
+ */
+
+#pragma once
+
+//! Maximum number of channels a collective is split into
+constexpr int kmax_channels = 8;
+//! Size of a slice ring steps are pipelined in, in bytes
+constexpr int kring_slice_bytes = 1 << 18;
+//! Limit the number of slices, each slice adds a kernel and flags per step
+constexpr int kmax_ring_slices = 4;
+
+//! @brief Position of a rank in ring of a channel
+struct RcclChannelRing_t {
+    //! Rank of previous gpu in the ring
+    int prev;
+    //! Rank of next gpu in the ring
+    int next;
+    //! Position of rank in the ring, gpu at position 0 is rank 0
+    int position;
+    //! Distance between ranks of neighbouring gpus in the ring
+    int stride;
+};
+
+//! Get stride of ring of a channel. Stride is coprime with num_ranks, so that
+//! the ring visits every rank. Even channels go forward with increasing
+//! strides (1 first) and odd channels go backward with the same stride as
+//! previous channel, so that both directions of links are used. Channels wrap
+//! around once strides run out.
+
+//! \param [in] num_ranks Number of ranks in the clique
+//! \param [in] channel Index of the channel
+int RcclGetChannelStride(int num_ranks, int channel);
+
+//! Get position of rank in ring of a channel
+
+//! \param [in] num_ranks Number of ranks in the clique
+//! \param [in] rank Rank of current gpu
+//! \param [in] channel Index of the channel
+//! \param [out] ring Position of rank in the ring
+void RcclGetChannelRing(int num_ranks, int rank, int channel,
+                        RcclChannelRing_t* ring);
+
+//! Get rank of gpu at position of ring of a channel
+
+//! \param [in] num_ranks Number of ranks in the clique
+//! \param [in] channel Index of the channel
+//! \param [in] position Position in the ring
+int RcclGetChannelRank(int num_ranks, int channel, int position);
+
+//! Get number of distinct previous gpus a gpu reads from when num_channels
+//! channels are used
+
+//! \param [in] num_ranks Number of ranks in the clique
+//! \param [in] num_channels Number of channels
+int RcclGetNumChannelPeers(int num_ranks, int num_channels);
@@ -14,6 +14,9 @@ All rights reserved.
 
 #pragma once
 
+#include <cstddef>
+#include "rccl/rccl.h"
+
 typedef signed char rccl_char16_t __attribute__((ext_vector_type(16)));
 typedef unsigned char rccl_uchar16_t __attribute__((ext_vector_type(16)));
 typedef signed short rccl_short8_t __attribute__((ext_vector_type(8)));
@@ -27,3 +30,27 @@ typedef __fp16 rccl_half_t;
 typedef __fp16 rccl_half8_t __attribute__((ext_vector_type(8)));
 typedef float rccl_float4_t __attribute__((ext_vector_type(4)));
 typedef double rccl_double2_t __attribute__((ext_vector_type(2)));
+
+//! @brief Get size of an element of rcclDataType_t in bytes, 0 if data type is
+//! not valid
+inline size_t RcclGetDataTypeSize(rcclDataType_t datatype) {
+    switch (datatype) {
+    case rcclChar:
+    case rcclUchar:
+        return sizeof(signed char);
+    case rcclShort:
+    case rcclUshort:
+    case rcclHalf:
+        return sizeof(signed short);
+    case rcclInt:
+    case rcclUint:
+    case rcclFloat:
+        return sizeof(signed int);
+    case rcclLong:
+    case rcclUlong:
+    case rcclDouble:
+        return sizeof(signed long);
+    default:
+        return 0;
+    }
+}
@@ -0,0 +1,148 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+/**
+ * @file rcclFusedKernels.h
+ * @brief Kernels doing a whole collective in a single launch
+ *
+ * This file contains kernels used in fused mode (RCCL_FUSED=1). Each kernel
+ * publishes buffers of current gpu, synchronizes with peer gpus, computes and
+ * copies, with phases separated by RcclGridBarrierWait instead of separate
+ * kernel launches, barrier kernels and hipEventRecord flushes.
+ */
+
+#pragma once
+
+#include "rcclBarrierKernels.h"
+#include "rcclPeerTable.h"
+#include "rcclVectorAllReduceKernels.h"
+#include "rcclVectorOps.h"
+
+//! @brief Definition of RcclKernelFusedAllReduce
+//! Same algorithm as RcclInternalAllReduce. Uses barrier instances this_time
+//! (buffers published), this_time + 1 (chunks reduced) and this_time + 2
+//! (peers done reading)
+template <typename DataType_t, typename VectorType_t, rcclRedOp_t Op,
+          int NumGpus>
+__global__ void RcclKernelFusedAllReduce(RingNode_t* pcurr_track,
+                                         const void* send_buff,
+                                         void* recv_buff, int count, int rank,
+                                         int this_time, int num_gpus) {
+    //! Publish buffers of current gpu
+    if (blockIdx.x == 0 && threadIdx.x == 0) {
+        pcurr_track->slots->src_buffer = const_cast<void*>(send_buff);
+        pcurr_track->slots->dst_buffer = recv_buff;
+    }
+    RcclGridBarrierWait(pcurr_track, this_time, num_gpus);
+
+    __shared__ RcclPeerTable_t peers;
+    RcclLoadPeerTable(pcurr_track, &peers);
+
+    //! Reduce chunk owned by current gpu, last gpu owns the remainder
+    int regular_gpu_count = count / num_gpus;
+    int offset = rank * regular_gpu_count;
+    int op_gpu_count =
+        rank == num_gpus - 1 ? count - offset : regular_gpu_count;
+    RcclAllReduceVectorRange<DataType_t, VectorType_t, Op, NumGpus>(
+        peers, send_buff, recv_buff, op_gpu_count, offset);
+    RcclGridBarrierWait(pcurr_track, this_time + 1, num_gpus);
+
+    //! Copy chunks reduced by peer gpus
+    for (int peer = 1; peer < peers.num_gpus; peer++) {
+        int peer_offset = peers.rank[peer] * regular_gpu_count;
+        int peer_count = peers.rank[peer] == num_gpus - 1
+                             ? count - peer_offset
+                             : regular_gpu_count;
+        RcclCopyVectorRange<DataType_t, VectorType_t>(
+            reinterpret_cast<DataType_t*>(recv_buff) + peer_offset,
+            reinterpret_cast<const DataType_t*>(peers.dst_buffer[peer]) +
+                peer_offset,
+            peer_count);
+    }
+    RcclGridBarrierWait(pcurr_track, this_time + 2, num_gpus);
+}
+
+//! @brief Definition of RcclKernelFusedReduce
+//! Launched on root gpu of rcclReduce. Uses barrier instances this_time
+//! (buffers published) and this_time + 1 (peers done reading)
+template <typename DataType_t, typename VectorType_t, rcclRedOp_t Op,
+          int NumGpus>
+__global__ void RcclKernelFusedReduce(RingNode_t* pcurr_track,
+                                      const void* send_buff, void* recv_buff,
+                                      int count, int this_time, int num_gpus) {
+    if (blockIdx.x == 0 && threadIdx.x == 0) {
+        pcurr_track->slots->src_buffer = const_cast<void*>(send_buff);
+    }
+    RcclGridBarrierWait(pcurr_track, this_time, num_gpus);
+
+    __shared__ RcclPeerTable_t peers;
+    RcclLoadPeerTable(pcurr_track, &peers);
+
+    RcclAllReduceVectorRange<DataType_t, VectorType_t, Op, NumGpus>(
+        peers, send_buff, recv_buff, count, 0);
+    RcclGridBarrierWait(pcurr_track, this_time + 1, num_gpus);
+}
+
+//! @brief Definition of RcclKernelFusedPublishSrc
+//! Launched with one workitem on gpus which only provide data (non-root gpus
+//! of rcclReduce, root gpu of rcclBcast). Publish source buffer and wait until
+//! peers are done reading it. Uses barrier instances this_time and
+//! this_time + 1
+__global__ void RcclKernelFusedPublishSrc(RingNode_t* pcurr_track,
+                                          void* send_buff, int this_time,
+                                          int num_gpus) {
+    pcurr_track->slots->src_buffer = send_buff;
+    RcclGridBarrierWait(pcurr_track, this_time, num_gpus);
+    RcclGridBarrierWait(pcurr_track, this_time + 1, num_gpus);
+}
+
+//! @brief Definition of RcclKernelFusedCopyFromRoot
+//! Launched on non-root gpus of rcclBcast. Uses barrier instances this_time
+//! (root published its buffer) and this_time + 1 (everyone done reading)
+template <typename DataType_t, typename VectorType_t>
+__global__ void RcclKernelFusedCopyFromRoot(RingNode_t* pcurr_track,
+                                            RingNode_t* proot_track,
+                                            void* recv_buff, int count,
+                                            int this_time, int num_gpus) {
+    RcclGridBarrierWait(pcurr_track, this_time, num_gpus);
+
+    __shared__ const DataType_t* root_src_buff;
+    if (threadIdx.x == 0) {
+        root_src_buff = reinterpret_cast<const DataType_t*>(
+            proot_track->slots->src_buffer);
+    }
+    __syncthreads();
+
+    RcclCopyVectorRange<DataType_t, VectorType_t>(
+        reinterpret_cast<DataType_t*>(recv_buff), root_src_buff, count);
+    RcclGridBarrierWait(pcurr_track, this_time + 1, num_gpus);
+}
+
+//! @brief Definition of RcclKernelFusedAllGather
+//! Same as RcclInternalAllGather. Uses barrier instances this_time (buffers
+//! published) and this_time + 1 (peers done reading)
+template <typename DataType_t, typename VectorType_t>
+__global__ void RcclKernelFusedAllGather(RingNode_t* pcurr_track,
+                                         const void* send_buff,
+                                         void* recv_buff, int count,
+                                         int this_time, int num_gpus) {
+    if (blockIdx.x == 0 && threadIdx.x == 0) {
+        pcurr_track->slots->src_buffer = const_cast<void*>(send_buff);
+        pcurr_track->slots->dst_buffer = recv_buff;
+    }
+    RcclGridBarrierWait(pcurr_track, this_time, num_gpus);
+
+    __shared__ RcclPeerTable_t peers;
+    RcclLoadPeerTable(pcurr_track, &peers);
+
+    for (int peer = 0; peer < peers.num_gpus; peer++) {
+        RcclCopyVectorRange<DataType_t, VectorType_t>(
+            reinterpret_cast<DataType_t*>(recv_buff) +
+                static_cast<size_t>(peers.rank[peer]) * count,
+            reinterpret_cast<const DataType_t*>(peers.src_buffer[peer]),
+            count);
+    }
+    RcclGridBarrierWait(pcurr_track, this_time + 1, num_gpus);
+}
@@ -0,0 +1,137 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+/**
+ * @file rcclFusedRuntime.h
+ * @brief Host code which launches fused kernels
+ *
+ * This file contains host code which launches one kernel per collective per
+ * gpu, used instead of the chain of pointer set, barrier, compute and copy
+ * kernels when fused mode is enabled with RCCL_FUSED=1. Fused kernels spin on
+ * barriers from all of their workgroups, so grids are sized with
+ * RcclGetLaunchDims which keeps them resident, next to fused kernels of other
+ * collectives in flight.
+ */
+
+#pragma once
+
+#include "rcclFusedKernels.h"
+#include "rcclLaunch.h"
+#include "rcclSync.h"
+
+//! @brief Enable fused mode, set from RCCL_FUSED environment variable
+extern int RCCL_FUSED;
+
+//! @brief Definition of RcclInternalAllReduceFused
+//! If pconfig is not nullptr, grid is the one computed by a persistent plan
+template <typename DataType_t, typename VectorType_t, rcclRedOp_t Op,
+          int NumGpus>
+void RcclInternalAllReduceFused(RingNode_t* pcurr_track, const void* send_buff,
+                                void* recv_buff, hipStream_t stream, int count,
+                                int num_gpus, int rank, int* this_time,
+                                const RcclAllReduceConfig_t* pconfig =
+                                    nullptr) {
+    int num_workitems = 0, num_workgroups = 0;
+    if (pconfig != nullptr) {
+        num_workitems = pconfig->num_fused_workitems;
+        num_workgroups = pconfig->num_fused_workgroups;
+    } else {
+        RcclGetVectorLaunchDims<DataType_t, VectorType_t>(
+            pcurr_track, count / num_gpus + count % num_gpus, &num_workitems,
+            &num_workgroups, knum_sync_slots);
+    }
+
+    //! Kernel publishes buffers of current gpu itself
+    RcclInternalForgetPtrs(pcurr_track);
+
+    hipLaunchKernelGGL(
+        (RcclKernelFusedAllReduce<DataType_t, VectorType_t, Op, NumGpus>),
+        dim3(num_workgroups, 1, 1), dim3(num_workitems, 1, 1), 0, stream,
+        pcurr_track, send_buff, recv_buff, count, rank, *this_time, num_gpus);
+
+    //! Kernel used three barrier instances
+    *this_time += 3;
+}
+
+//! @brief Definition of RcclInternalReduceFused
+//! Launched on root gpu
+template <typename DataType_t, typename VectorType_t, rcclRedOp_t Op,
+          int NumGpus>
+void RcclInternalReduceFused(RingNode_t* pcurr_track, int count,
+                             hipStream_t stream, const void* send_buff,
+                             void* recv_buff, int* this_time, int num_gpus) {
+    int num_workitems = 0, num_workgroups = 0;
+    RcclGetVectorLaunchDims<DataType_t, VectorType_t>(
+        pcurr_track, count, &num_workitems, &num_workgroups, knum_sync_slots);
+
+    //! Kernel publishes buffers of current gpu itself
+    RcclInternalForgetPtrs(pcurr_track);
+
+    hipLaunchKernelGGL(
+        (RcclKernelFusedReduce<DataType_t, VectorType_t, Op, NumGpus>),
+        dim3(num_workgroups, 1, 1), dim3(num_workitems, 1, 1), 0, stream,
+        pcurr_track, send_buff, recv_buff, count, *this_time, num_gpus);
+
+    //! Kernel used two barrier instances
+    *this_time += 2;
+}
+
+//! @brief Definition of RcclInternalPublishSrcFused
+//! Launched on non-root gpus of rcclReduce and root gpu of rcclBcast
+inline void RcclInternalPublishSrcFused(RingNode_t* pcurr_track,
+                                        hipStream_t stream,
+                                        const void* send_buff, int* this_time,
+                                        int num_gpus) {
+    //! Kernel publishes buffers of current gpu itself
+    RcclInternalForgetPtrs(pcurr_track);
+
+    hipLaunchKernelGGL(RcclKernelFusedPublishSrc, dim3(1, 1, 1), dim3(1, 1, 1),
+                       0, stream, pcurr_track, (void*)send_buff, *this_time,
+                       num_gpus);
+
+    //! Kernel used two barrier instances
+    *this_time += 2;
+}
+
+//! @brief Definition of RcclInternalBroadcastFused
+//! Launched on non-root gpus
+template <typename DataType_t, typename VectorType_t>
+void RcclInternalBroadcastFused(RingNode_t* pcurr_track,
+                                RingNode_t* proot_track, int count,
+                                hipStream_t stream, void* recv_buff,
+                                int* this_time, int num_gpus) {
+    int num_workitems = 0, num_workgroups = 0;
+    RcclGetVectorLaunchDims<DataType_t, VectorType_t>(
+        pcurr_track, count, &num_workitems, &num_workgroups, knum_sync_slots);
+
+    hipLaunchKernelGGL(
+        (RcclKernelFusedCopyFromRoot<DataType_t, VectorType_t>),
+        dim3(num_workgroups, 1, 1), dim3(num_workitems, 1, 1), 0, stream,
+        pcurr_track, proot_track, recv_buff, count, *this_time, num_gpus);
+
+    //! Kernel used two barrier instances
+    *this_time += 2;
+}
+
+//! @brief Definition of RcclInternalAllGatherFused
+template <typename DataType_t, typename VectorType_t>
+void RcclInternalAllGatherFused(RingNode_t* pcurr_track, const void* send_buff,
+                                void* recv_buff, hipStream_t stream, int count,
+                                int num_gpus, int* this_time) {
+    int num_workitems = 0, num_workgroups = 0;
+    RcclGetVectorLaunchDims<DataType_t, VectorType_t>(
+        pcurr_track, count, &num_workitems, &num_workgroups, knum_sync_slots);
+
+    //! Kernel publishes buffers of current gpu itself
+    RcclInternalForgetPtrs(pcurr_track);
+
+    hipLaunchKernelGGL((RcclKernelFusedAllGather<DataType_t, VectorType_t>),
+                       dim3(num_workgroups, 1, 1), dim3(num_workitems, 1, 1), 0,
+                       stream, pcurr_track, send_buff, recv_buff, count,
+                       *this_time, num_gpus);
+
+    //! Kernel used two barrier instances
+    *this_time += 2;
+}
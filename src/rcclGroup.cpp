@@ -0,0 +1,417 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+/**
+ * @file rcclGroup.cpp
+ * @brief rccl library implementation of rcclGroupStart and rcclGroupEnd
+ *
+ * This file contains implementation of group APIs. Ops made inside a group
+ * are recorded per thread and launched when the outermost group ends, from
+ * a worker thread per device which lives as long as the process.
+ */
+
+#include "rcclDataTypes.h"
+#include "rcclGroup.h"
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+extern int RCCL_TRACE_RT;
+
+//! @brief Number of groups the calling thread is in
+thread_local int group_depth = 0;
+//! @brief Ops made by the calling thread since outermost rcclGroupStart
+thread_local std::vector<RcclGroupOp_t> group_ops;
+
+//! @brief Ops of one rcclGroupEnd handed to the workers of its devices
+struct RcclGroupBatch_t {
+    //! Guards pending
+    std::mutex mutex;
+    //! Signaled when pending drops to 0
+    std::condition_variable done;
+    //! Number of workers which did not launch their ops yet
+    int pending;
+};
+
+//! @brief Ops of a group on one device, and where to report their result
+struct RcclGroupTask_t {
+    //! Ops of the device, in the order they were made
+    const std::vector<const RcclGroupOp_t *> *ops;
+    //! Result of the first op which failed, rcclSuccess if none did
+    rcclResult_t *result;
+    //! Batch the task belongs to
+    RcclGroupBatch_t *batch;
+};
+
+//! @brief Definition of RcclGroupWorker_t
+//! Thread launching ops of groups on a device. Launching an op can wait on
+//! the gpu (for example, to grow a table of tensors), so ops of each device
+//! of a group are launched from a thread of its own, and a single thread
+//! driving all gpus does not serialize them. Workers are created on first
+//! use of a device and kept, so that rcclGroupEnd does not create threads.
+//! Tasks of several groups on the same device are run in the order they are
+//! handed over
+class RcclGroupWorker_t {
+  private:
+    //! Device ops are launched on
+    int device_;
+    //! Guards tasks_ and stop_
+    std::mutex mutex_;
+    //! Signaled when a task is added or the worker is stopped
+    std::condition_variable wake_;
+    //! Tasks not yet run
+    std::deque<RcclGroupTask_t> tasks_;
+    //! Set by destructor to make the thread exit
+    bool stop_;
+    //! Thread running the tasks
+    std::thread thread_;
+    //! Body of thread_
+    void Run();
+
+  public:
+    //! Create worker for device and start its thread
+    explicit RcclGroupWorker_t(int device);
+    //! Stop the thread once it ran all tasks handed over
+    ~RcclGroupWorker_t();
+    //! Hand over ops of a group to be launched
+    void Submit(const RcclGroupTask_t &task);
+};
+
+//! @brief Definition of RcclGroupWorker_t constructor
+RcclGroupWorker_t::RcclGroupWorker_t(int device)
+    : device_(device), stop_(false) {
+    thread_ = std::thread(&RcclGroupWorker_t::Run, this);
+}
+
+//! @brief Definition of RcclGroupWorker_t destructor
+RcclGroupWorker_t::~RcclGroupWorker_t() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+}
+
+//! @brief Definition of Submit
+void RcclGroupWorker_t::Submit(const RcclGroupTask_t &task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(task);
+    }
+    wake_.notify_one();
+}
+
+//! @brief Launch recorded op, called outside of any group
+static rcclResult_t RcclGroupLaunch(const RcclGroupOp_t &op);
+
+//! @brief Definition of Run
+//! Worker threads are not in a group, so ops are launched by rccl APIs as
+//! usual
+void RcclGroupWorker_t::Run() {
+    bool device_set = hipSetDevice(device_) == hipSuccess;
+    while (true) {
+        RcclGroupTask_t task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+            if (tasks_.empty()) return;
+            task = tasks_.front();
+            tasks_.pop_front();
+        }
+
+        *(task.result) = device_set ? rcclSuccess : rcclUnhandledHipError;
+        for (const RcclGroupOp_t *op : *(task.ops)) {
+            if (*(task.result) != rcclSuccess) break;
+            *(task.result) = RcclGroupLaunch(*op);
+        }
+
+        RcclGroupBatch_t *batch = task.batch;
+        std::lock_guard<std::mutex> lock(batch->mutex);
+        if (--(batch->pending) == 0) {
+            batch->done.notify_one();
+        }
+    }
+}
+
+//! @brief Guards group_workers
+std::mutex group_workers_mutex;
+//! @brief Worker of each device, by device index
+std::map<int, std::unique_ptr<RcclGroupWorker_t>> group_workers;
+
+//! @brief Get worker of device, creating it on first use
+static RcclGroupWorker_t *RcclGetGroupWorker(int device) {
+    std::lock_guard<std::mutex> lock(group_workers_mutex);
+    std::unique_ptr<RcclGroupWorker_t> &worker = group_workers[device];
+    if (worker == nullptr) {
+        worker.reset(new RcclGroupWorker_t(device));
+    }
+    return worker.get();
+}
+
+//! @brief Definition of RcclGroupActive
+bool RcclGroupActive() { return group_depth > 0; }
+
+//! @brief Definition of RcclGroupAdd
+void RcclGroupAdd(const RcclGroupOp_t &op) { group_ops.push_back(op); }
+
+//! @brief Check if op b can be fused into op a on the same communicator
+//! Both must be rcclAllReduce ops, not plans or rcclAllReduceMulti, with same
+//! data type, reduction op and stream
+static bool RcclGroupCanFuse(const RcclGroupOp_t &a, const RcclGroupOp_t &b) {
+    return a.plan == nullptr && b.plan == nullptr && a.counts.empty() &&
+           b.counts.empty() && a.coll == krccl_coll_allreduce &&
+           b.coll == krccl_coll_allreduce && a.datatype == b.datatype &&
+           a.op == b.op && a.stream == b.stream;
+}
+
+//! @brief Check if bytes at a and b overlap
+static bool RcclGroupOverlap(const void *a, size_t a_bytes, const void *b,
+                             size_t b_bytes) {
+    const char *pa = static_cast<const char *>(a);
+    const char *pb = static_cast<const char *>(b);
+    return pa < pb + b_bytes && pb < pa + a_bytes;
+}
+
+//! @brief Check if op can join tensors already fused on its communicator
+//! Buffers op writes must not overlap buffers of fused tensors, nor buffers
+//! it reads overlap buffers they write, so that no element is read after
+//! another op of the group wrote it
+static bool RcclGroupCanJoin(const std::vector<RcclTensor_t> &tensors,
+                             const RcclGroupOp_t &op) {
+    size_t type_size = RcclGetDataTypeSize(op.datatype);
+    size_t bytes = op.count * type_size;
+    for (const RcclTensor_t &tensor : tensors) {
+        size_t tensor_bytes = tensor.count * type_size;
+        if (RcclGroupOverlap(op.sendbuff, bytes, tensor.dst_buffer,
+                             tensor_bytes) ||
+            RcclGroupOverlap(op.recvbuff, bytes, tensor.src_buffer,
+                             tensor_bytes) ||
+            RcclGroupOverlap(op.recvbuff, bytes, tensor.dst_buffer,
+                             tensor_bytes)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//! @brief Check if buffers of op follow buffers of tensor
+static bool RcclGroupFollows(const RcclTensor_t &tensor,
+                             const RcclGroupOp_t &op) {
+    size_t bytes = tensor.count * RcclGetDataTypeSize(op.datatype);
+    return static_cast<const char *>(tensor.src_buffer) + bytes ==
+               op.sendbuff &&
+           static_cast<char *>(tensor.dst_buffer) + bytes == op.recvbuff;
+}
+
+//! @brief Fuse consecutive small rcclAllReduce ops of the group
+//! Every gpu must launch the same ops, so ops are only fused if communicators
+//! of all gpus of a clique are in the group and ops at the same position can
+//! be fused on every one of them. Ops are recorded per thread, so this only
+//! happens when one thread drives all gpus of the clique. An op whose buffers
+//! follow the last fused tensor on every gpu extends it, others become a new
+//! tensor. Op at base position becomes rcclAllReduceMulti if it ends up with
+//! more than one tensor, so that the fused ops are still a single kernel
+static void RcclGroupFuse(std::vector<RcclGroupOp_t> *pops) {
+    std::vector<RcclGroupOp_t> &ops = *pops;
+
+    //! Indices of ops of each communicator, by clique
+    std::map<RingNodePool_t *, std::map<RcclComm_t *, std::vector<size_t>>>
+        cliques;
+    for (size_t i = 0; i < ops.size(); i++) {
+        cliques[ops[i].comm->pool_][ops[i].comm].push_back(i);
+    }
+
+    for (auto &clique : cliques) {
+        std::map<RcclComm_t *, std::vector<size_t>> &comm_ops = clique.second;
+        if (static_cast<int>(comm_ops.size()) !=
+            clique.first->GetNumDevices()) {
+            continue;
+        }
+
+        size_t num_ops = comm_ops.begin()->second.size();
+        bool same_num_ops = true;
+        for (auto &it : comm_ops) {
+            same_num_ops = same_num_ops && it.second.size() == num_ops;
+        }
+        if (!same_num_ops || num_ops == 0) {
+            continue;
+        }
+
+        //! Tensors fused into op at position base, by communicator, and their
+        //! size in bytes, which is same on all gpus
+        std::map<RcclComm_t *, std::vector<RcclTensor_t>> tensors;
+        size_t bytes = 0;
+
+        //! Op at position base starts new tensors on all gpus
+        auto start = [&](size_t base) {
+            for (auto &it : comm_ops) {
+                const RcclGroupOp_t &op = ops[it.second[base]];
+                tensors[it.first] = {{op.sendbuff, op.recvbuff, op.count}};
+                bytes = op.count * RcclGetDataTypeSize(op.datatype);
+            }
+        };
+
+        //! Write tensors fused into op at position base back to it
+        auto finish = [&](size_t base) {
+            for (auto &it : comm_ops) {
+                RcclGroupOp_t &op = ops[it.second[base]];
+                const std::vector<RcclTensor_t> &fused = tensors[it.first];
+                if (fused.size() == 1) {
+                    op.count = fused[0].count;
+                    continue;
+                }
+                for (const RcclTensor_t &tensor : fused) {
+                    op.sendbuffs.push_back(tensor.src_buffer);
+                    op.recvbuffs.push_back(tensor.dst_buffer);
+                    op.counts.push_back(tensor.count);
+                }
+            }
+        };
+
+        //! Op at position k is fused into op at position base on all gpus,
+        //! or becomes the new base
+        size_t base = 0;
+        start(base);
+        for (size_t k = 1; k < num_ops; k++) {
+            //! Number of elements is same on all gpus
+            const RcclGroupOp_t &first = ops[comm_ops.begin()->second[k]];
+            size_t op_bytes =
+                first.count * RcclGetDataTypeSize(first.datatype);
+
+            bool can_fuse = bytes + op_bytes <= kgroup_fuse_bytes;
+            bool follows = true;
+            for (auto &it : comm_ops) {
+                const RcclGroupOp_t &op = ops[it.second[k]];
+                const std::vector<RcclTensor_t> &fused = tensors[it.first];
+                can_fuse = can_fuse &&
+                           RcclGroupCanFuse(ops[it.second[base]], op) &&
+                           RcclGroupCanJoin(fused, op);
+                follows = follows && RcclGroupFollows(fused.back(), op);
+            }
+            if (!can_fuse) {
+                finish(base);
+                base = k;
+                start(base);
+                continue;
+            }
+
+            for (auto &it : comm_ops) {
+                RcclGroupOp_t &op = ops[it.second[k]];
+                std::vector<RcclTensor_t> &fused = tensors[it.first];
+                if (follows) {
+                    fused.back().count += op.count;
+                } else {
+                    fused.push_back({op.sendbuff, op.recvbuff, op.count});
+                }
+                op.fused = true;
+            }
+            bytes += op_bytes;
+        }
+        finish(base);
+    }
+}
+
+//! @brief Definition of RcclGroupLaunch
+static rcclResult_t RcclGroupLaunch(const RcclGroupOp_t &op) {
+    if (op.plan != nullptr) {
+        return rcclPlanExecute(op.plan, op.stream);
+    }
+    if (!op.counts.empty()) {
+        std::vector<const void *> sendbuffs = op.sendbuffs;
+        std::vector<void *> recvbuffs = op.recvbuffs;
+        return rcclAllReduceMulti(sendbuffs.data(), recvbuffs.data(),
+                                  op.counts.data(),
+                                  static_cast<int>(op.counts.size()),
+                                  op.datatype, op.op, op.comm, op.stream);
+    }
+    switch (op.coll) {
+    case krccl_coll_allreduce: {
+        return rcclAllReduce(op.sendbuff, op.recvbuff, op.count, op.datatype,
+                             op.op, op.comm, op.stream);
+    }
+    case krccl_coll_bcast: {
+        return rcclBcast(op.recvbuff, op.count, op.datatype, op.root, op.comm,
+                         op.stream);
+    }
+    case krccl_coll_reduce: {
+        return rcclReduce(op.sendbuff, op.recvbuff, op.count, op.datatype,
+                          op.op, op.root, op.comm, op.stream);
+    }
+    case krccl_coll_allgather: {
+        return rcclAllGather(op.sendbuff, op.count, op.datatype, op.recvbuff,
+                             op.comm, op.stream);
+    }
+    default: { return rcclInternalError; }
+    }
+}
+
+//! @brief Definition of rcclGroupStart
+rcclResult_t rcclGroupStart() {
+    if ((RCCL_TRACE_RT & krccl_print_api) == krccl_print_api) {
+        fprintf(stderr, "%s<<rccl-api: %s depth:%d%s\n", API_COLOR, __func__,
+                group_depth, API_COLOR_END);
+    }
+
+    group_depth++;
+    return rcclSuccess;
+}
+
+//! @brief Definition of rcclGroupEnd
+rcclResult_t rcclGroupEnd() {
+    if ((RCCL_TRACE_RT & krccl_print_api) == krccl_print_api) {
+        fprintf(stderr, "%s<<rccl-api: %s depth:%d ops:%zu%s\n", API_COLOR,
+                __func__, group_depth, group_ops.size(), API_COLOR_END);
+    }
+
+    //! Check if there is a group to end
+    if (group_depth == 0) {
+        return rcclInvalidArgument;
+    }
+
+    //! Ops of nested groups are launched with the outermost one
+    if (--group_depth > 0) {
+        return rcclSuccess;
+    }
+
+    std::vector<RcclGroupOp_t> ops;
+    ops.swap(group_ops);
+    RcclGroupFuse(&ops);
+
+    //! Ops of each device, in the order they were made
+    std::map<int, std::vector<const RcclGroupOp_t *>> device_ops;
+    for (const RcclGroupOp_t &op : ops) {
+        if (!op.fused) {
+            device_ops[op.comm->device_].push_back(&op);
+        }
+    }
+
+    //! Launch ops of every device from its worker and wait until all of
+    //! them are launched
+    std::vector<rcclResult_t> results(device_ops.size(), rcclSuccess);
+    RcclGroupBatch_t batch;
+    batch.pending = static_cast<int>(device_ops.size());
+    size_t worker = 0;
+    for (auto &it : device_ops) {
+        RcclGetGroupWorker(it.first)->Submit(
+            {&(it.second), &(results[worker]), &batch});
+        worker++;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(batch.mutex);
+        batch.done.wait(lock, [&batch] { return batch.pending == 0; });
+    }
+
+    for (rcclResult_t result : results) {
+        if (result != rcclSuccess) return result;
+    }
+    return rcclSuccess;
+}
@@ -0,0 +1,64 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+/**
+ * @file rcclGroup.h
+ * @brief Ops recorded between rcclGroupStart and rcclGroupEnd
+ *
+ * This file contains the data structure used to record an op made inside a
+ * group, and functions used by rccl APIs to record ops instead of launching
+ * them.
+ */
+
+#pragma once
+
+#include "rcclAlgoSelector.h"
+#include "rcclPlan.h"
+#include "rcclTracker.h"
+
+#include <vector>
+
+//! Consecutive rcclAllReduce ops in a group are fused while their total size
+//! is at most these many bytes
+constexpr size_t kgroup_fuse_bytes = 256 * 1024;
+
+//! @brief Op recorded inside a group, with arguments already checked
+//! rccl APIs check all arguments before RcclGroupAdd, so that launching the
+//! op from rcclGroupEnd can not fail on one gpu after its peers launched
+struct RcclGroupOp_t {
+    //! Collective of the op
+    RcclCollective_t coll;
+    //! Source buffer, unused for rcclBcast
+    const void* sendbuff;
+    //! Destination buffer, buff of rcclBcast
+    void* recvbuff;
+    //! Number of elements as passed to the api
+    int count;
+    //! Data type of buffers
+    rcclDataType_t datatype;
+    //! Reduction op, for rcclAllReduce and rcclReduce
+    rcclRedOp_t op;
+    //! Root gpu, for rcclBcast and rcclReduce
+    int root;
+    //! Communicator for current gpu
+    RcclComm_t* comm;
+    //! Stream the op launches on
+    hipStream_t stream;
+    //! Plan to execute instead of the op, if not nullptr
+    RcclPlan_t* plan;
+    //! Set if the op was fused into a previous op of the group
+    bool fused;
+    //! Buffers and number of elements of each tensor of rcclAllReduceMulti,
+    //! or of rcclAllReduce ops fused by rcclGroupEnd, empty for other ops
+    std::vector<const void*> sendbuffs;
+    std::vector<void*> recvbuffs;
+    std::vector<size_t> counts;
+};
+
+//! @brief Check if calling thread is inside a group
+bool RcclGroupActive();
+
+//! @brief Record op made inside a group, it is launched by rcclGroupEnd
+void RcclGroupAdd(const RcclGroupOp_t& op);
@@ -14,18 +14,49 @@ All rights reserved.
 #pragma once
 
 #include <hip/hip_runtime_api.h>
+#include <algorithm>
 #include "rcclTracker.h"
 
-//! Synchronize current stream with stream used before with the same
-//! communicator. If previous stream is same as current stream, don't do
-//! anything
+//! Ops of size_t count APIs with more elements than this are split into
+//! chunks, which are launched one after another as ops of the int count APIs
+constexpr size_t kmax_chunk_count = size_t(1) << 30;
+
+//! Pick sync slot of the communicator for the op (comm->slot_), the next one
+//! in round robin order. Synchronize current stream with stream the slot was
+//! used on before. If previous stream is same as current stream, don't do
+//! anything. Ops using other slots are not waited for, so up to
+//! knum_sync_slots ops can be in flight on different streams
 
 //! \param [in] comm Memory location to internal Rccl communicator
 //! \param [in] stream Stream with which the op will be synchronized with
 void PreEnqueueEventRecord(RcclComm_t* comm, hipStream_t stream);
 
-//! Record event on the stream after launching kernels related to op
+//! Record event of sync slot of the op on the stream after launching kernels
+//! related to op
 
 //! \param [in] comm Memory location to internal Rccl communicator
 //! \param [in] stream Stream with which the op will be synchronized with
 void PostEnqueueEventRecord(RcclComm_t* comm, hipStream_t stream);
+
+//! Mark in RingNode_t of sync slot of the op whether buffers of the op lie in
+//! buffers registered with the communicator. Must be called after
+//! PreEnqueueEventRecord
+
+//! \param [in] comm Memory location to internal Rccl communicator
+//! \param [in] sendbuff Buffer the op reads on current gpu
+//! \param [in] send_bytes Size of sendbuff in bytes
+//! \param [in] recvbuff Buffer the op writes on current gpu, nullptr if none
+//! \param [in] recv_bytes Size of recvbuff in bytes
+void SetRegisteredBuffers(RcclComm_t* comm, const void* sendbuff,
+                          size_t send_bytes, const void* recvbuff,
+                          size_t recv_bytes);
+
+//! Get pointer bytes bytes past ptr, nullptr if ptr is nullptr
+
+//! \param [in] ptr Buffer, can be nullptr
+//! \param [in] bytes Offset in bytes
+inline void* RcclOffsetPtr(const void* ptr, size_t bytes) {
+    return ptr == nullptr
+               ? nullptr
+               : const_cast<char*>(static_cast<const char*>(ptr)) + bytes;
+}
@@ -0,0 +1,185 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+/**
+ * @file rcclLaunch.h
+ * @brief Launch configuration of grid-stride kernels
+ *
+ * This file contains helpers used by host code to size the grid of a kernel.
+ * All data moving kernels loop over their range with a stride equal to the
+ * size of the grid, so the grid only has to be large enough to fill the gpu.
+ * It is capped at RingNode_t::max_workgroups, which keeps every workgroup of
+ * a kernel resident at once (needed by kernels which spin on a barrier).
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#include "rcclChannel.h"
+#include "rcclTracker.h"
+#include "rcclTree.h"
+
+extern size_t RCCL_NONTEMPORAL_BYTES;
+
+//! @brief Check if kernels of a collective use non-temporal accesses
+//! Collectives touch their payload once. Above RCCL_NONTEMPORAL_BYTES per gpu
+//! buffers are streamed past gpu caches instead of evicting working set of
+//! the application, smaller ones stay cached as they may fit in l2 anyway
+inline bool RcclIsNonTemporal(size_t bytes) {
+    return bytes >= RCCL_NONTEMPORAL_BYTES;
+}
+
+//! @brief Get launch configuration of a grid-stride kernel
+//! Launch one workitem per element, up to RingNode_t::max_workgroups
+//! workgroups of knum_workitems. Kernels which run grid_height rows of
+//! workgroups (blockIdx.y, for example one row per channel) share the limit
+//! between the rows, num_workgroups is the width of a row. Kernels which spin
+//! on a barrier from every workgroup pass knum_sync_slots instead, so that
+//! kernels of all collectives in flight on the gpu fit at once
+inline void RcclGetLaunchDims(const RingNode_t* pcurr_track, int count,
+                              int* num_workitems, int* num_workgroups,
+                              int grid_height = 1) {
+    if (count < static_cast<int>(knum_workitems)) {
+        *num_workitems = count > 0 ? count : 1;
+        *num_workgroups = 1;
+        return;
+    }
+
+    int max_workgroups =
+        static_cast<int>(pcurr_track->max_workgroups) / grid_height;
+    if (max_workgroups < 1) max_workgroups = 1;
+
+    *num_workitems = knum_workitems;
+    *num_workgroups = (count + knum_workitems - 1) / knum_workitems;
+    if (*num_workgroups > max_workgroups) *num_workgroups = max_workgroups;
+}
+
+//! @brief Launch configuration of mesh allreduce (RcclInternalAllReduce)
+//! Depends only on the op and the gpu, so persistent plans compute it once
+//! when they are created (see RcclGetAllReduceConfig). Also holds the grid of
+//! the fused mode kernel
+struct RcclAllReduceConfig_t {
+    //! Index of first element of the chunk current gpu reduces
+    int offset;
+    //! Number of elements in chunks of all gpus except the last one
+    int regular_gpu_count;
+    //! Number of elements in chunk of last gpu
+    int last_gpu_count;
+    //! Number of elements in chunk of current gpu
+    int op_gpu_count;
+    //! Grid of scalar kernels
+    int num_workitems;
+    int num_workgroups;
+    //! Grid of vector kernels
+    int num_vector_workitems;
+    int num_vector_workgroups;
+    //! Set if buffers of current gpu allow 16 byte accesses
+    bool vectorize;
+    //! Set if buffers are accessed with non-temporal loads and stores
+    bool nontemporal;
+    //! Set if reduced chunks are written to peers instead of read from them
+    bool push;
+    //! Grid of fused mode kernel (RcclInternalAllReduceFused)
+    int num_fused_workitems;
+    int num_fused_workgroups;
+};
+
+//! @brief Launch configuration of ring allreduce (RcclInternalAllReduceRing)
+//! Peers are RingNode_t of the sync slot it is computed for (see
+//! RcclGetRingAllReduceConfig)
+struct RcclRingAllReduceConfig_t {
+    //! Number of channels buffer is split into
+    int num_channels;
+    //! Number of elements in all channels except the last one
+    int regular_channel_count;
+    //! Number of elements in the last channel
+    int last_channel_count;
+    //! Number of slices each step is pipelined in
+    int num_slices;
+    //! Grid of a row of step kernels, one row per channel
+    int num_workitems;
+    int num_workgroups;
+    //! Ring of each channel
+    RcclChannelRing_t rings[kmax_channels];
+    //! Previous gpu in ring of each channel
+    RingNode_t* peers[kmax_channels];
+    //! Distinct previous and next gpus over all channels
+    RingNode_t* prevs[kmax_channels];
+    RingNode_t* nexts[kmax_channels];
+    int num_prevs;
+    int num_nexts;
+};
+
+//! @brief Launch configuration of tree allreduce (RcclInternalAllReduceTree)
+//! Peers are RingNode_t of the sync slot it is computed for (see
+//! RcclGetTreeAllReduceConfig)
+struct RcclTreeAllReduceConfig_t {
+    //! Position of current gpu in both trees
+    RcclTreeNode_t nodes[knum_trees];
+    //! First element and number of elements each tree operates on
+    int tree_offset[knum_trees];
+    int tree_count[knum_trees];
+    //! Number of chunks halves are pipelined in, and elements per chunk
+    int num_chunks;
+    int chunk_count;
+    //! Number of steps of each phase, pipeline is as deep as the higher tree
+    int num_steps;
+    //! Grid of a row of step kernels, one row per tree
+    int num_workitems;
+    int num_workgroups;
+    //! Children of current gpu in each tree, if they are leaves and their
+    //! height
+    RingNode_t* child_peers[knum_trees][2];
+    bool child_leaf[knum_trees][2];
+    int child_height[knum_trees][2];
+    int num_child_peers[knum_trees];
+    //! Parent of current gpu in each tree, nullptr for root
+    RingNode_t* parent_peer[knum_trees];
+    //! Distinct parents, children and both of them over both trees
+    RingNode_t* parents[knum_trees];
+    RingNode_t* children[2 * knum_trees];
+    RingNode_t* neighbors[3 * knum_trees];
+    int num_parents;
+    int num_children;
+    int num_neighbors;
+};
+
+//! @brief Launch configuration of recursive halving/doubling allreduce
+//! (RcclInternalAllReduceRhd). Peers are RingNode_t of the sync slot it is
+//! computed for (see RcclGetRhdAllReduceConfig)
+struct RcclRhdAllReduceConfig_t {
+    //! Number of elements in blocks of all gpus except the last one
+    int regular_gpu_count;
+    //! Grid of step kernels, sized for the largest range exchanged
+    int num_workitems;
+    int num_workgroups;
+    //! Partner of current gpu at each distance, which is a power of two
+    RingNode_t* partners[kmax_gpus];
+};
+
+//! @brief Launch configuration of one-shot allreduce
+//! (RcclInternalAllReduceOneShot), see RcclGetOneShotAllReduceConfig
+struct RcclOneShotAllReduceConfig_t {
+    //! Grid of the kernel
+    int num_workitems;
+    int num_workgroups;
+    //! Number of elements reduced between two barriers, and number of rounds
+    int round_count;
+    int num_rounds;
+};
+
+//! @brief Launch configuration of the algorithm an allreduce uses
+//! Persistent plans keep one per sync slot, as peers of a gpu are different
+//! RingNode_t in every slot. Only the member of the algorithm is filled
+struct RcclAllReduceAlgoConfig_t {
+    //! Set once the configuration is computed
+    bool ready;
+    RcclAllReduceConfig_t mesh;
+    RcclRingAllReduceConfig_t ring;
+    RcclTreeAllReduceConfig_t tree;
+    RcclRhdAllReduceConfig_t rhd;
+    RcclOneShotAllReduceConfig_t oneshot;
+};
@@ -0,0 +1,104 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+/**
+ * @file rcclMultiAllReduceKernels.h
+ * @brief Kernel to implement rcclAllReduceMulti
+ *
+ * This file contains the kernel which does allreduce on a batch of tensors.
+ * Each gpu publishes a table of RcclTensor_t of the batch in its source slot
+ * instead of a buffer, and finds buffers of every tensor on every gpu through
+ * the tables.
+ */
+
+#pragma once
+
+#include "rcclBarrierKernels.h"
+#include "rcclPeerTable.h"
+#include "rcclVectorAllReduceKernels.h"
+#include "rcclVectorOps.h"
+
+//! @brief Definition of RcclLoadTensorPeers
+//! tables holds RcclTensor_t table of each gpu in src_buffer, as loaded by
+//! RcclLoadPeerTable. First workitem of workgroup fills peers with buffers of
+//! tensor t of each gpu. Must be called by all workitems of the workgroup
+__device__ inline void RcclLoadTensorPeers(const RcclPeerTable_t& tables,
+                                           int t, RcclPeerTable_t* peers) {
+    //! Wait until all workitems are done with previous tensor
+    __syncthreads();
+    if (threadIdx.x == 0) {
+        peers->num_gpus = tables.num_gpus;
+        for (int i = 0; i < tables.num_gpus; i++) {
+            const RcclTensor_t* table =
+                reinterpret_cast<const RcclTensor_t*>(tables.src_buffer[i]);
+            peers->src_buffer[i] = table[t].src_buffer;
+            peers->dst_buffer[i] = table[t].dst_buffer;
+            peers->rank[i] = tables.rank[i];
+        }
+    }
+    __syncthreads();
+}
+
+//! @brief Definition of RcclKernelMultiAllReduce
+//! Whole rcclAllReduceMulti in one kernel, phases are separated by
+//! RcclGridBarrierWait as in fused mode. Each tensor is split among gpus the
+//! same way RcclInternalAllReduce splits a buffer, current gpu reduces its
+//! chunk of every tensor, then copies chunks of every tensor reduced by peer
+//! gpus from their destination buffers. Rows of workgroups (blockIdx.y)
+//! stride over tensors, workitems of a row stride over the chunk. Uses barrier
+//! instances this_time (tables published), this_time + 1 (chunks reduced) and
+//! this_time + 2 (peers done reading). If NumGpus is not 0, it is the number
+//! of gpus in clique
+template <typename DataType_t, typename VectorType_t, rcclRedOp_t Op,
+          int NumGpus>
+__global__ void RcclKernelMultiAllReduce(RingNode_t* pcurr_track,
+                                         RcclTensor_t* ptensors,
+                                         int num_tensors, int rank,
+                                         int this_time, int num_gpus) {
+    //! Publish table of current gpu instead of a source buffer
+    if (blockIdx.x == 0 && blockIdx.y == 0 && threadIdx.x == 0) {
+        pcurr_track->slots->src_buffer = ptensors;
+    }
+    RcclGridBarrierWait(pcurr_track, this_time, num_gpus);
+
+    //! Get tables of all gpus once per workgroup
+    __shared__ RcclPeerTable_t tables;
+    RcclLoadPeerTable(pcurr_track, &tables);
+
+    __shared__ RcclPeerTable_t peers;
+    for (int t = blockIdx.y; t < num_tensors; t += gridDim.y) {
+        RcclLoadTensorPeers(tables, t, &peers);
+
+        int count = ptensors[t].count;
+        int offset = (count / num_gpus) * rank;
+        int op_count =
+            rank == num_gpus - 1 ? count - offset : count / num_gpus;
+
+        RcclAllReduceVectorRange<DataType_t, VectorType_t, Op, NumGpus>(
+            peers, peers.src_buffer[0], peers.dst_buffer[0], op_count, offset);
+    }
+    RcclGridBarrierWait(pcurr_track, this_time + 1, num_gpus);
+
+    for (int t = blockIdx.y; t < num_tensors; t += gridDim.y) {
+        RcclLoadTensorPeers(tables, t, &peers);
+
+        int count = ptensors[t].count;
+        int regular_count = count / num_gpus;
+
+        DataType_t* dst = reinterpret_cast<DataType_t*>(peers.dst_buffer[0]);
+        for (int peer = 1; peer < peers.num_gpus; peer++) {
+            int offset = regular_count * peers.rank[peer];
+            int peer_count = peers.rank[peer] == num_gpus - 1
+                                 ? count - offset
+                                 : regular_count;
+            RcclCopyVectorRange<DataType_t, VectorType_t>(
+                dst + offset,
+                reinterpret_cast<const DataType_t*>(peers.dst_buffer[peer]) +
+                    offset,
+                peer_count);
+        }
+    }
+    RcclGridBarrierWait(pcurr_track, this_time + 2, num_gpus);
+}
@@ -0,0 +1,63 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+/**
+ * @file rcclMultiAllReduceRuntime.h
+ * @brief Host code which launches kernel to do rcclAllReduceMulti
+ *
+ * This file contains host code which launches the kernel implementing
+ * rcclAllReduceMulti, allreduce on a batch of tensors with a single launch
+ * and a single sync phase for the whole batch.
+ */
+
+#pragma once
+
+#include <algorithm>
+
+#include "rcclLaunch.h"
+#include "rcclMultiAllReduceKernels.h"
+#include "rcclSync.h"
+
+//! @brief Definition of RcclInternalAllReduceMulti
+//! Table of tensors of current gpu is in device memory at ptensors. The
+//! kernel publishes it instead of a source buffer and does the whole batch,
+//! see RcclKernelMultiAllReduce. It spins on barriers from all of its
+//! workgroups, so the grid is sized like fused kernels (see
+//! rcclFusedRuntime.h). max_count is the number of elements in the largest
+//! tensor
+template <typename DataType_t, typename VectorType_t, rcclRedOp_t Op,
+          int NumGpus>
+void RcclInternalAllReduceMulti(RingNode_t* pcurr_track,
+                                RcclTensor_t* ptensors, int num_tensors,
+                                int max_count, hipStream_t stream,
+                                int num_gpus, int rank, hipEvent_t event,
+                                int* this_time) {
+    //! One row of workgroups per tensor, up to a row per workgroup the kernel
+    //! can keep resident
+    int max_rows =
+        static_cast<int>(pcurr_track->max_workgroups) / knum_sync_slots;
+    int num_rows = std::max(std::min(num_tensors, max_rows), 1);
+
+    int num_workitems = 0, num_workgroups = 0;
+    RcclGetVectorLaunchDims<DataType_t, VectorType_t>(
+        pcurr_track, max_count / num_gpus + max_count % num_gpus,
+        &num_workitems, &num_workgroups, num_rows * knum_sync_slots);
+
+    //! Flush gpu l2 cache, the table is written by hipMemcpyAsync which does
+    //! not end with a system scope release like rccl kernels
+    hipEventRecord(event, stream);
+
+    //! Kernel publishes table of current gpu itself
+    RcclInternalForgetPtrs(pcurr_track);
+
+    hipLaunchKernelGGL(
+        (RcclKernelMultiAllReduce<DataType_t, VectorType_t, Op, NumGpus>),
+        dim3(num_workgroups, num_rows, 1), dim3(num_workitems, 1, 1), 0,
+        stream, pcurr_track, ptensors, num_tensors, rank, *this_time,
+        num_gpus);
+
+    //! Kernel used three barrier instances
+    *this_time += 3;
+}
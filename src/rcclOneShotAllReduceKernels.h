@@ -0,0 +1,99 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+#pragma once
+
+/**
+ * @file rcclOneShotAllReduceKernels.h
+ * @brief Kernel to implement one-shot allreduce
+ *
+ * This file contains implementation of single kernel allreduce used for tiny
+ * buffers, where launch and barrier overhead dominates
+ */
+
+#include "rcclBarrierKernels.h"
+#include "rcclPeerTable.h"
+#include "rcclReduceOps.h"
+
+//! @brief Definition of RcclKernelAllReduceOneShot
+//! Publish source buffer of current gpu, wait until all gpus published their
+//! source buffers, then read the whole buffer from every peer and reduce it
+//! into recv_buff. Uses barrier instances this_time (entry) and this_time + 1
+//! up to this_time + num_rounds. Only the first workgroup enters entry
+//! barrier, other workgroups wait until it is done.
+//! Buffer is reduced in rounds of round_count elements. Peers read send_buff
+//! of current gpu, which is recv_buff if op is in place, so results of a
+//! round are kept in scratch and stored to recv_buff only once all gpus
+//! crossed the barrier which ends the round. The last one also makes sure
+//! that the kernel, and so the op, does not finish while peers are still
+//! reading send_buff.
+template <typename DataType_t, rcclRedOp_t Op>
+__global__ void RcclKernelAllReduceOneShot(RingNode_t* pcurr_track,
+                                           const void* send_buff,
+                                           void* recv_buff, void* scratch,
+                                           int count, int round_count,
+                                           int this_time, int num_gpus) {
+    int tx = threadIdx.x;
+    int bx = blockIdx.x;
+    int tid = tx + bx * blockDim.x;
+    int stride = blockDim.x * gridDim.x;
+
+    Barrier_t* barrier = pcurr_track->barrier;
+
+    //! Publish source buffer and wait until all gpus published theirs
+    if (tx == 0) {
+        if (bx == 0) {
+            pcurr_track->slots->src_buffer = const_cast<void*>(send_buff);
+            __threadfence_system();
+            RcclBarrierWait(barrier, pcurr_track->rank, this_time, num_gpus);
+        } else {
+            RcclBarrierWaitDone(barrier, this_time, num_gpus);
+        }
+    }
+    __syncthreads();
+
+    //! Get published source buffers once per workgroup
+    __shared__ RcclPeerTable_t peers;
+    RcclLoadPeerTable(pcurr_track, &peers);
+
+    //! Results can go to recv_buff right away if no peer reads it
+    bool in_place = send_buff == recv_buff;
+    DataType_t* dst_buff = reinterpret_cast<DataType_t*>(recv_buff);
+    DataType_t* scratch_buff = reinterpret_cast<DataType_t*>(scratch);
+
+    for (int begin = 0; begin < count; begin += round_count) {
+        int end = count - begin < round_count ? count : begin + round_count;
+
+        for (int i = begin + tid; i < end; i += stride) {
+            DataType_t result =
+                reinterpret_cast<const DataType_t*>(send_buff)[i];
+
+            //! Iterate over all the gpus, gather data from them and do
+            //! reduction operation on them
+            for (int peer = 1; peer < peers.num_gpus; peer++) {
+                const DataType_t* next_src_buff =
+                    reinterpret_cast<const DataType_t*>(
+                        peers.src_buffer[peer]);
+                RcclReduceOp<DataType_t, Op>(result, next_src_buff[i]);
+            }
+
+            if (in_place) {
+                scratch_buff[i - begin] = result;
+            } else {
+                dst_buff[i] = result;
+            }
+        }
+
+        //! Wait until all gpus are done reading elements of the round
+        RcclGridBarrierWait(pcurr_track, this_time + 1 + begin / round_count,
+                            num_gpus);
+
+        if (in_place) {
+            for (int i = begin + tid; i < end; i += stride) {
+                dst_buff[i] = scratch_buff[i - begin];
+            }
+        }
+    }
+}
@@ -0,0 +1,79 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+/**
+ * @file rcclOneShotAllReduceRuntime.h
+ * @brief Host code which launches kernel to do one-shot rcclAllReduce
+ *
+ * This file contains host code which launches the single kernel implementing
+ * rcclAllReduce for tiny buffers
+ */
+
+#pragma once
+
+#include "rcclLaunch.h"
+#include "rcclOneShotAllReduceKernels.h"
+#include "rcclSync.h"
+
+extern int RCCL_TRACE_RT;
+
+//! @brief Definition of RcclGetOneShotAllReduceConfig
+//! Compute launch configuration of RcclInternalAllReduceOneShot for count
+//! elements of type_size bytes
+inline void RcclGetOneShotAllReduceConfig(
+    const RingNode_t* pcurr_track, int count, size_t type_size,
+    RcclOneShotAllReduceConfig_t* config) {
+    //! Grid is capped at a share of RingNode_t::max_workgroups, so all
+    //! workgroups are resident while they spin on the barrier, even with other
+    //! collectives in flight
+    RcclGetLaunchDims(pcurr_track, count, &(config->num_workitems),
+                      &(config->num_workgroups), knum_sync_slots);
+
+    //! Number of rounds depends only on count, so it is same on all gpus
+    //! whether the op is in place on them or not
+    config->round_count = static_cast<int>(kone_shot_round_bytes / type_size);
+    config->num_rounds =
+        (count + config->round_count - 1) / config->round_count;
+}
+
+//! @brief Definition of RcclInternalAllReduceOneShot
+//! Each gpu reads the whole buffer from every peer and reduces it locally
+//! into its destination buffer. Unlike RcclInternalAllReduce there is no
+//! CopyRest phase, and pointer publishing, barriers and reduction are done in
+//! a single kernel. It reads n - 1 times more data than RcclInternalAllReduce,
+//! so it is only a win for tiny buffers. Results of in-place ops are staged in
+//! scratch, of kone_shot_round_bytes, before they overwrite send_buff. If
+//! pconfig is not nullptr, it is the launch configuration computed by a
+//! persistent plan, otherwise it is computed on every call.
+template <typename DataType_t, typename VectorType_t, rcclRedOp_t Op>
+void RcclInternalAllReduceOneShot(RingNode_t* pcurr_track,
+                                  const void* send_buff, void* recv_buff,
+                                  void* scratch, hipStream_t stream, int count,
+                                  int num_gpus, int* this_time,
+                                  const RcclOneShotAllReduceConfig_t* pconfig =
+                                      nullptr) {
+    //! Use configuration computed by a plan if there is one
+    RcclOneShotAllReduceConfig_t config;
+    if (pconfig != nullptr) {
+        config = *pconfig;
+    } else {
+        RcclGetOneShotAllReduceConfig(pcurr_track, count, sizeof(DataType_t),
+                                      &config);
+    }
+
+    int barrier_value = *this_time;
+
+    //! Kernel publishes buffers of current gpu itself
+    RcclInternalForgetPtrs(pcurr_track);
+
+    hipLaunchKernelGGL((RcclKernelAllReduceOneShot<DataType_t, Op>),
+                       dim3(config.num_workgroups, 1, 1),
+                       dim3(config.num_workitems, 1, 1), 0, stream,
+                       pcurr_track, send_buff, recv_buff, scratch, count,
+                       config.round_count, barrier_value, num_gpus);
+
+    //! Kernel used entry barrier instance and one per round
+    *this_time = barrier_value + 1 + config.num_rounds;
+}
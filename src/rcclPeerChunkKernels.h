@@ -0,0 +1,87 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+#pragma once
+
+/**
+ * @file rcclPeerChunkKernels.h
+ * @brief Kernels operating on a chunk shared with one peer gpu
+ *
+ * This file contains kernels which reduce or copy one contiguous chunk of a
+ * buffer between current gpu and a single peer gpu. They are the building
+ * blocks of step based algorithms such as ring allreduce, where each step
+ * talks to only one peer.
+ */
+
+#include "rcclReduceOps.h"
+#include "rcclTracker.h"
+
+//! @brief Definition of RcclKernelReducePeerChunk
+//! Reduce elements [offset, offset + count) of local buffer with the same
+//! elements of peer gpu buffer and store the result to recv_buff. If peer_src
+//! is true, RingNode_t::src_buffer of peer gpu is read, otherwise
+//! RingNode_t::dst_buffer (holding partial results of previous step) is read.
+//! send_buff and recv_buff can be the same buffer.
+template <typename DataType_t, rcclRedOp_t Op>
+__global__ void RcclKernelReducePeerChunk(RingNode_t* ppeer_track,
+                                          const void* send_buff,
+                                          void* recv_buff, bool peer_src,
+                                          int offset, int count) {
+    int tx = threadIdx.x;
+    int bx = blockIdx.x;
+    int tid = tx + bx * blockDim.x;
+    int stride = blockDim.x * gridDim.x;
+
+    //! Get pointer to peer gpu buffer holding its partial result once per
+    //! workgroup
+    __shared__ const DataType_t* peer_buff;
+    if (tx == 0) {
+        peer_buff = reinterpret_cast<const DataType_t*>(
+            peer_src ? ppeer_track->slots->src_buffer
+                     : ppeer_track->slots->dst_buffer);
+    }
+    __syncthreads();
+    RcclAcquireFence();
+
+    for (int i = tid; i < count; i += stride) {
+        int index = i + offset;
+
+        DataType_t result =
+            reinterpret_cast<const DataType_t*>(send_buff)[index];
+        RcclReduceOp<DataType_t, Op>(result, peer_buff[index]);
+
+        reinterpret_cast<DataType_t*>(recv_buff)[index] = result;
+    }
+
+    RcclReleaseFence();
+}
+
+//! @brief Definition of RcclKernelCopyPeerChunk
+//! Copy elements [offset, offset + count) of peer gpu destination buffer to
+//! the same elements of recv_buff
+template <typename DataType_t>
+__global__ void RcclKernelCopyPeerChunk(RingNode_t* ppeer_track,
+                                        void* recv_buff, int offset,
+                                        int count) {
+    int tx = threadIdx.x;
+    int bx = blockIdx.x;
+    int tid = tx + bx * blockDim.x;
+    int stride = blockDim.x * gridDim.x;
+
+    __shared__ const DataType_t* peer_buff;
+    if (tx == 0) {
+        peer_buff = reinterpret_cast<const DataType_t*>(
+            ppeer_track->slots->dst_buffer);
+    }
+    __syncthreads();
+    RcclAcquireFence();
+
+    for (int i = tid; i < count; i += stride) {
+        int index = i + offset;
+        reinterpret_cast<DataType_t*>(recv_buff)[index] = peer_buff[index];
+    }
+
+    RcclReleaseFence();
+}
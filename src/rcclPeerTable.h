@@ -0,0 +1,56 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+/**
+ * @file rcclPeerTable.h
+ * @brief Snapshot of the ring of RingNode_t used by kernels
+ *
+ * RingNode_t is allocated in pinned host memory which is uncached on gpus.
+ * Walking the ring from every workitem for every element costs a round trip
+ * over the bus per peer and per element. Kernels which read buffers of all
+ * the gpus instead copy pointers of the ring to LDS once per workgroup, after
+ * all gpus have published their buffers, and data loops only touch peer data.
+ */
+
+#pragma once
+
+#include "rcclTracker.h"
+
+//! @brief Definition of RcclPeerTable_t
+//! Entry i describes the gpu which is i hops after current gpu in the ring,
+//! entry 0 is current gpu
+struct RcclPeerTable_t {
+    //! Number of valid entries, same as number of gpus in clique
+    int num_gpus;
+    //! Source buffer of each gpu
+    const void* src_buffer[kmax_gpus];
+    //! Destination buffer of each gpu
+    void* dst_buffer[kmax_gpus];
+    //! Rank of each gpu
+    int rank[kmax_gpus];
+};
+
+//! @brief Definition of RcclLoadPeerTable
+//! First workitem of workgroup walks the ring starting at pcurr_track and
+//! fills table, which is expected to be in LDS. Must be called by all
+//! workitems of the workgroup, before they load peer data (see
+//! RcclAcquireFence)
+__device__ inline void RcclLoadPeerTable(RingNode_t* pcurr_track,
+                                         RcclPeerTable_t* table) {
+    if (threadIdx.x == 0) {
+        int num_gpus = 0;
+        RingNode_t* pnode = pcurr_track;
+        do {
+            table->src_buffer[num_gpus] = pnode->slots->src_buffer;
+            table->dst_buffer[num_gpus] = pnode->slots->dst_buffer;
+            table->rank[num_gpus] = pnode->rank;
+            num_gpus++;
+            pnode = pnode->next_gpu;
+        } while (pnode != pcurr_track && num_gpus < kmax_gpus);
+        table->num_gpus = num_gpus;
+    }
+    __syncthreads();
+    RcclAcquireFence();
+}
@@ -0,0 +1,56 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+/**
+ * @file rcclPlan.h
+ * @brief Internal representation of rcclPlan_t
+ *
+ * This file contains the data structure holding an op whose arguments are
+ * checked and whose algorithm, kernels and launch configuration are selected
+ * once, when the plan is created.
+ */
+
+#pragma once
+
+#include "rcclAlgo.h"
+#include "rcclLaunch.h"
+#include "rcclTracker.h"
+
+//! @brief Launch an op on current gpu using algorithm algo, with kernels of a
+//! data type
+typedef void (*RcclLauncher_t)(RcclAlgo_t algo, RcclComm_t* pcomm,
+                               const void* sendbuff, void* recvbuff,
+                               hipStream_t stream, int count);
+
+//! @brief Launch rcclAllReduce on current gpu using algorithm algo, with
+//! kernels of a data type and reduction op. pconfig is launch configuration of
+//! algo computed by a plan for the sync slot, nullptr if it is computed on
+//! launch
+typedef void (*RcclAllReduceLauncher_t)(
+    RcclAlgo_t algo, RcclComm_t* pcomm, const void* sendbuff, void* recvbuff,
+    hipStream_t stream, int count, const RcclAllReduceAlgoConfig_t* pconfig);
+
+//! @brief Internal representation of rcclPlan_t
+struct RcclPlan_t {
+    //! Communicator the plan is created with
+    RcclComm_t* comm_;
+    //! Buffers of the op, they do not change between executions
+    const void* sendbuff_;
+    void* recvbuff_;
+    //! Number of elements in buffers
+    int count_;
+    //! Size of an element in bytes
+    size_t type_size_;
+    //! Size of source buffer in bytes
+    size_t bytes_;
+    //! Algorithm selected when the plan is created
+    RcclAlgo_t algo_;
+    //! Launcher of the op for data type and reduction op of the plan
+    RcclAllReduceLauncher_t launcher_;
+    //! Launch configuration of the algorithm on each sync slot, as peers are
+    //! different RingNode_t in every slot. Computed when the plan is created
+    //! if all gpus joined the pool, on first execution on the slot otherwise
+    RcclAllReduceAlgoConfig_t configs_[knum_sync_slots];
+};
@@ -13,6 +13,7 @@ All rights reserved.
  */
 
 #include "rcclDataTypes.h"
+#include "rcclGroup.h"
 #include "rcclHelper.h"
 #include "rcclSetKernels.h"
 #include "rcclTracker.h"
@@ -28,8 +29,136 @@ extern std::unordered_map<int, std::string> umap_datatype;
 
 extern int RCCL_TRACE_RT;
 
+//! @brief Definition of RcclReduceRoot
+//! Launch rcclReduce on root gpu, use kernels specialized on number of gpus in
+//! clique if there are any, generic ones otherwise
+template <typename DataType_t, typename VectorType_t, rcclRedOp_t Op>
+void RcclReduceRoot(RingNode_t *pcurr_track, int count, hipStream_t stream,
+                    const void *send_buff, void *recv_buff, int *this_time,
+                    int *p2p_time, int num_gpus) {
+    switch (num_gpus) {
+    case 2: {
+        RcclInternalReduce<DataType_t, VectorType_t, Op, 2>(
+            pcurr_track, count, stream, send_buff, recv_buff, this_time,
+            p2p_time, num_gpus);
+        break;
+    }
+    case 3: {
+        RcclInternalReduce<DataType_t, VectorType_t, Op, 3>(
+            pcurr_track, count, stream, send_buff, recv_buff, this_time,
+            p2p_time, num_gpus);
+        break;
+    }
+    case 4: {
+        RcclInternalReduce<DataType_t, VectorType_t, Op, 4>(
+            pcurr_track, count, stream, send_buff, recv_buff, this_time,
+            p2p_time, num_gpus);
+        break;
+    }
+    case 6: {
+        RcclInternalReduce<DataType_t, VectorType_t, Op, 6>(
+            pcurr_track, count, stream, send_buff, recv_buff, this_time,
+            p2p_time, num_gpus);
+        break;
+    }
+    case 8: {
+        RcclInternalReduce<DataType_t, VectorType_t, Op, 8>(
+            pcurr_track, count, stream, send_buff, recv_buff, this_time,
+            p2p_time, num_gpus);
+        break;
+    }
+    case 16: {
+        RcclInternalReduce<DataType_t, VectorType_t, Op, 16>(
+            pcurr_track, count, stream, send_buff, recv_buff, this_time,
+            p2p_time, num_gpus);
+        break;
+    }
+    default: {
+        RcclInternalReduce<DataType_t, VectorType_t, Op, 0>(
+            pcurr_track, count, stream, send_buff, recv_buff, this_time,
+            p2p_time, num_gpus);
+        break;
+    }
+    }
+}
+
+//! @brief Launch rcclReduce on root gpu, with kernels of a data type and
+//! reduction op
+typedef void (*RcclReduceLauncher_t)(RingNode_t *pcurr_track, int count,
+                                     hipStream_t stream, const void *send_buff,
+                                     void *recv_buff, int *this_time,
+                                     int *p2p_time, int num_gpus);
+
+//! @brief Definition of RcclGetReduceLauncher
+//! Get RcclReduceRoot for data type with reduction op Op, nullptr if data type
+//! is not valid
+template <rcclRedOp_t Op>
+RcclReduceLauncher_t RcclGetReduceLauncher(rcclDataType_t datatype) {
+    switch (datatype) {
+    case rcclChar: {
+        return RcclReduceRoot<signed char, rccl_char16_t, Op>;
+    }
+    case rcclUchar: {
+        return RcclReduceRoot<unsigned char, rccl_uchar16_t, Op>;
+    }
+    case rcclShort: {
+        return RcclReduceRoot<signed short, rccl_short8_t, Op>;
+    }
+    case rcclUshort: {
+        return RcclReduceRoot<unsigned short, rccl_ushort8_t, Op>;
+    }
+    case rcclHalf: {
+        return RcclReduceRoot<__fp16, rccl_half8_t, Op>;
+    }
+    case rcclInt: {
+        return RcclReduceRoot<signed int, rccl_int4_t, Op>;
+    }
+    case rcclUint: {
+        return RcclReduceRoot<unsigned int, rccl_uint4_t, Op>;
+    }
+    case rcclFloat: {
+        return RcclReduceRoot<float, rccl_float4_t, Op>;
+    }
+    case rcclLong: {
+        return RcclReduceRoot<signed long, rccl_long2_t, Op>;
+    }
+    case rcclUlong: {
+        return RcclReduceRoot<unsigned long, rccl_ulong2_t, Op>;
+    }
+    case rcclDouble: {
+        return RcclReduceRoot<double, rccl_double2_t, Op>;
+    }
+    default: { return nullptr; }
+    }
+}
+
+//! @brief Definition of RcclGetReduceLauncher
+//! Get RcclReduceRoot for data type and reduction op, nullptr if any of them
+//! is not valid
+RcclReduceLauncher_t RcclGetReduceLauncher(rcclDataType_t datatype,
+                                           rcclRedOp_t op) {
+    switch (op) {
+    case rcclSum: {
+        return RcclGetReduceLauncher<rcclSum>(datatype);
+    }
+    case rcclProd: {
+        return RcclGetReduceLauncher<rcclProd>(datatype);
+    }
+    case rcclMax: {
+        return RcclGetReduceLauncher<rcclMax>(datatype);
+    }
+    case rcclMin: {
+        return RcclGetReduceLauncher<rcclMin>(datatype);
+    }
+    default: { return nullptr; }
+    }
+}
+
 //! @brief Define rcclReduce
-//! Implementation of rcclReduce
+//! Implementation of rcclReduce. All arguments are checked before the op is
+//! recorded in a group or takes a sync slot (see PreEnqueueEventRecord), a gpu
+//! which returns after taking a slot would use different slots than its peers
+//! for every later op
 rcclResult_t rcclReduce(const void *sendbuff, void *recvbuff, int count,
                         rcclDataType_t datatype, rcclRedOp_t op, int root,
                         rcclComm_t comm, hipStream_t stream) {
@@ -75,313 +204,59 @@ rcclResult_t rcclReduce(const void *sendbuff, void *recvbuff, int count,
         return rcclInvalidArgument;
     }
 
-    //! Get current value of barrier
-    int *this_time = &(pcomm->this_time_);
+    //! Check if current gpu is root or not
+    bool is_root = pcomm->rank_ == root;
+
+    //! On root gpu, destination buffer should not be nullptr
+    if (is_root && recvbuff == nullptr) {
+        return rcclInvalidDevicePointer;
+    }
+
+    //! Get kernels for data type and op, which are only launched on root gpu
+    RcclReduceLauncher_t launcher = RcclGetReduceLauncher(datatype, op);
+    if (launcher == nullptr) {
+        return rcclInvalidType;
+    }
+
+    //! Inside a group, the op is launched by rcclGroupEnd
+    if (RcclGroupActive()) {
+        RcclGroupAdd({krccl_coll_reduce, sendbuff, recvbuff, count, datatype,
+                      op, root, pcomm, stream, nullptr, false});
+        return rcclSuccess;
+    }
 
     //! If same comm is used on a different stream, synchronize it with current
     //! stream before launching op.
     PreEnqueueEventRecord(pcomm, stream);
 
-    //! Get current gpu tracker
-    RingNode_t *pcurr_track = pcomm->track_;
+    //! Buffers which are registered and already published need not be
+    //! published again, destination buffer is only written on root gpu
+    size_t bytes = count * RcclGetDataTypeSize(datatype);
+    SetRegisteredBuffers(pcomm, sendbuff, bytes, is_root ? recvbuff : nullptr,
+                         bytes);
 
-    //! Check if current gpu is root or not
-    bool is_root = pcomm->track_->rank == root;
+    //! Get current value of barrier
+    int *this_time = &(pcomm->slot_->this_time_);
 
-    if (is_root) {
-        //! On root gpu, destination buffer should not be nullptr
-        if (recvbuff == nullptr) return rcclInvalidDevicePointer;
-        if (op == rcclSum) {
-            switch (datatype) {
-            case rcclChar: {
-                RcclInternalReduce<signed char, rccl_char16_t, rcclSum>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclUchar: {
-                RcclInternalReduce<unsigned char, rccl_uchar16_t, rcclSum>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclShort: {
-                RcclInternalReduce<signed short, rccl_short8_t, rcclSum>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclUshort: {
-                RcclInternalReduce<unsigned short, rccl_ushort8_t, rcclSum>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclHalf: {
-                RcclInternalReduce<__fp16, rccl_half8_t, rcclSum>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclInt: {
-                RcclInternalReduce<signed int, rccl_int4_t, rcclSum>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclUint: {
-                RcclInternalReduce<unsigned int, rccl_uint4_t, rcclSum>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclFloat: {
-                RcclInternalReduce<float, rccl_float4_t, rcclSum>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclLong: {
-                RcclInternalReduce<signed long, rccl_long2_t, rcclSum>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclUlong: {
-                RcclInternalReduce<unsigned long, rccl_ulong2_t, rcclSum>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclDouble: {
-                RcclInternalReduce<double, rccl_double2_t, rcclSum>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            default: { return rcclInvalidType; }
-            }
-        }
-        if (op == rcclProd) {
-            switch (datatype) {
-            case rcclChar: {
-                RcclInternalReduce<signed char, rccl_char16_t, rcclProd>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclUchar: {
-                RcclInternalReduce<unsigned char, rccl_uchar16_t, rcclProd>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclShort: {
-                RcclInternalReduce<signed short, rccl_short8_t, rcclProd>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclUshort: {
-                RcclInternalReduce<unsigned short, rccl_ushort8_t, rcclProd>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclHalf: {
-                RcclInternalReduce<__fp16, rccl_half8_t, rcclProd>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclInt: {
-                RcclInternalReduce<signed int, rccl_int4_t, rcclProd>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclUint: {
-                RcclInternalReduce<unsigned int, rccl_uint4_t, rcclProd>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclFloat: {
-                RcclInternalReduce<float, rccl_float4_t, rcclProd>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclLong: {
-                RcclInternalReduce<signed long, rccl_long2_t, rcclProd>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclUlong: {
-                RcclInternalReduce<unsigned long, rccl_ulong2_t, rcclProd>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclDouble: {
-                RcclInternalReduce<double, rccl_double2_t, rcclProd>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            default: { return rcclInvalidType; }
-            }
-        }
+    //! Get how many collectives used point-to-point flags
+    int *p2p_time = &(pcomm->slot_->p2p_time_);
 
-        if (op == rcclMax) {
-            switch (datatype) {
-            case rcclChar: {
-                RcclInternalReduce<signed char, rccl_char16_t, rcclMax>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclUchar: {
-                RcclInternalReduce<unsigned char, rccl_uchar16_t, rcclMax>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclShort: {
-                RcclInternalReduce<signed short, rccl_short8_t, rcclMax>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclUshort: {
-                RcclInternalReduce<unsigned short, rccl_ushort8_t, rcclMax>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclHalf: {
-                RcclInternalReduce<__fp16, rccl_half8_t, rcclMax>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclInt: {
-                RcclInternalReduce<signed int, rccl_int4_t, rcclMax>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclUint: {
-                RcclInternalReduce<unsigned int, rccl_uint4_t, rcclMax>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclFloat: {
-                RcclInternalReduce<float, rccl_float4_t, rcclMax>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclLong: {
-                RcclInternalReduce<signed long, rccl_long2_t, rcclMax>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclUlong: {
-                RcclInternalReduce<unsigned long, rccl_ulong2_t, rcclMax>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclDouble: {
-                RcclInternalReduce<double, rccl_double2_t, rcclMax>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            default: { return rcclInvalidType; }
-            }
-        }
+    //! Get current gpu tracker
+    RingNode_t *pcurr_track = pcomm->slot_->track_;
 
-        if (op == rcclMin) {
-            switch (datatype) {
-            case rcclChar: {
-                RcclInternalReduce<signed char, rccl_char16_t, rcclMin>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclUchar: {
-                RcclInternalReduce<unsigned char, rccl_uchar16_t, rcclMin>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclShort: {
-                RcclInternalReduce<signed short, rccl_short8_t, rcclMin>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclUshort: {
-                RcclInternalReduce<unsigned short, rccl_ushort8_t, rcclMin>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclHalf: {
-                RcclInternalReduce<__fp16, rccl_half8_t, rcclMin>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclInt: {
-                RcclInternalReduce<signed int, rccl_int4_t, rcclMin>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclUint: {
-                RcclInternalReduce<unsigned int, rccl_uint4_t, rcclMin>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclFloat: {
-                RcclInternalReduce<float, rccl_float4_t, rcclMin>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclLong: {
-                RcclInternalReduce<signed long, rccl_long2_t, rcclMin>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclUlong: {
-                RcclInternalReduce<unsigned long, rccl_ulong2_t, rcclMin>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            case rcclDouble: {
-                RcclInternalReduce<double, rccl_double2_t, rcclMin>(
-                    pcurr_track, count, stream, sendbuff, recvbuff, this_time,
-                    num_gpus);
-                break;
-            }
-            default: { return rcclInvalidType; }
-            }
+    if (is_root) {
+        launcher(pcurr_track, count, stream, sendbuff, recvbuff, this_time,
+                 p2p_time, num_gpus);
+    } else {
+        //! Get RingNode for root gpu
+        RingNode_t *proot_track = pcurr_track->next_gpu;
+        while (proot_track->rank != root) {
+            proot_track = proot_track->next_gpu;
         }
 
-    } else {
         //! Call for non-root gpu
-        RcclInternalReduceNotRoot(pcurr_track, stream, sendbuff, this_time,
-                                  num_gpus);
+        RcclInternalReduceNotRoot(pcurr_track, proot_track, stream, sendbuff,
+                                  this_time, p2p_time, num_gpus);
     }
 
     //! Track current stream so that op launched on different stream can be
@@ -389,3 +264,43 @@ rcclResult_t rcclReduce(const void *sendbuff, void *recvbuff, int count,
     PostEnqueueEventRecord(pcomm, stream);
     return rcclSuccess;
 }
+
+//! @brief Definition of rcclReduce64
+rcclResult_t rcclReduce64(const void *sendbuff, void *recvbuff, size_t count,
+                          rcclDataType_t datatype, rcclRedOp_t op, int root,
+                          rcclComm_t comm, hipStream_t stream) {
+    if ((RCCL_TRACE_RT & krccl_print_api) == krccl_print_api) {
+        fprintf(stderr,
+                "%s<<rccl-api:%s sendbuff:%p recvbuff:%p count:%zu "
+                "datatype:%s op:%s root:%d comm:%p stream:%p%s\n",
+                API_COLOR, __func__, sendbuff, recvbuff, count,
+                umap_datatype[datatype].c_str(), umap_red_op[op].c_str(), root,
+                comm, stream, API_COLOR_END);
+    }
+
+    //! Buffers up to kmax_chunk_count elements, or with no elements, are
+    //! reduced by a single op which checks the arguments
+    if (count <= kmax_chunk_count) {
+        return rcclReduce(sendbuff, recvbuff, static_cast<int>(count),
+                          datatype, op, root, comm, stream);
+    }
+
+    //! Every chunk is an op of its own, same on all gpus as count is.
+    //! Destination buffer of non-root gpus can be nullptr
+    size_t type_size = RcclGetDataTypeSize(datatype);
+    size_t offset = 0;
+    while (offset < count) {
+        int chunk_count =
+            static_cast<int>(std::min(count - offset, kmax_chunk_count));
+        rcclResult_t result = rcclReduce(
+            RcclOffsetPtr(sendbuff, offset * type_size),
+            RcclOffsetPtr(recvbuff, offset * type_size), chunk_count, datatype,
+            op, root, comm, stream);
+        if (result != rcclSuccess) {
+            return result;
+        }
+        offset += chunk_count;
+    }
+
+    return rcclSuccess;
+}
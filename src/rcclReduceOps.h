@@ -0,0 +1,27 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+/**
+ * @file rcclReduceOps.h
+ * @brief Device helpers implementing reduction operations
+ *
+ * This file contains device functions which apply rcclRedOp_t on two values
+ */
+
+#pragma once
+
+#include <hip/hip_runtime.h>
+#include "rccl/rccl.h"
+
+//! @brief Definition of RcclReduceOp
+//! Do reduction op on result and val, and store it back to result. Elements
+//! are passed by reference as __fp16 can not be passed by value
+template <typename DataType_t, rcclRedOp_t Op>
+__device__ inline void RcclReduceOp(DataType_t& result, const DataType_t& val) {
+    if (Op == rcclSum) result = result + val;
+    if (Op == rcclProd) result = result * val;
+    if (Op == rcclMax) result = result > val ? result : val;
+    if (Op == rcclMin) result = result < val ? result : val;
+}
@@ -0,0 +1,146 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+/**
+ * @file rcclRhdAllReduceRuntime.h
+ * @brief Host code which launches kernels to do recursive halving/doubling
+ * rcclAllReduce
+ *
+ * This file contains host code which launches kernels implementing
+ * rcclAllReduce as a recursive halving reduce-scatter followed by a recursive
+ * doubling allgather. It is only valid when number of gpus is a power of two.
+ */
+
+#pragma once
+
+#include <algorithm>
+
+#include "rcclLaunch.h"
+#include "rcclPeerChunkKernels.h"
+#include "rcclSync.h"
+
+extern int RCCL_TRACE_RT;
+
+//! @brief Definition of RcclGetRhdAllReduceConfig
+//! Compute launch configuration of RcclInternalAllReduceRhd for count
+//! elements, with partners from sync slot of pcurr_track
+inline void RcclGetRhdAllReduceConfig(RingNodePool_t* ppool,
+                                      const RingNode_t* pcurr_track, int count,
+                                      int num_gpus, int rank,
+                                      RcclRhdAllReduceConfig_t* config) {
+    //! Blocks held by each gpu are same as in RcclInternalAllReduce
+    config->regular_gpu_count = count / num_gpus;
+
+    //! Largest range exchanged is upper half of the buffer, which holds the
+    //! last block
+    int max_step_count = count - (num_gpus / 2) * config->regular_gpu_count;
+
+    RcclGetLaunchDims(pcurr_track, max_step_count, &(config->num_workitems),
+                      &(config->num_workgroups));
+
+    //! RingNode_t of all gpus in sync slot of current gpu, by rank
+    std::map<int, RingNode_t*>& slot_pool = ppool->pool_[pcurr_track->slot];
+    for (int distance = 1; distance < num_gpus; distance *= 2) {
+        config->partners[distance] = slot_pool[rank ^ distance];
+    }
+}
+
+//! @brief Definition of RcclInternalAllReduceRhd
+//! Buffer is split into n blocks (same partitioning as RcclInternalAllReduce)
+//! where n is number of gpus. The op is done in 2 * log2(n) steps, in each
+//! step a gpu exchanges data with exactly one partner gpu.
+//! - Recursive halving: in step k, partner is rank ^ (n >> (k + 1)). The
+//! range of blocks a gpu is responsible for is halved, gpu keeps upper half if
+//! the bit it differs from partner is set. It reduces kept half with partner's
+//! partial result of the same half. After log2(n) steps, gpu with rank r holds
+//! final result of block r.
+//! - Recursive doubling: in step k, partner is rank ^ (1 << k). Gpu copies the
+//! range of blocks partner holds, doubling its own range.
+//! Steps are separated by a multi-gpu barrier, step kernels release their
+//! stores to the system so no l2 flush is needed. If pconfig is not nullptr,
+//! it is the launch configuration computed by a persistent plan for the sync
+//! slot, otherwise it is computed on every call.
+template <typename DataType_t, typename VectorType_t, rcclRedOp_t Op>
+void RcclInternalAllReduceRhd(RingNodePool_t* ppool, RingNode_t* pcurr_track,
+                              const void* send_buff, void* recv_buff,
+                              hipStream_t stream, int count, int num_gpus,
+                              int rank, int* this_time,
+                              const RcclRhdAllReduceConfig_t* pconfig =
+                                  nullptr) {
+    //! Use configuration computed by a plan if there is one
+    RcclRhdAllReduceConfig_t config;
+    if (pconfig != nullptr) {
+        config = *pconfig;
+    } else {
+        RcclGetRhdAllReduceConfig(ppool, pcurr_track, count, num_gpus, rank,
+                                  &config);
+    }
+    int regular_gpu_count = config.regular_gpu_count;
+    int num_workitems = config.num_workitems;
+    int num_workgroups = config.num_workgroups;
+
+    //! Get offset of first element of block
+    auto block_offset = [=](int block) {
+        return block == num_gpus ? count : block * regular_gpu_count;
+    };
+
+    int barrier_value = *this_time;
+
+    //! Set source and destination buffers for current gpu
+    RcclInternalSetSrcDstPtr(pcurr_track, stream, send_buff, recv_buff);
+
+    //! Wait until all the gpus set their source and destination buffers
+    RcclInternalBarrierWait(pcurr_track, stream, barrier_value++, num_gpus);
+
+    //! Recursive halving, [lo, hi) is the range of blocks current gpu is
+    //! responsible for
+    int lo = 0, hi = num_gpus;
+    for (int distance = num_gpus / 2; distance > 0; distance /= 2) {
+        int mid = (lo + hi) / 2;
+        if (rank & distance) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+
+        bool first_step = distance == num_gpus / 2;
+        RingNode_t* ppeer_track = config.partners[distance];
+
+        //! Partial result of previous step is in destination buffer of both
+        //! gpus
+        hipLaunchKernelGGL((RcclKernelReducePeerChunk<DataType_t, Op>),
+                           dim3(num_workgroups, 1, 1),
+                           dim3(num_workitems, 1, 1), 0, stream, ppeer_track,
+                           first_step ? send_buff : recv_buff, recv_buff,
+                           first_step, block_offset(lo),
+                           block_offset(hi) - block_offset(lo));
+
+        //! Wait until every gpu finished current step
+        RcclInternalBarrierWait(pcurr_track, stream, barrier_value++, num_gpus);
+    }
+
+    //! Recursive doubling, current gpu holds distance blocks starting at lo
+    //! and partner holds the same number of blocks starting at lo ^ distance
+    for (int distance = 1; distance < num_gpus; distance *= 2) {
+        int peer_lo = lo ^ distance;
+        RingNode_t* ppeer_track = config.partners[distance];
+
+        hipLaunchKernelGGL((RcclKernelCopyPeerChunk<DataType_t>),
+                           dim3(num_workgroups, 1, 1),
+                           dim3(num_workitems, 1, 1), 0, stream, ppeer_track,
+                           recv_buff, block_offset(peer_lo),
+                           block_offset(peer_lo + distance) -
+                               block_offset(peer_lo));
+
+        lo = std::min(lo, peer_lo);
+
+        //! Wait until every gpu finished current step. The last one also
+        //! makes sure no gpu exits while its buffers are still being read
+        RcclInternalBarrierWait(pcurr_track, stream, barrier_value++, num_gpus);
+    }
+
+    //! Update communicator with update barrier count
+    *this_time = barrier_value;
+}
@@ -0,0 +1,110 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+/**
+ * @file rcclRingAllGatherRuntime.h
+ * @brief Host code which launches kernels to do ring based rcclAllGather
+ *
+ * This file contains host code which launches kernels implementing
+ * rcclAllGather over rings of one or more channels
+ */
+
+#pragma once
+
+#include <algorithm>
+
+#include "rcclChannel.h"
+#include "rcclLaunch.h"
+#include "rcclRingKernels.h"
+#include "rcclSync.h"
+
+extern int RCCL_TRACE_RT;
+
+//! @brief Definition of RcclInternalAllGatherRing
+//! Each gpu copies its source buffer to its slot in destination buffer. Slots
+//! are split into num_channels contiguous channels, every channel goes around
+//! its own ring (see rcclChannel.h) and all channels run at the same time
+//! with channel index in blockIdx.y. In step s of n - 1 steps, gpu at
+//! position p of ring of a channel copies the channel of slot of gpu at
+//! position (p - s - 1) mod n from destination buffer of previous gpu, which
+//! previous gpu got in step s - 1.
+//! Steps are separated by a multi-gpu barrier, step kernels release their
+//! stores to the system so no l2 flush is needed.
+template <typename DataType_t, typename VectorType_t>
+void RcclInternalAllGatherRing(RingNodePool_t* ppool, RingNode_t* pcurr_track,
+                               const void* send_buff, void* recv_buff,
+                               hipStream_t stream, int count, int num_gpus,
+                               int rank, int num_channels, hipEvent_t event,
+                               int* this_time) {
+    int num_workitems = 0, num_workgroups = 0;
+
+    //! Give every channel at least a workgroup worth of elements
+    num_channels = std::min(num_channels, kmax_channels);
+    num_channels =
+        std::min(num_channels, count / static_cast<int>(knum_workitems));
+    num_channels = std::max(num_channels, 1);
+
+    int regular_channel_count = count / num_channels;
+    int last_channel_count = regular_channel_count + count % num_channels;
+
+    RcclGetLaunchDims(pcurr_track, last_channel_count, &num_workitems,
+                      &num_workgroups, num_channels);
+
+    //! RingNode_t lives in host memory, so previous gpu in ring of each
+    //! channel can be found on host
+    //! RingNode_t of all gpus in sync slot of current gpu, by rank
+    std::map<int, RingNode_t*>& slot_pool = ppool->pool_[pcurr_track->slot];
+    RcclChannelRing_t rings[kmax_channels];
+    RcclRingStep_t step;
+    for (int channel = 0; channel < num_channels; channel++) {
+        RcclGetChannelRing(num_gpus, rank, channel, &rings[channel]);
+        step.peers[channel] = slot_pool[rings[channel].prev];
+        step.count[channel] = channel == num_channels - 1
+                                  ? last_channel_count
+                                  : regular_channel_count;
+    }
+
+    int barrier_value = *this_time;
+
+    //! Set source and destination buffers for current gpu
+    RcclInternalSetSrcDstPtr(pcurr_track, stream, send_buff, recv_buff);
+
+    //! Copy source buffer to slot of current gpu, unless op is in place
+    DataType_t* own_slot = reinterpret_cast<DataType_t*>(recv_buff) +
+                           static_cast<size_t>(rank) * count;
+    if (own_slot != send_buff) {
+        hipMemcpyAsync(own_slot, send_buff, count * sizeof(DataType_t),
+                       hipMemcpyDeviceToDevice, stream);
+
+        //! Flush gpu l2 cache, the copy does not end with a system scope
+        //! release like rccl kernels
+        hipEventRecord(event, stream);
+    }
+
+    //! Wait until all the gpus set their buffers and own slot
+    RcclInternalBarrierWait(pcurr_track, stream, barrier_value++, num_gpus);
+
+    for (int s = 0; s < num_gpus - 1; s++) {
+        for (int channel = 0; channel < num_channels; channel++) {
+            int slot = RcclGetChannelRank(
+                num_gpus, channel,
+                (rings[channel].position - s - 1 + num_gpus) % num_gpus);
+            step.offset[channel] = static_cast<size_t>(slot) * count +
+                                   channel * regular_channel_count;
+        }
+
+        hipLaunchKernelGGL((RcclKernelRingCopyStep<DataType_t>),
+                           dim3(num_workgroups, num_channels, 1),
+                           dim3(num_workitems, 1, 1), 0, stream, step,
+                           recv_buff);
+
+        //! Wait until every gpu finished current step. The last one also
+        //! makes sure no gpu exits while its buffers are still being read
+        RcclInternalBarrierWait(pcurr_track, stream, barrier_value++, num_gpus);
+    }
+
+    //! Update communicator with update barrier count
+    *this_time = barrier_value;
+}
@@ -0,0 +1,232 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+/**
+ * @file rcclRingAllReduceRuntime.h
+ * @brief Host code which launches kernels to do ring based rcclAllReduce
+ *
+ * This file contains host code which launches kernels implementing
+ * rcclAllReduce as a reduce-scatter followed by an allgather over rings of
+ * one or more channels
+ */
+
+#pragma once
+
+#include <algorithm>
+
+#include "rcclChannel.h"
+#include "rcclLaunch.h"
+#include "rcclRingKernels.h"
+#include "rcclSync.h"
+
+extern int RCCL_TRACE_RT;
+
+//! @brief Fill slice of a chunk of a channel in ring step
+//! Channel operating on channel_count elements starting at channel_offset is
+//! split into num_gpus chunks the same way RcclInternalAllReduce splits the
+//! buffer, each chunk is split into num_slices slices
+inline void RcclSetRingStepChunk(RcclRingStep_t* step, int channel,
+                                 int channel_offset, int channel_count,
+                                 int chunk, int num_gpus, int slice,
+                                 int num_slices) {
+    int regular_chunk_count = channel_count / num_gpus;
+    int chunk_count = (chunk == num_gpus - 1)
+                          ? regular_chunk_count + channel_count % num_gpus
+                          : regular_chunk_count;
+    int slice_count = (chunk_count + num_slices - 1) / num_slices;
+    int offset = slice * slice_count;
+    step->offset[channel] =
+        channel_offset + chunk * regular_chunk_count + offset;
+    step->count[channel] =
+        std::max(0, std::min(slice_count, chunk_count - offset));
+}
+
+//! @brief Definition of RcclGetRingAllReduceConfig
+//! Compute launch configuration of RcclInternalAllReduceRing for elements of
+//! type_size bytes, with peers from sync slot of pcurr_track. Every chunk of a
+//! channel gets at least a workgroup worth of elements
+inline void RcclGetRingAllReduceConfig(RingNodePool_t* ppool,
+                                       const RingNode_t* pcurr_track,
+                                       int count, size_t type_size,
+                                       int num_gpus, int rank,
+                                       int num_channels,
+                                       RcclRingAllReduceConfig_t* config) {
+    num_channels = std::min(num_channels, kmax_channels);
+    num_channels = std::min(
+        num_channels, count / (num_gpus * static_cast<int>(knum_workitems)));
+    config->num_channels = std::max(num_channels, 1);
+
+    config->regular_channel_count = count / config->num_channels;
+    config->last_channel_count =
+        config->regular_channel_count + count % config->num_channels;
+
+    //! Largest chunk is the last chunk of the last channel
+    int max_chunk_count = config->last_channel_count / num_gpus +
+                          config->last_channel_count % num_gpus;
+
+    //! Split chunks into slices and size grid for largest slice
+    int num_slices = static_cast<int>(
+        (max_chunk_count * type_size + kring_slice_bytes - 1) /
+        kring_slice_bytes);
+    config->num_slices = std::min(std::max(num_slices, 1), kmax_ring_slices);
+    int max_slice_count =
+        (max_chunk_count + config->num_slices - 1) / config->num_slices;
+    RcclGetLaunchDims(pcurr_track, max_slice_count, &(config->num_workitems),
+                      &(config->num_workgroups), config->num_channels);
+
+    //! RingNode_t lives in host memory, so previous and next gpu in ring of
+    //! each channel can be found on host
+    //! RingNode_t of all gpus in sync slot of current gpu, by rank
+    std::map<int, RingNode_t*>& slot_pool = ppool->pool_[pcurr_track->slot];
+    config->num_prevs = 0;
+    config->num_nexts = 0;
+    for (int channel = 0; channel < config->num_channels; channel++) {
+        RcclChannelRing_t* ring = &(config->rings[channel]);
+        RcclGetChannelRing(num_gpus, rank, channel, ring);
+        RingNode_t* pprev_track = slot_pool[ring->prev];
+        RingNode_t* pnext_track = slot_pool[ring->next];
+        config->peers[channel] = pprev_track;
+        RingNode_t** prevs_end = config->prevs + config->num_prevs;
+        if (std::find(config->prevs, prevs_end, pprev_track) == prevs_end) {
+            config->prevs[config->num_prevs++] = pprev_track;
+        }
+        RingNode_t** nexts_end = config->nexts + config->num_nexts;
+        if (std::find(config->nexts, nexts_end, pnext_track) == nexts_end) {
+            config->nexts[config->num_nexts++] = pnext_track;
+        }
+    }
+}
+
+//! @brief Definition of RcclInternalAllReduceRing
+//! Buffer is split into num_channels contiguous channels, each channel is
+//! split into n chunks where n is number of gpus. Every channel goes around
+//! its own ring (see rcclChannel.h), and all channels run at the same time
+//! with channel index in blockIdx.y, so that each gpu reads from up to
+//! num_channels peers. Within a channel, the op is done in 2 * (n - 1) steps
+//! and in each step a gpu reads exactly one chunk from previous gpu in the
+//! ring of the channel.
+//! - Reduce-scatter: in step s, gpu at position p reduces chunk (p - s - 1) %
+//! n of its source buffer with the partial result previous gpu produced in
+//! step s - 1 (source buffer of previous gpu for s = 0). After n - 1 steps,
+//! gpu at position p holds the final result of chunk (p + 1) % n.
+//! - Allgather: in step s, gpu at position p copies chunk (p - s) % n from
+//! destination buffer of previous gpu.
+//! Each step is pipelined in slices of its chunk. Gpus only sync with their
+//! neighbours, through point-to-point flags for collective epochs starting at
+//! *p2p_time: ready flag of a gpu holds the number of slices it finished, so
+//! slice i of a step starts as soon as previous gpu finished slice i of the
+//! step before, instead of waiting for every gpu to finish the whole step.
+//! A gpu only overwrites a chunk after next gpu read it, as the final result
+//! of the chunk went around the ring through next gpu. At the end a gpu waits
+//! on done flag of next gpu, so that it does not exit while its buffers are
+//! still being read. Channels share the flags as they are launched together.
+//! Step kernels release their stores to the system so that the slice written
+//! is visible to the next gpu without an l2 flush. If pconfig is not nullptr,
+//! it is the launch configuration computed by a persistent plan for the sync
+//! slot, otherwise it is computed on every call.
+template <typename DataType_t, typename VectorType_t, rcclRedOp_t Op>
+void RcclInternalAllReduceRing(RingNodePool_t* ppool, RingNode_t* pcurr_track,
+                               const void* send_buff, void* recv_buff,
+                               hipStream_t stream, int count, int num_gpus,
+                               int rank, int num_channels, int* p2p_time,
+                               const RcclRingAllReduceConfig_t* pconfig =
+                                   nullptr) {
+    //! Use configuration computed by a plan if there is one
+    RcclRingAllReduceConfig_t config;
+    if (pconfig != nullptr) {
+        config = *pconfig;
+    } else {
+        RcclGetRingAllReduceConfig(ppool, pcurr_track, count,
+                                   sizeof(DataType_t), num_gpus, rank,
+                                   num_channels, &config);
+    }
+    num_channels = config.num_channels;
+    int num_slices = config.num_slices;
+
+    RcclRingStep_t step;
+    for (int channel = 0; channel < num_channels; channel++) {
+        step.peers[channel] = config.peers[channel];
+    }
+
+    int epoch = *p2p_time;
+    int num_steps = 2 * (num_gpus - 1);
+
+    //! Set source and destination buffers for current gpu
+    RcclInternalSetSrcDstPtr(pcurr_track, stream, send_buff, recv_buff);
+
+    //! Tell next gpus the buffers are set and wait until previous gpus set
+    //! theirs
+    for (int i = 0; i < config.num_nexts; i++) {
+        RcclInternalSignalPeers(pcurr_track, config.nexts[i], stream,
+                                krccl_peer_ready, epoch);
+    }
+    for (int i = 0; i < config.num_prevs; i++) {
+        RcclInternalWaitPeers(pcurr_track, config.prevs[i], stream,
+                              krccl_peer_ready, epoch);
+    }
+
+    //! Reduce-scatter in steps 0 to n - 2, allgather in steps n - 1 to
+    //! 2 * (n - 1) - 1
+    for (int s = 0; s < num_steps; s++) {
+        bool reduce = s < num_gpus - 1;
+        for (int slice = 0; slice < num_slices; slice++) {
+            for (int channel = 0; channel < num_channels; channel++) {
+                int position = config.rings[channel].position;
+                int chunk = reduce ? position - s - 1
+                                   : position - (s - (num_gpus - 1));
+                chunk = (chunk + num_gpus) % num_gpus;
+                RcclSetRingStepChunk(
+                    &step, channel, channel * config.regular_channel_count,
+                    channel == num_channels - 1
+                        ? config.last_channel_count
+                        : config.regular_channel_count,
+                    chunk, num_gpus, slice, num_slices);
+            }
+
+            //! Wait until previous gpus finished the slice in previous step
+            if (s > 0) {
+                for (int i = 0; i < config.num_prevs; i++) {
+                    RcclInternalWaitPeers(
+                        pcurr_track, config.prevs[i], stream,
+                        krccl_peer_ready,
+                        epoch + 1 + (s - 1) * num_slices + slice);
+                }
+            }
+
+            if (reduce) {
+                hipLaunchKernelGGL((RcclKernelRingReduceStep<DataType_t, Op>),
+                                   dim3(config.num_workgroups, num_channels, 1),
+                                   dim3(config.num_workitems, 1, 1), 0, stream,
+                                   step, send_buff, recv_buff, s == 0);
+            } else {
+                hipLaunchKernelGGL((RcclKernelRingCopyStep<DataType_t>),
+                                   dim3(config.num_workgroups, num_channels, 1),
+                                   dim3(config.num_workitems, 1, 1), 0, stream,
+                                   step, recv_buff);
+            }
+
+            //! Tell next gpus the slice is finished
+            for (int i = 0; i < config.num_nexts; i++) {
+                RcclInternalSignalPeers(pcurr_track, config.nexts[i], stream,
+                                        krccl_peer_ready,
+                                        epoch + 1 + s * num_slices + slice);
+            }
+        }
+    }
+
+    //! Tell previous gpus current gpu finished reading from them and wait
+    //! until next gpus finished reading from current gpu
+    for (int i = 0; i < config.num_prevs; i++) {
+        RcclInternalSignalPeers(pcurr_track, config.prevs[i], stream,
+                                krccl_peer_done, epoch);
+    }
+    for (int i = 0; i < config.num_nexts; i++) {
+        RcclInternalWaitPeers(pcurr_track, config.nexts[i], stream,
+                              krccl_peer_done, epoch);
+    }
+
+    //! Update communicator with epochs used by the op
+    *p2p_time = epoch + 1 + num_steps * num_slices;
+}
@@ -0,0 +1,97 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+#pragma once
+
+/**
+ * @file rcclRingKernels.h
+ * @brief Kernels to implement multi-channel ring collectives
+ *
+ * This file contains implementation of kernels used by ring based
+ * collectives. Each kernel does one step, or one slice of a step, on all the
+ * channels, channel index is blockIdx.y.
+ */
+
+#include "rcclChannel.h"
+#include "rcclReduceOps.h"
+#include "rcclTracker.h"
+
+//! @brief Work done by a gpu in all channels for one ring step or slice
+//! Computed on host, passed to kernel by value
+struct RcclRingStep_t {
+    //! Previous gpu in ring of each channel
+    RingNode_t* peers[kmax_channels];
+    //! First element of the chunk of each channel. Slots of allgather
+    //! destination buffer can be past 2^31 elements
+    size_t offset[kmax_channels];
+    //! Number of elements in the chunk of each channel
+    int count[kmax_channels];
+};
+
+//! @brief Definition of RcclKernelRingReduceStep
+//! Reduce chunk of local buffer with the same chunk of previous gpu buffer
+//! and store it to recv_buff. If peer_src is true, RingNode_t::src_buffer of
+//! previous gpu is read, otherwise RingNode_t::dst_buffer
+template <typename DataType_t, rcclRedOp_t Op>
+__global__ void RcclKernelRingReduceStep(RcclRingStep_t step,
+                                         const void* send_buff,
+                                         void* recv_buff, bool peer_src) {
+    int tx = threadIdx.x;
+    int bx = blockIdx.x;
+    int tid = tx + bx * blockDim.x;
+    int stride = blockDim.x * gridDim.x;
+    int channel = blockIdx.y;
+
+    //! Get pointer to previous gpu buffer holding its partial result once per
+    //! workgroup
+    __shared__ const DataType_t* peer_buff;
+    if (tx == 0) {
+        RingNode_t* ppeer_track = step.peers[channel];
+        peer_buff = reinterpret_cast<const DataType_t*>(
+            peer_src ? ppeer_track->slots->src_buffer
+                     : ppeer_track->slots->dst_buffer);
+    }
+    __syncthreads();
+    RcclAcquireFence();
+
+    for (int i = tid; i < step.count[channel]; i += stride) {
+        size_t index = i + step.offset[channel];
+
+        DataType_t result =
+            reinterpret_cast<const DataType_t*>(send_buff)[index];
+        RcclReduceOp<DataType_t, Op>(result, peer_buff[index]);
+
+        reinterpret_cast<DataType_t*>(recv_buff)[index] = result;
+    }
+
+    RcclReleaseFence();
+}
+
+//! @brief Definition of RcclKernelRingCopyStep
+//! Copy chunk of previous gpu destination buffer to the same chunk of
+//! recv_buff
+template <typename DataType_t>
+__global__ void RcclKernelRingCopyStep(RcclRingStep_t step, void* recv_buff) {
+    int tx = threadIdx.x;
+    int bx = blockIdx.x;
+    int tid = tx + bx * blockDim.x;
+    int stride = blockDim.x * gridDim.x;
+    int channel = blockIdx.y;
+
+    __shared__ const DataType_t* peer_buff;
+    if (tx == 0) {
+        peer_buff = reinterpret_cast<const DataType_t*>(
+            step.peers[channel]->slots->dst_buffer);
+    }
+    __syncthreads();
+    RcclAcquireFence();
+
+    for (int i = tid; i < step.count[channel]; i += stride) {
+        size_t index = i + step.offset[channel];
+        reinterpret_cast<DataType_t*>(recv_buff)[index] = peer_buff[index];
+    }
+
+    RcclReleaseFence();
+}
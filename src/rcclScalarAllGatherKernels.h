@@ -13,6 +13,8 @@ All rights reserved.
  *
  */
 
+#include "rcclPeerTable.h"
+
 //! @brief Definition of RcclKernelScalarAllGather
 //! Gather data from all gpus and store to current gpu destination buffer
 template <typename DataType_t>
@@ -20,37 +22,43 @@ __global__ void RcclKernelScalarAllGather(RingNode_t* pcurr_track, int rank,
                                           int count) {
     int tx = threadIdx.x;
     int bx = blockIdx.x;
-    int tid = tx + bx * knum_vectors_per_workgroup;
+    int tid = tx + bx * blockDim.x;
+    int stride = blockDim.x * gridDim.x;
+
+    //! Get buffers of all gpus once per workgroup
+    __shared__ RcclPeerTable_t peers;
+    RcclLoadPeerTable(pcurr_track, &peers);
 
     //! Get pointers to current gpu source and destination buffers
     DataType_t* curr_dst_buff =
-        reinterpret_cast<DataType_t*>(pcurr_track->dst_buffer);
+        reinterpret_cast<DataType_t*>(peers.dst_buffer[0]);
     const DataType_t* curr_src_buff =
-        reinterpret_cast<const DataType_t*>(pcurr_track->src_buffer);
-    RingNode_t* pnext_track = pcurr_track->next_gpu;
+        reinterpret_cast<const DataType_t*>(peers.src_buffer[0]);
 
     //! Iterate over all the gpus and gather data from them
-    while (pnext_track->rank != rank) {
+    for (int peer = 1; peer < peers.num_gpus; peer++) {
         //! Get pointer to peer gpu source buffer
-        DataType_t* next_src_buff =
-            reinterpret_cast<DataType_t*>(pnext_track->src_buffer);
+        const DataType_t* next_src_buff =
+            reinterpret_cast<const DataType_t*>(peers.src_buffer[peer]);
 
-        int curr_rank = pnext_track->rank;
+        //! Slot of peer gpu in destination buffer, which can be past 2^31
+        //! elements
+        DataType_t* peer_slot =
+            curr_dst_buff + static_cast<size_t>(peers.rank[peer]) * count;
 
         //! Read data from peer gpu and store it to current gpu destination
         //! buffer
-        if (tid < count) {
-            curr_dst_buff[tid + curr_rank * count] = next_src_buff[tid];
+        for (int i = tid; i < count; i += stride) {
+            peer_slot[i] = next_src_buff[i];
         }
-
-        //! Get next gpu tracker
-        pnext_track = pnext_track->next_gpu;
     }
 
     // copy self
-    if (tid < count) {
-        curr_dst_buff[tid + rank * count] = curr_src_buff[tid];
+    DataType_t* curr_slot = curr_dst_buff + static_cast<size_t>(rank) * count;
+    for (int i = tid; i < count; i += stride) {
+        curr_slot[i] = curr_src_buff[i];
     }
 
     __syncthreads();
+    RcclReleaseFence();
 }
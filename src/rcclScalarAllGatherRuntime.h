@@ -14,47 +14,80 @@ All rights reserved.
 
 #pragma once
 
-#include "rcclBarrierKernels.h"
+#include "rcclFusedRuntime.h"
+#include "rcclLaunch.h"
 #include "rcclScalarAllGatherKernels.h"
+#include "rcclSync.h"
+#include "rcclVectorAllGatherKernels.h"
 
 extern int RCCL_TRACE_RT;
 
 //! @brief Definition of RcclInternalAllGather
 //! Once all gpus have setup their buffers, each gpu gathers rest
-//! of the data from other gpus.
+//! of the data from other gpus. If push is set, each gpu writes its data to
+//! the other gpus instead.
 template <typename DataType_t, typename VectorType_t>
 void RcclInternalAllGather(RingNode_t* pcurr_track, const void* send_buff,
                            void* recv_buff, hipStream_t stream, int count,
-                           int num_gpus, int rank, hipEvent_t event,
+                           int num_gpus, int rank, bool push,
                            int* this_time) {
+    if (RCCL_FUSED) {
+        RcclInternalAllGatherFused<DataType_t, VectorType_t>(
+            pcurr_track, send_buff, recv_buff, stream, count, num_gpus,
+            this_time);
+        return;
+    }
+
     int num_workitems = 0, num_workgroups = 0;
 
-    num_workitems = knum_workitems;
-    num_workgroups = (count + knum_workitems - 1) / knum_workitems;
+    //! Use 16 byte accesses if buffers of current gpu allow it, alignment of
+    //! peer buffers is checked by the kernel
+    bool vectorize = RcclIsSameVectorAlignment<VectorType_t>(
+        send_buff, reinterpret_cast<DataType_t*>(recv_buff) +
+                       static_cast<size_t>(rank) * count);
+
+    //! Stream large buffers past gpu caches
+    bool nontemporal = RcclIsNonTemporal(count * sizeof(DataType_t));
+
+    if (vectorize) {
+        RcclGetVectorLaunchDims<DataType_t, VectorType_t>(
+            pcurr_track, count, &num_workitems, &num_workgroups);
+    } else {
+        RcclGetLaunchDims(pcurr_track, count, &num_workitems, &num_workgroups);
+    }
 
     int barrier_value = *this_time;
 
     //! Set source and destination buffers for current gpu
-    hipLaunchKernelGGL(RcclKernelSetSrcDstPtr, dim3(1, 1, 1), dim3(1, 1, 1), 0,
-                       stream, pcurr_track, (void*)send_buff, recv_buff);
+    RcclInternalSetSrcDstPtr(pcurr_track, stream, send_buff, recv_buff);
 
     //! Wait using multi-gpu barrier until all the gpus set their source and
     //! destination buffers
-    hipLaunchKernelGGL(RcclKernelBarrierWait, dim3(1, 1, 1), dim3(1, 1, 1), 0,
-                       stream, pcurr_track, barrier_value++, num_gpus);
+    RcclInternalBarrierWait(pcurr_track, stream, barrier_value++, num_gpus);
 
     //! Once all gpus have done buffer setup, gather result from all gpus to
-    //! current gpu destination buffer
-    hipLaunchKernelGGL((RcclKernelScalarAllGather<DataType_t>),
-                       dim3(num_workgroups, 1, 1), dim3(num_workitems, 1, 1), 0,
-                       stream, pcurr_track, rank, count);
-    //! Flush gpu l2 cache
-    hipEventRecord(event, stream);
-
-    //! Wait until all gpus have finished copied data from other gpus, don't
+    //! current gpu destination buffer, or write source buffer of current gpu
+    //! to all the gpus. Push kernel checks alignment of every buffer
+    if (push) {
+        hipLaunchKernelGGL(
+            (RcclKernelVectorPushAllGather<DataType_t, VectorType_t>),
+            dim3(num_workgroups, 1, 1), dim3(num_workitems, 1, 1), 0, stream,
+            pcurr_track, rank, count, nontemporal);
+    } else if (vectorize) {
+        hipLaunchKernelGGL(
+            (RcclKernelVectorAllGather<DataType_t, VectorType_t>),
+            dim3(num_workgroups, 1, 1), dim3(num_workitems, 1, 1), 0, stream,
+            pcurr_track, rank, count, nontemporal);
+    } else {
+        hipLaunchKernelGGL((RcclKernelScalarAllGather<DataType_t>),
+                           dim3(num_workgroups, 1, 1),
+                           dim3(num_workitems, 1, 1), 0, stream, pcurr_track,
+                           rank, count);
+    }
+
+    //! Wait until all gpus have finished copying data between gpus, don't
     //! exit from stream
-    hipLaunchKernelGGL(RcclKernelBarrierWait, dim3(1, 1, 1), dim3(1, 1, 1), 0,
-                       stream, pcurr_track, barrier_value++, num_gpus);
+    RcclInternalBarrierWait(pcurr_track, stream, barrier_value++, num_gpus);
 
     //! Update communicator with update barrier count
     *this_time = barrier_value;
@@ -15,11 +15,66 @@ All rights reserved.
 
 #pragma once
 
-#include "rcclBarrierKernels.h"
+#include "rcclDataTypes.h"
+#include "rcclFusedRuntime.h"
+#include "rcclLaunch.h"
 #include "rcclScalarAllReduceKernels.h"
+#include "rcclSync.h"
+#include "rcclVectorAllReduceKernels.h"
 
 extern int RCCL_TRACE_RT;
 
+//! @brief Definition of RcclGetAllReduceConfig
+//! Compute launch configuration of RcclInternalAllReduce for elements of
+//! type_size bytes. Source and destination buffers are split into n chunks
+//! where n is number of gpus, last gpu also takes the remainder. Vector
+//! kernels use 16 byte vectors for every data type
+inline void RcclGetAllReduceConfig(const RingNode_t* pcurr_track,
+                                   const void* send_buff,
+                                   const void* recv_buff, int count,
+                                   size_t type_size, int num_gpus, int rank,
+                                   bool push, RcclAllReduceConfig_t* config) {
+    config->offset = (count / num_gpus) * rank;
+
+    //! Three counts are required to implement chunked allreduce
+    //! - op_gpu_count stores how many elements each gpu operates on,
+    //! depending on rank of gpu. This is used to launched reduction op
+    //! - regular_gpu_count stores how many elements each gpu holds,
+    //! except for the highest ranking gpu
+    //! - last_gpu_count stores how many elements last ranked gpu holds
+    config->regular_gpu_count = count / num_gpus;
+    config->last_gpu_count = ((count / num_gpus) + (count % num_gpus));
+    config->op_gpu_count = (rank == num_gpus - 1) ? config->last_gpu_count
+                                                  : config->regular_gpu_count;
+
+    //! Size grid for the largest chunk (last_gpu_count), kernels stride over
+    //! their chunk if grid is capped
+    RcclGetLaunchDims(pcurr_track, config->last_gpu_count,
+                      &(config->num_workitems), &(config->num_workgroups));
+
+    //! Vectorized kernels need a vector per workitem
+    int width = static_cast<int>(sizeof(rccl_float4_t) / type_size);
+    RcclGetLaunchDims(pcurr_track, (config->last_gpu_count + width - 1) / width,
+                      &(config->num_vector_workitems),
+                      &(config->num_vector_workgroups));
+
+    //! Fused mode kernel runs all phases in one grid, which is capped so that
+    //! all workgroups are resident while they spin on the barrier
+    RcclGetLaunchDims(pcurr_track, (config->last_gpu_count + width - 1) / width,
+                      &(config->num_fused_workitems),
+                      &(config->num_fused_workgroups), knum_sync_slots);
+
+    //! Use 16 byte accesses if buffers of current gpu allow it, alignment of
+    //! peer buffers is checked by the kernels
+    config->vectorize =
+        RcclIsSameVectorAlignment<rccl_float4_t>(send_buff, recv_buff);
+
+    //! Stream large buffers past gpu caches
+    config->nontemporal = RcclIsNonTemporal(count * type_size);
+
+    config->push = push;
+}
+
 //! @brief Definition of RcclInternalAllReduce
 //! We split source and destination buffer into n chunks where n is number of
 //! gpus. Then, we assign each chunk to each gpu depending on the rank. For
@@ -30,75 +85,88 @@ extern int RCCL_TRACE_RT;
 //! above example, gpu 2 gather data from index 512 to 767 from all the gpus
 //! into its registers and does floating point addition on them. The final
 //! result is stored into local destination buffer. Then, each gpu gathers rest
-//! of the data from other gpus.
-template <typename DataType_t, typename VectorType_t, rcclRedOp_t Op>
+//! of the data from other gpus. NumGpus is either 0 or num_gpus, see
+//! RcclReducePeers. If push is set, instead of gathering, each gpu writes its
+//! chunk to the other gpus. Kernels end with a system scope release and start
+//! with an acquire (RcclReleaseFence, RcclAcquireFence), so phases are only
+//! separated by the multi-gpu barrier. If pconfig is not nullptr, it is the
+//! launch configuration computed by a persistent plan, otherwise it is
+//! computed on every call.
+template <typename DataType_t, typename VectorType_t, rcclRedOp_t Op,
+          int NumGpus = 0>
 void RcclInternalAllReduce(RingNode_t* pcurr_track, const void* send_buff,
                            void* recv_buff, hipStream_t stream, int count,
-                           int num_gpus, int rank, hipEvent_t event,
-                           int* this_time) {
-    int num_workitems = 0, num_workgroups = 0;
-
-    int offset = (count / num_gpus) * rank;
+                           int num_gpus, int rank, bool push, int* this_time,
+                           const RcclAllReduceConfig_t* pconfig = nullptr) {
+    if (RCCL_FUSED) {
+        RcclInternalAllReduceFused<DataType_t, VectorType_t, Op, NumGpus>(
+            pcurr_track, send_buff, recv_buff, stream, count, num_gpus, rank,
+            this_time, pconfig);
+        return;
+    }
 
-    //! Three counts are required to implement chunked allreduce
-    //! - op_gpu_count stores how many elements each gpu operates on,
-    //! depending on rank of gpu. This is used to launched reduction op
-    //! - regular_gpu_count stores how many elements each gpu holds,
-    //! except for the highest ranking gpu
-    //! - last_gpu_count stores how many elements last ranked gpu holds
-    int regular_gpu_count = count / num_gpus;
-    int last_gpu_count = ((count / num_gpus) + (count % num_gpus));
-    int op_gpu_count =
-        (rank == num_gpus - 1) ? last_gpu_count : regular_gpu_count;
-
-    //! Explain why you need last_gpu_count number of workitems
-    if (last_gpu_count < knum_workitems) {
-        num_workitems = last_gpu_count;
-        num_workgroups = 1;
+    //! Use configuration computed by a plan if there is one
+    RcclAllReduceConfig_t config;
+    if (pconfig != nullptr) {
+        config = *pconfig;
     } else {
-        num_workitems = knum_workitems;
-        num_workgroups = (last_gpu_count / knum_workitems) + 1;
+        RcclGetAllReduceConfig(pcurr_track, send_buff, recv_buff, count,
+                               sizeof(DataType_t), num_gpus, rank, push,
+                               &config);
     }
 
     int barrier_value = *this_time;
 
     //! Set source and destination buffers for current gpu
-    hipLaunchKernelGGL(RcclKernelSetSrcDstPtr, dim3(1, 1, 1), dim3(1, 1, 1), 0,
-                       stream, pcurr_track, (void*)send_buff, recv_buff);
+    RcclInternalSetSrcDstPtr(pcurr_track, stream, send_buff, recv_buff);
 
     //! Wait using multi-gpu barrier until all the gpus set their source and
     //! destination buffers
-    hipLaunchKernelGGL(RcclKernelBarrierWait, dim3(1, 1, 1), dim3(1, 1, 1), 0,
-                       stream, pcurr_track, barrier_value++, num_gpus);
+    RcclInternalBarrierWait(pcurr_track, stream, barrier_value++, num_gpus);
 
     //! Once all the gpus have set their buffer, do reduction on portion of the
     //! buffer depending on rank of the gpu
-    hipLaunchKernelGGL((RcclKernelScalarAllReduce<DataType_t, Op>),
-                       dim3(num_workgroups, 1, 1), dim3(num_workitems, 1, 1), 0,
-                       stream, pcurr_track, (void*)send_buff, recv_buff,
-                       op_gpu_count, offset);
-
-    //! Flush gpu l2 cache
-    hipEventRecord(event, stream);
+    if (config.vectorize) {
+        hipLaunchKernelGGL(
+            (RcclKernelVectorAllReduce<DataType_t, VectorType_t, Op, NumGpus>),
+            dim3(config.num_vector_workgroups, 1, 1),
+            dim3(config.num_vector_workitems, 1, 1), 0, stream, pcurr_track,
+            send_buff, recv_buff, config.op_gpu_count, config.offset,
+            config.nontemporal);
+    } else {
+        hipLaunchKernelGGL((RcclKernelScalarAllReduce<DataType_t, Op, NumGpus>),
+                           dim3(config.num_workgroups, 1, 1),
+                           dim3(config.num_workitems, 1, 1), 0, stream,
+                           pcurr_track, (void*)send_buff, recv_buff,
+                           config.op_gpu_count, config.offset);
+    }
 
     //! Wait until all gpus have finished doing reduction on their respective
     //! portions
-    hipLaunchKernelGGL(RcclKernelBarrierWait, dim3(1, 1, 1), dim3(1, 1, 1), 0,
-                       stream, pcurr_track, barrier_value++, num_gpus);
+    RcclInternalBarrierWait(pcurr_track, stream, barrier_value++, num_gpus);
 
     //! Once all gpus have done reduction, gather result from all gpus to
-    //! current gpu destination buffer
-    hipLaunchKernelGGL((RcclKernelCopyRest<DataType_t>),
-                       dim3(num_workgroups, 1, 1), dim3(num_workitems, 1, 1), 0,
-                       stream, pcurr_track, num_gpus, rank, regular_gpu_count,
-                       last_gpu_count);
-    //! Flush gpu l2 cache
-    hipEventRecord(event, stream);
-
-    //! Wait until all gpus have finished copied data from other gpus, don't
+    //! current gpu destination buffer, or write result of current gpu to all
+    //! the other gpus
+    if (config.push) {
+        hipLaunchKernelGGL(
+            (RcclKernelVectorPushRest<DataType_t, VectorType_t>),
+            dim3(config.num_vector_workgroups, 1, 1),
+            dim3(config.num_vector_workitems, 1, 1), 0, stream, pcurr_track,
+            rank, config.regular_gpu_count, config.op_gpu_count,
+            config.nontemporal);
+    } else {
+        hipLaunchKernelGGL(
+            (RcclKernelVectorCopyRest<DataType_t, VectorType_t>),
+            dim3(config.num_vector_workgroups, 1, 1),
+            dim3(config.num_vector_workitems, 1, 1), 0, stream, pcurr_track,
+            num_gpus, rank, config.regular_gpu_count, config.last_gpu_count,
+            config.nontemporal);
+    }
+
+    //! Wait until all gpus have finished copying data between gpus, don't
     //! exit from stream
-    hipLaunchKernelGGL(RcclKernelBarrierWait, dim3(1, 1, 1), dim3(1, 1, 1), 0,
-                       stream, pcurr_track, barrier_value++, num_gpus);
+    RcclInternalBarrierWait(pcurr_track, stream, barrier_value++, num_gpus);
 
     //! Update communicator with update barrier count
     *this_time = barrier_value;
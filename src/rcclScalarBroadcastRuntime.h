@@ -14,58 +14,109 @@ All rights reserved.
 
 #pragma once
 
-#include "rcclBarrierKernels.h"
-#include "rcclScalarBroadcastKernels.h"
+#include "rcclFusedRuntime.h"
+#include "rcclSync.h"
+#include "rcclVectorBroadcastKernels.h"
 
 //! @brief Definition of RcclInternalBroadcastRoot
-//! This function is called on root gpu and it does not do the copy
+//! This function is called on root gpu. Root only syncs with non-root gpus,
+//! through point-to-point flags for collective epoch *p2p_time. In pull mode
+//! it does not do the copy, non-root gpus read from it. If push is set, root
+//! writes its source buffer to destination buffers of non-root gpus. this_time
+//! is used in fused mode
+template <typename DataType_t, typename VectorType_t>
 void RcclInternalBroadcastRoot(RingNode_t* pcurr_track, hipStream_t stream,
-                               void* send_buff, int* this_time, int num_gpus) {
-    //! Set source pointer on root gpu
-    hipLaunchKernelGGL((RcclKernelSetSrcPtr), dim3(1, 1, 1), dim3(1, 1, 1), 0,
-                       stream, pcurr_track, send_buff);
+                               void* send_buff, int count, bool push,
+                               int* this_time, int* p2p_time, int num_gpus) {
+    if (RCCL_FUSED) {
+        RcclInternalPublishSrcFused(pcurr_track, stream, send_buff, this_time,
+                                    num_gpus);
+        return;
+    }
 
-    //! Get the barrier instance used count
-    int barrier_value = *this_time;
+    int epoch = (*p2p_time)++;
 
-    //! Wait until root gpu sets its source pointer
-    hipLaunchKernelGGL((RcclKernelBarrierWait), dim3(1, 1, 1), dim3(1, 1, 1), 0,
-                       stream, pcurr_track, barrier_value++, num_gpus);
+    if (push) {
+        int num_workitems = 0, num_workgroups = 0;
+
+        //! Wait until non-root gpus set their destination pointers
+        RcclInternalWaitPeers(pcurr_track, nullptr, stream, krccl_peer_ready,
+                              epoch);
 
-    //! Wait until everyone finished reading from source buffer
-    hipLaunchKernelGGL((RcclKernelBarrierWait), dim3(1, 1, 1), dim3(1, 1, 1), 0,
-                       stream, pcurr_track, barrier_value++, num_gpus);
+        //! Write data to non-root gpus, alignment of their buffers is checked
+        //! by the kernel
+        RcclGetVectorLaunchDims<DataType_t, VectorType_t>(
+            pcurr_track, count, &num_workitems, &num_workgroups);
+        hipLaunchKernelGGL(
+            (RcclKernelVectorPushFromRoot<DataType_t, VectorType_t>),
+            dim3(num_workgroups, 1, 1), dim3(num_workitems, 1, 1), 0, stream,
+            pcurr_track, send_buff, count,
+            RcclIsNonTemporal(count * sizeof(DataType_t)));
+
+        //! Tell non-root gpus their destination buffers hold the data
+        RcclInternalSignalPeers(pcurr_track, nullptr, stream, krccl_peer_done,
+                                epoch);
+        return;
+    }
+
+    //! Set source pointer on root gpu
+    RcclInternalSetSrcPtr(pcurr_track, stream, send_buff);
 
-    //! Update how many times barrier is used
-    *this_time = barrier_value;
+    //! Tell non-root gpus source pointer is set
+    RcclInternalSignalPeers(pcurr_track, nullptr, stream, krccl_peer_ready,
+                            epoch);
+
+    //! Wait until non-root gpus finished reading from source buffer
+    RcclInternalWaitPeers(pcurr_track, nullptr, stream, krccl_peer_done, epoch);
 }
 
 //! @brief Definition of RcclInternalBroadcast
-//! This function is called on all gpus except root gpu
-template <typename DataType_t>
+//! This function is called on all gpus except root gpu. It only syncs with
+//! root gpu, see RcclInternalBroadcastRoot
+template <typename DataType_t, typename VectorType_t>
 void RcclInternalBroadcast(RingNode_t* pcurr_track, RingNode_t* proot_track,
                            int count, hipStream_t stream, void* recv_buff,
-                           int* this_time, int num_gpus) {
-    bool check_count = count > knum_workitems;
-    int num_workitems = check_count ? knum_workitems : count;
-    int num_workgroups = check_count ? count / knum_workitems + 1 : 1;
+                           bool push, int* this_time, int* p2p_time,
+                           int num_gpus) {
+    if (RCCL_FUSED) {
+        RcclInternalBroadcastFused<DataType_t, VectorType_t>(
+            pcurr_track, proot_track, count, stream, recv_buff, this_time,
+            num_gpus);
+        return;
+    }
 
-    //! Get barrier instance used count
-    int barrier_value = *this_time;
+    int num_workitems = 0, num_workgroups = 0;
 
-    //! Wait until root gpu sets its source pointer
-    hipLaunchKernelGGL((RcclKernelBarrierWait), dim3(1, 1, 1), dim3(1, 1, 1), 0,
-                       stream, pcurr_track, barrier_value++, num_gpus);
+    int epoch = (*p2p_time)++;
+
+    if (push) {
+        //! Set destination pointer and tell root gpu it can write to it
+        RcclInternalSetDstPtr(pcurr_track, stream, recv_buff);
+        RcclInternalSignalPeers(pcurr_track, proot_track, stream,
+                                krccl_peer_ready, epoch);
 
-    //! Read data from root gpu
-    hipLaunchKernelGGL((RcclKernelScalarCopyFromRoot<DataType_t>),
-                       dim3(num_workgroups, 1, 1), dim3(num_workitems, 1, 1), 0,
-                       stream, proot_track, recv_buff, count);
+        //! Wait until root gpu finished writing to destination buffer
+        RcclInternalWaitPeers(pcurr_track, proot_track, stream,
+                              krccl_peer_done, epoch);
+        return;
+    }
+
+    //! Wait until root gpu sets its source pointer
+    RcclInternalWaitPeers(pcurr_track, proot_track, stream, krccl_peer_ready,
+                          epoch);
 
-    //! Wait until everyone finishes reading
-    hipLaunchKernelGGL((RcclKernelBarrierWait), dim3(1, 1, 1), dim3(1, 1, 1), 0,
-                       stream, pcurr_track, barrier_value++, num_gpus);
+    //! Read data from root gpu, alignment of root buffer is checked by the
+    //! kernel
+    RcclGetVectorLaunchDims<DataType_t, VectorType_t>(
+        pcurr_track, count, &num_workitems, &num_workgroups);
+    hipLaunchKernelGGL(
+        (RcclKernelVectorCopyFromRoot<DataType_t, VectorType_t>),
+        dim3(num_workgroups, 1, 1), dim3(num_workitems, 1, 1), 0, stream,
+        proot_track, recv_buff, count,
+        RcclIsNonTemporal(count * sizeof(DataType_t)));
 
-    //! Update how many times barrier is used
-    *this_time = barrier_value;
+    //! Tell root gpu current gpu is done reading, other non-root gpus are not
+    //! waited for
+    RcclInternalSignalPeers(pcurr_track, proot_track, stream, krccl_peer_done,
+                            epoch);
 }
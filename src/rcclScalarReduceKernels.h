@@ -14,48 +14,50 @@ All rights reserved.
  * @author Aditya Atluri
  */
 
+#include "rcclVectorOps.h"
+
 //! @brief Definition of RcclKernelScalarReduce
-//! Gather data from non-root gpus and do reduction op on it
-template <typename DataType_t, rcclRedOp_t Op>
+//! Gather data from non-root gpus and do reduction op on it. If NumGpus is not
+//! 0, it is the number of gpus in clique
+template <typename DataType_t, rcclRedOp_t Op, int NumGpus>
 __global__ void RcclKernelScalarReduce(RingNode_t* pcurr_track, const void* send_buff,
                                        void* recv_buff, int count) {
     int tx = threadIdx.x;
     int bx = blockIdx.x;
-    int tid = tx + bx * knum_vectors_per_workgroup;
+    int tid = tx + bx * blockDim.x;
+    int stride = blockDim.x * gridDim.x;
 
     //! Get pointers to current gpu source and destination buffers
     DataType_t* curr_dst_buff = reinterpret_cast<DataType_t*>(recv_buff);
     const DataType_t* curr_src_buff = reinterpret_cast<const DataType_t*>(send_buff);
 
-    //! Use only count number of workitems to do the reduction operation
-    if (tid < count) {
-        int index = tid;
-
-        RingNode_t* pnext_track = pcurr_track->next_gpu;
-
-        DataType_t result = curr_src_buff[index];
-
-        //! Iterate over all the gpus, gather data from them and do reduction
-        //! operation on them
-        while (pnext_track != pcurr_track) {
-            DataType_t* next_src_buff =
-                reinterpret_cast<DataType_t*>(pnext_track->src_buffer);
-
-            if (Op == rcclSum) result = result + next_src_buff[index];
-            if (Op == rcclProd) result = result + next_src_buff[index];
-            if (Op == rcclMax)
-                result = result > next_src_buff[index] ? result
-                                                       : next_src_buff[index];
-            if (Op == rcclMin)
-                result = result < next_src_buff[index] ? result
-                                                       : next_src_buff[index];
-
-            //! Get next gpu tracker
-            pnext_track = pnext_track->next_gpu;
+    //! Get source buffers of peer gpus once per workgroup
+    __shared__ RcclPeerTable_t peers;
+    RcclLoadPeerTable(pcurr_track, &peers);
+
+    //! If number of gpus is known at compile time, loop over gpus is unrolled
+    //! and loads from them are pipelined across iterations
+    if (NumGpus > 1) {
+        RcclReducePeersPipelined<DataType_t, DataType_t, Op, NumGpus>(
+            curr_dst_buff, curr_src_buff, peers, 0, tid, count, stride);
+    } else {
+        //! Each workitem strides over count elements by size of the grid
+        for (int index = tid; index < count; index += stride) {
+            DataType_t result = curr_src_buff[index];
+
+            //! Iterate over all the gpus, gather data from them and do
+            //! reduction operation on them
+            for (int peer = 1; peer < peers.num_gpus; peer++) {
+                const DataType_t* next_src_buff =
+                    reinterpret_cast<const DataType_t*>(
+                        peers.src_buffer[peer]);
+                RcclReduceOp<DataType_t, Op>(result, next_src_buff[index]);
+            }
+
+            curr_dst_buff[index] = result;
         }
-
-        curr_dst_buff[index] = result;
     }
 
     __syncthreads();
+    RcclReleaseFence();
 }
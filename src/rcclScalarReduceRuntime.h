@@ -14,66 +14,88 @@ All rights reserved.
 
 #pragma once
 
-#include "rcclBarrierKernels.h"
+#include "rcclFusedRuntime.h"
+#include "rcclLaunch.h"
 #include "rcclScalarReduceKernels.h"
+#include "rcclSync.h"
+#include "rcclVectorReduceKernels.h"
 
 extern int RCCL_TRACE_RT;
 
 //! @brief Definition of RcclInternalReduce
 //! This function is launched on root gpus
 //! This function launches kernel on root gpu which gathers data from buffers on
-//! all gpus, do reduction op and store it in root gpu destination buffer
-template <typename DataType_t, typename VectorType_t, rcclRedOp_t Op>
+//! all gpus, do reduction op and store it in root gpu destination buffer.
+//! Root syncs with each non-root gpu through point-to-point flags for
+//! collective epoch *p2p_time, this_time is used in fused mode. NumGpus is
+//! either 0 or num_gpus, see RcclReducePeers
+template <typename DataType_t, typename VectorType_t, rcclRedOp_t Op,
+          int NumGpus = 0>
 void RcclInternalReduce(RingNode_t* pcurr_track, int count, hipStream_t stream,
                         const void* send_buff, void* recv_buff, int* this_time,
-                        int num_gpus) {
-    bool check_count = count > knum_workitems;
+                        int* p2p_time, int num_gpus) {
+    if (RCCL_FUSED) {
+        RcclInternalReduceFused<DataType_t, VectorType_t, Op, NumGpus>(
+            pcurr_track, count, stream, send_buff, recv_buff, this_time,
+            num_gpus);
+        return;
+    }
 
-    int num_workitems = check_count ? knum_workitems : count;
-    int num_workgroups = check_count ? count / knum_workitems + 1 : 1;
+    int num_workitems = 0, num_workgroups = 0;
 
-    //! Get how many times barrier is used
-    int barrier_value = *this_time;
+    int epoch = (*p2p_time)++;
 
     //! Wait until non-root gpus set their source pointers
-    hipLaunchKernelGGL(RcclKernelBarrierWait, dim3(1, 1, 1), dim3(1, 1, 1), 0,
-                       stream, pcurr_track, barrier_value++, num_gpus);
+    RcclInternalWaitPeers(pcurr_track, nullptr, stream, krccl_peer_ready,
+                          epoch);
 
     //! Once all the gpus set their source pointers do reduction on them and
-    //! store the result to recv_buff
-    hipLaunchKernelGGL((RcclKernelScalarReduce<DataType_t, Op>),
-                       dim3(num_workgroups, 1, 1), dim3(num_workitems, 1, 1), 0,
-                       stream, pcurr_track, send_buff, recv_buff, count);
-
-    //! Make all gpus to wait until reduction is done. Once done, all gpus exit
-    //! op
-    hipLaunchKernelGGL(RcclKernelBarrierWait, dim3(1, 1, 1), dim3(1, 1, 1), 0,
-                       stream, pcurr_track, barrier_value++, num_gpus);
-
-    //! Store back how many times the barrier is used so far
-    *this_time = barrier_value;
+    //! store the result to recv_buff. Use 16 byte accesses if buffers of root
+    //! gpu allow it, alignment of peer buffers is checked by the kernel
+    if (RcclIsSameVectorAlignment<VectorType_t>(send_buff, recv_buff)) {
+        RcclGetVectorLaunchDims<DataType_t, VectorType_t>(
+            pcurr_track, count, &num_workitems, &num_workgroups);
+        hipLaunchKernelGGL(
+            (RcclKernelVectorReduce<DataType_t, VectorType_t, Op, NumGpus>),
+            dim3(num_workgroups, 1, 1), dim3(num_workitems, 1, 1), 0, stream,
+            pcurr_track, send_buff, recv_buff, count,
+            RcclIsNonTemporal(count * sizeof(DataType_t)));
+    } else {
+        RcclGetLaunchDims(pcurr_track, count, &num_workitems, &num_workgroups);
+        hipLaunchKernelGGL(
+            (RcclKernelScalarReduce<DataType_t, Op, NumGpus>),
+            dim3(num_workgroups, 1, 1), dim3(num_workitems, 1, 1), 0, stream,
+            pcurr_track, send_buff, recv_buff, count);
+    }
+
+    //! Tell non-root gpus their source buffers are no longer read
+    RcclInternalSignalPeers(pcurr_track, nullptr, stream, krccl_peer_done,
+                            epoch);
 }
 
 //! @brief Definition of RcclInternalReduceNotRoot
-//! This function is launched on gpus which are not roots
-void RcclInternalReduceNotRoot(RingNode_t* pcurr_track, hipStream_t stream,
+//! This function is launched on gpus which are not roots. It only syncs with
+//! root gpu, see RcclInternalReduce
+void RcclInternalReduceNotRoot(RingNode_t* pcurr_track,
+                               RingNode_t* proot_track, hipStream_t stream,
                                const void* send_buff, int* this_time,
-                               int num_gpus) {
-    //! Get how many times barrier is used
-    int barrier_value = *this_time;
+                               int* p2p_time, int num_gpus) {
+    if (RCCL_FUSED) {
+        RcclInternalPublishSrcFused(pcurr_track, stream, send_buff, this_time,
+                                    num_gpus);
+        return;
+    }
 
-    //! Set source pointer to RingNode_t so that other gpus and see them
-    hipLaunchKernelGGL(RcclKernelSetSrcPtr, dim3(1, 1, 1), dim3(1, 1, 1), 0,
-                       stream, pcurr_track, (void*)send_buff);
+    int epoch = (*p2p_time)++;
 
-    //! Wait until all gpus have set their source pointers
-    hipLaunchKernelGGL(RcclKernelBarrierWait, dim3(1, 1, 1), dim3(1, 1, 1), 0,
-                       stream, pcurr_track, barrier_value++, num_gpus);
+    //! Set source pointer to RingNode_t so that other gpus and see them
+    RcclInternalSetSrcPtr(pcurr_track, stream, send_buff);
 
-    //! Wait until all the gpus have finished the op
-    hipLaunchKernelGGL(RcclKernelBarrierWait, dim3(1, 1, 1), dim3(1, 1, 1), 0,
-                       stream, pcurr_track, barrier_value++, num_gpus);
+    //! Tell root gpu source pointer is set
+    RcclInternalSignalPeers(pcurr_track, proot_track, stream, krccl_peer_ready,
+                            epoch);
 
-    //! Store back how many times the barrier is used so far
-    *this_time = barrier_value;
+    //! Wait until root gpu finished reading source buffer
+    RcclInternalWaitPeers(pcurr_track, proot_track, stream, krccl_peer_done,
+                          epoch);
 }
@@ -21,19 +21,19 @@ All rights reserved.
 //! @brief Definition of RcclKernelSetSrcPtr
 //! RingNode_t::src_buffer is set
 __global__ void RcclKernelSetSrcPtr(RingNode_t* pcurr_track, void* send_buff) {
-    pcurr_track->src_buffer = send_buff;
+    pcurr_track->slots->src_buffer = send_buff;
 }
 
 //! @brief Definition of RcclKernelSetDstPtr
 //! RingNode_t::dst_buffer is set
 __global__ void RcclKernelSetDstPtr(RingNode_t* pcurr_track, void* recv_buff) {
-    pcurr_track->dst_buffer = recv_buff;
+    pcurr_track->slots->dst_buffer = recv_buff;
 }
 
 //! @brief Definition of RcclKernelSetSrcDstPtr
 //! RingNode_t::src_buffer and RingNode_t::dst_buffer is set
 __global__ void RcclKernelSetSrcDstPtr(RingNode_t* pcurr_track, void* send_buff,
                                        void* recv_buff) {
-    pcurr_track->src_buffer = send_buff;
-    pcurr_track->dst_buffer = recv_buff;
+    pcurr_track->slots->src_buffer = send_buff;
+    pcurr_track->slots->dst_buffer = recv_buff;
 }
@@ -0,0 +1,174 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+/**
+ * @file rcclSync.h
+ * @brief Host code which publishes buffer pointers and syncs gpus
+ *
+ * This file contains host code used by runtimes to publish buffers of current
+ * gpu and to wait on peer gpus. If RingNode_t::stream_ops is set, it is done
+ * with stream memory operations (hipStreamWriteValue, hipStreamWaitValue),
+ * which are processed by the command processor without dispatching a kernel.
+ * Otherwise single workitem kernels from rcclSetKernels.h and
+ * rcclBarrierKernels.h are launched. Both paths follow the same protocol on
+ * Barrier_t and RcclPeerFlags_t. Registered buffers which are already in the
+ * slots of current gpu are not published again.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "rcclBarrierKernels.h"
+#include "rcclSetKernels.h"
+
+//! @brief Definition of RcclInternalSetSrcPtr
+//! Publish source buffer of current gpu
+inline void RcclInternalSetSrcPtr(RingNode_t* pcurr_track, hipStream_t stream,
+                                  const void* send_buff) {
+    if (pcurr_track->registered && pcurr_track->published_src == send_buff) {
+        return;
+    }
+    pcurr_track->published_src = send_buff;
+
+    if (pcurr_track->stream_ops) {
+        HIPCHECK(hipStreamWriteValue64(
+            stream, &(pcurr_track->slots->src_buffer),
+            reinterpret_cast<uint64_t>(send_buff), 0));
+    } else {
+        hipLaunchKernelGGL(RcclKernelSetSrcPtr, dim3(1, 1, 1), dim3(1, 1, 1), 0,
+                           stream, pcurr_track, const_cast<void*>(send_buff));
+    }
+}
+
+//! @brief Definition of RcclInternalSetDstPtr
+//! Publish destination buffer of current gpu
+inline void RcclInternalSetDstPtr(RingNode_t* pcurr_track, hipStream_t stream,
+                                  void* recv_buff) {
+    if (pcurr_track->registered && pcurr_track->published_dst == recv_buff) {
+        return;
+    }
+    pcurr_track->published_dst = recv_buff;
+
+    if (pcurr_track->stream_ops) {
+        HIPCHECK(hipStreamWriteValue64(
+            stream, &(pcurr_track->slots->dst_buffer),
+            reinterpret_cast<uint64_t>(recv_buff), 0));
+    } else {
+        hipLaunchKernelGGL(RcclKernelSetDstPtr, dim3(1, 1, 1), dim3(1, 1, 1), 0,
+                           stream, pcurr_track, recv_buff);
+    }
+}
+
+//! @brief Definition of RcclInternalSetSrcDstPtr
+//! Publish source and destination buffers of current gpu. Ops are enqueued on
+//! a slot in order (see PreEnqueueEventRecord), so if both buffers are
+//! registered and were published by the previous op on the slot, they are
+//! still in the slots when the op runs
+inline void RcclInternalSetSrcDstPtr(RingNode_t* pcurr_track,
+                                     hipStream_t stream, const void* send_buff,
+                                     void* recv_buff) {
+    if (pcurr_track->registered && pcurr_track->published_src == send_buff &&
+        pcurr_track->published_dst == recv_buff) {
+        return;
+    }
+    pcurr_track->published_src = send_buff;
+    pcurr_track->published_dst = recv_buff;
+
+    if (pcurr_track->stream_ops) {
+        HIPCHECK(hipStreamWriteValue64(
+            stream, &(pcurr_track->slots->src_buffer),
+            reinterpret_cast<uint64_t>(send_buff), 0));
+        HIPCHECK(hipStreamWriteValue64(stream,
+                                       &(pcurr_track->slots->dst_buffer),
+                                       reinterpret_cast<uint64_t>(recv_buff),
+                                       0));
+    } else {
+        hipLaunchKernelGGL(RcclKernelSetSrcDstPtr, dim3(1, 1, 1),
+                           dim3(1, 1, 1), 0, stream, pcurr_track,
+                           const_cast<void*>(send_buff), recv_buff);
+    }
+}
+
+//! @brief Definition of RcclInternalForgetPtrs
+//! Called by runtimes whose kernels publish buffers of current gpu themselves,
+//! so that the next op publishes its buffers again
+inline void RcclInternalForgetPtrs(RingNode_t* pcurr_track) {
+    pcurr_track->published_src = nullptr;
+    pcurr_track->published_dst = nullptr;
+}
+
+//! @brief Definition of RcclInternalBarrierWait
+//! Enter instance this_time of the multi-gpu barrier and make stream wait
+//! until all num_gpus gpus entered it. hipStreamWaitValue32 compares entries
+//! as unsigned values, the stream operation path does not handle entries
+//! wrapping around after 2^32 instances
+inline void RcclInternalBarrierWait(RingNode_t* pcurr_track, hipStream_t stream,
+                                    int this_time, int num_gpus) {
+    if (pcurr_track->stream_ops) {
+        Barrier_t* barrier = pcurr_track->barrier;
+        uint32_t target = static_cast<uint32_t>(this_time) + 1u;
+        HIPCHECK(hipStreamWriteValue32(
+            stream, &(barrier->arrived[pcurr_track->rank]), target, 0));
+        for (int rank = 0; rank < num_gpus; rank++) {
+            if (rank == pcurr_track->rank) continue;
+            HIPCHECK(hipStreamWaitValue32(stream, &(barrier->arrived[rank]),
+                                          target, hipStreamWaitValueGte));
+        }
+    } else {
+        hipLaunchKernelGGL(RcclKernelBarrierWait, dim3(1, 1, 1), dim3(1, 1, 1),
+                           0, stream, pcurr_track, this_time, num_gpus);
+    }
+}
+
+//! @brief Definition of RcclInternalSignalPeers
+//! Set flag of current gpu for collective epoch in slots of ppeer_track, or of
+//! every other gpu in the clique if ppeer_track is nullptr
+inline void RcclInternalSignalPeers(RingNode_t* pcurr_track,
+                                    RingNode_t* ppeer_track, hipStream_t stream,
+                                    RcclPeerFlag_t flag, int epoch) {
+    if (!pcurr_track->stream_ops) {
+        hipLaunchKernelGGL(RcclKernelSignalPeers, dim3(1, 1, 1), dim3(1, 1, 1),
+                           0, stream, pcurr_track, ppeer_track, flag, epoch);
+        return;
+    }
+
+    //! RingNode_t lives in host memory, peers can be found on host
+    int rank = pcurr_track->rank;
+    RingNode_t* pnode =
+        ppeer_track != nullptr ? ppeer_track : pcurr_track->next_gpu;
+    for (; pnode != pcurr_track; pnode = pnode->next_gpu) {
+        RcclPeerFlags_t* flags = &(pnode->slots->peer_flags[rank]);
+        HIPCHECK(hipStreamWriteValue32(
+            stream, flag == krccl_peer_ready ? &(flags->ready) : &(flags->done),
+            static_cast<uint32_t>(epoch) + 1u, 0));
+        if (ppeer_track != nullptr) break;
+    }
+}
+
+//! @brief Definition of RcclInternalWaitPeers
+//! Make stream wait until ppeer_track, or every other gpu in the clique if
+//! ppeer_track is nullptr, set flag for collective epoch in slots of current
+//! gpu
+inline void RcclInternalWaitPeers(RingNode_t* pcurr_track,
+                                  RingNode_t* ppeer_track, hipStream_t stream,
+                                  RcclPeerFlag_t flag, int epoch) {
+    if (!pcurr_track->stream_ops) {
+        hipLaunchKernelGGL(RcclKernelWaitPeers, dim3(1, 1, 1), dim3(1, 1, 1),
+                           0, stream, pcurr_track, ppeer_track, flag, epoch);
+        return;
+    }
+
+    RcclSyncSlots_t* slots = pcurr_track->slots;
+    RingNode_t* pnode =
+        ppeer_track != nullptr ? ppeer_track : pcurr_track->next_gpu;
+    for (; pnode != pcurr_track; pnode = pnode->next_gpu) {
+        RcclPeerFlags_t* flags = &(slots->peer_flags[pnode->rank]);
+        HIPCHECK(hipStreamWaitValue32(
+            stream, flag == krccl_peer_ready ? &(flags->ready) : &(flags->done),
+            static_cast<uint32_t>(epoch) + 1u, hipStreamWaitValueGte));
+        if (ppeer_track != nullptr) break;
+    }
+}
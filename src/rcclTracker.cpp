@@ -15,22 +15,47 @@ All rights reserved.
 
 #include "rcclTracker.h"
 
+#include <cstdlib>
+#include <cstring>
+
+//! Link type reported by hipExtGetLinkTypeAndHopCount for xgmi
+//! (HSA_AMD_LINK_INFO_TYPE_XGMI)
+constexpr uint32_t kxgmi_link_type = 4;
+
+//! @brief Get number of workgroups of knum_workitems which fit on a gpu
+//! One workgroup per compute unit is always possible, more if the arch allows
+//! more resident workitems per compute unit
+static uint32_t RcclGetMaxWorkgroups(int device) {
+    hipDeviceProp_t props;
+    HIPCHECK(hipGetDeviceProperties(&props, device));
+    int workgroups_per_cu = props.maxThreadsPerMultiProcessor / knum_workitems;
+    if (workgroups_per_cu < 1) workgroups_per_cu = 1;
+    int num_cus = props.multiProcessorCount > 0 ? props.multiProcessorCount : 1;
+    return num_cus * workgroups_per_cu;
+}
+
+//! @brief Get placement of sync flags from its name (for example, "spread"),
+//! return krccl_num_syncs if name is nullptr or not recognized
+static RcclSyncPlacement_t RcclGetSyncPlacementFromName(const char* name) {
+    if (name == nullptr) return krccl_num_syncs;
+    if (strcmp(name, "host") == 0) return krccl_sync_host;
+    if (strcmp(name, "gpu") == 0) return krccl_sync_gpu;
+    if (strcmp(name, "spread") == 0) return krccl_sync_spread;
+    return krccl_num_syncs;
+}
+
 //! @brief Default constructor
-//! Allocate new barrier_t at initialization
+//! Allocate new barrier_t at initialization. Gpus join the pool later, so
+//! barrier and slots are kept in host memory
 RingNodePool_t::RingNodePool_t() {
     num_devices_ = 0;
     active_devices_ = 0;
     device_indices_ = nullptr;
+    topology_ = krccl_topo_pcie;
+    sync_placement_ = krccl_sync_host;
 
-    HIPCHECK(
-        hipHostMalloc(&barrier_, sizeof(Barrier_t), hipHostMallocCoherent));
-
-    std::atomic_store_explicit(&(barrier_->bar_in), 0,
-                               std::memory_order_seq_cst);
-    std::atomic_store_explicit(&(barrier_->bar_out), 0,
-                               std::memory_order_seq_cst);
-    std::atomic_store_explicit(&(barrier_->times_done), 0,
-                               std::memory_order_seq_cst);
+    barrier_ = static_cast<Barrier_t*>(
+        AllocSync(knum_sync_slots * sizeof(Barrier_t), 0));
 }
 
 //! @brief Default destructor
@@ -40,7 +65,7 @@ RingNodePool_t::~RingNodePool_t() {
         delete device_indices_;
         device_indices_ = nullptr;
     }
-    HIPCHECK(hipHostFree(barrier_));
+    FreeSync(barrier_);
 }
 
 //! @brief Construct device pool
@@ -55,38 +80,25 @@ RingNodePool_t::RingNodePool_t(const int* device_indices, int num_devices)
     device_indices_ = new int[num_devices_];
     memcpy(device_indices_, device_indices, num_devices_ * sizeof(int));
 
-    struct RingNode_t* pdctl;
-
-    //! Allocate Barrier_t
-    HIPCHECK(
-        hipHostMalloc(&barrier_, sizeof(Barrier_t), hipHostMallocCoherent));
+    //! All gpus are known, pick where sync flags go before allocating them
+    DetectTopology();
+    SelectSyncPlacement();
 
-    //! Reset fields in Barrier_t
-    std::atomic_store_explicit(&(barrier_->bar_in), 0,
-                               std::memory_order_seq_cst);
-    std::atomic_store_explicit(&(barrier_->bar_out), 0,
-                               std::memory_order_seq_cst);
-    std::atomic_store_explicit(&(barrier_->times_done), 0,
-                               std::memory_order_seq_cst);
+    //! Allocate a Barrier_t per sync slot, on first gpu unless they are kept
+    //! on host. AllocSync resets their fields
+    barrier_ = static_cast<Barrier_t*>(
+        AllocSync(knum_sync_slots * sizeof(Barrier_t), device_indices_[0]));
 
-    //! Allocate RingNode_t as system pinned memory for gpu and add its hip
-    //! device index
+    //! Allocate RingNode_t of each gpu
     for (int i = 0; i < num_devices_; i++) {
-        HIPCHECK(
-            hipHostMalloc(&pdctl, sizeof(RingNode_t), hipHostMallocCoherent));
-        pool_[i] = pdctl;
-        pool_[i]->prev_gpu = nullptr;
-        pool_[i]->next_gpu = nullptr;
-        pool_[i]->hip_current_device_index = device_indices_[i];
-        pool_[i]->src_buffer = nullptr;
-        pool_[i]->dst_buffer = nullptr;
-        pool_[i]->barrier = barrier_;
-        pool_[i]->rank = i;
+        AddNodes(device_indices_[i], i);
     }
 
     //! Reset all the nodes in the pool to create a ring
     ResetGpuRing();
 
+    DetectStreamOps();
+
     //! restore users hip device index
     HIPCHECK(hipSetDevice(user_device_index));
 }
@@ -112,57 +124,178 @@ RcclComm_t* RingNodePool_t::AddDevice(int device, int rank, int ndev) {
     ret_comm->num_devices_ = ndev;
     ret_comm->device_ = device;
     ret_comm->rank_ = rank;
-    ret_comm->stream_ = NULL;
-    ret_comm->this_time_ = 0;
 
-    //! Create new RingNode_t
-    struct RingNode_t* pdctl;
-    HIPCHECK(hipHostMalloc(&pdctl, sizeof(RingNode_t), hipHostMallocCoherent));
+    //! Create new RingNode_t for each sync slot, unless they are already
+    //! created for current gpu
+    if (pool_[0].find(rank) == pool_[0].end()) {
+        AddNodes(device, rank);
+    }
 
-    //! Create hipEvent_t for each gpu in the clique
-    HIPCHECK(
-        hipEventCreateWithFlags(&ret_comm->event_, hipEventReleaseToSystem));
+    //! Create hipEvent_t for each sync slot of the gpu and add its RingNode_t
+    //! to rccl communicator
+    for (int slot = 0; slot < knum_sync_slots; slot++) {
+        RcclCommSlot_t* pslot = &(ret_comm->slots_[slot]);
+        HIPCHECK(
+            hipEventCreateWithFlags(&pslot->event_, hipEventReleaseToSystem));
+        pslot->track_ = pool_[slot][rank];
+        pslot->stream_ = NULL;
+        pslot->this_time_ = 0;
+        pslot->p2p_time_ = 0;
+        pslot->tensors_ = nullptr;
+        pslot->max_tensors_ = 0;
+        HIPCHECK(hipMalloc(&pslot->scratch_, kone_shot_round_bytes));
+    }
+    ret_comm->slot_ = &(ret_comm->slots_[0]);
+    ret_comm->seq_ = 0;
 
-    //! Populate RingNode_t
-    pdctl->prev_gpu = nullptr;
-    pdctl->next_gpu = nullptr;
+    //! Reset the gpu RingNode_t ring
+    ResetGpuRing();
 
-    pdctl->src_buffer = nullptr;
-    pdctl->dst_buffer = nullptr;
+    //! All gpus in the clique joined, links between them are known
+    if (pool_[0].size() == static_cast<size_t>(ndev)) {
+        DetectTopology();
+        DetectStreamOps();
+    }
 
-    pdctl->hip_current_device_index = device;
+    return ret_comm;
+}
 
-    pdctl->barrier = barrier_;
+//! @brief Allocate RingNode_t of a gpu
+//! RingNode_t is allocated as system pinned memory for each sync slot. Slots
+//! of the gpu are allocated together, according to sync_placement_
+void RingNodePool_t::AddNodes(int device, int rank) {
+    RcclSyncSlots_t* slots = static_cast<RcclSyncSlots_t*>(
+        AllocSync(knum_sync_slots * sizeof(RcclSyncSlots_t), device));
+    uint32_t max_workgroups = RcclGetMaxWorkgroups(device);
 
-    pdctl->rank = rank;
+    for (int slot = 0; slot < knum_sync_slots; slot++) {
+        struct RingNode_t* pdctl;
+        HIPCHECK(
+            hipHostMalloc(&pdctl, sizeof(RingNode_t), hipHostMallocCoherent));
 
-    //! Check if RingNode_t is already created for current gpu
-    if (pool_.find(rank) != pool_.end()) {
-        // clean existing entry
-    } else {
-        pool_[rank] = pdctl;
+        pdctl->prev_gpu = nullptr;
+        pdctl->next_gpu = nullptr;
+        pdctl->slots = slots + slot;
+        pdctl->hip_current_device_index = device;
+        pdctl->max_workgroups = max_workgroups;
+        pdctl->barrier = barrier_ + slot;
+        pdctl->rank = rank;
+        pdctl->slot = slot;
+        pdctl->stream_ops = false;
+        pdctl->published_src = nullptr;
+        pdctl->published_dst = nullptr;
+        pdctl->registered = false;
+
+        pool_[slot][rank] = pdctl;
     }
+}
 
-    //! Reset the gpu RingNode_t ring
-    ResetGpuRing();
+//! @brief Allocate memory for sync flags
+//! Host placement uses coherent pinned memory. Other placements use
+//! fine-grained memory on device, which peer gpus can poll over xgmi without
+//! going through host, and atomics on it are coherent across gpus
+void* RingNodePool_t::AllocSync(size_t size, int device) {
+    void* ptr = nullptr;
+    if (sync_placement_ == krccl_sync_host) {
+        HIPCHECK(hipHostMalloc(&ptr, size, hipHostMallocCoherent));
+        memset(ptr, 0, size);
+        return ptr;
+    }
 
-    //! Add RingNode_t to rccl communicator
-    ret_comm->track_ = pdctl;
-    return ret_comm;
+    if (sync_placement_ == krccl_sync_gpu) {
+        device = device_indices_[0];
+    }
+    HIPCHECK(hipSetDevice(device));
+    HIPCHECK(hipExtMallocWithFlags(&ptr, size, hipDeviceMallocFinegrained));
+    HIPCHECK(hipMemset(ptr, 0, size));
+    return ptr;
+}
+
+//! @brief Free memory allocated by AllocSync
+void RingNodePool_t::FreeSync(void* ptr) {
+    if (sync_placement_ == krccl_sync_host) {
+        HIPCHECK(hipHostFree(ptr));
+    } else {
+        HIPCHECK(hipFree(ptr));
+    }
 }
 
 //! @brief Resets all RingNode_t in pool
 //! This method resets all RingNode_t structures in pool to form a ring
 void RingNodePool_t::ResetGpuRing() {
-    auto iter_before = pool_.begin();
-    auto iter_after = iter_before;
-    for (iter_after++; iter_after != pool_.end(); iter_before++, iter_after++) {
-        iter_before->second->next_gpu = iter_after->second;
-        iter_after->second->prev_gpu = iter_before->second;
+    for (auto& nodes : pool_) {
+        auto iter_before = nodes.begin();
+        auto iter_after = iter_before;
+        for (iter_after++; iter_after != nodes.end();
+             iter_before++, iter_after++) {
+            iter_before->second->next_gpu = iter_after->second;
+            iter_after->second->prev_gpu = iter_before->second;
+        }
+
+        nodes.rbegin()->second->next_gpu = nodes.begin()->second;
+        nodes.begin()->second->prev_gpu = nodes.rbegin()->second;
+    }
+}
+
+//! @brief Find how gpus in pool are connected
+//! Topology is xgmi only if every pair of gpus is one xgmi hop apart. It can
+//! be forced with RCCL_TOPO environment variable (pcie or xgmi)
+void RingNodePool_t::DetectTopology() {
+    topology_ = RcclGetTopologyFromName(getenv("RCCL_TOPO"));
+    if (topology_ != krccl_num_topos) {
+        return;
+    }
+
+    topology_ = krccl_topo_xgmi;
+    for (int src = 0; src < num_devices_; src++) {
+        for (int dst = src + 1; dst < num_devices_; dst++) {
+            uint32_t link_type = 0, hop_count = 0;
+            if (hipExtGetLinkTypeAndHopCount(
+                    device_indices_[src], device_indices_[dst], &link_type,
+                    &hop_count) != hipSuccess ||
+                link_type != kxgmi_link_type || hop_count != 1) {
+                topology_ = krccl_topo_pcie;
+                return;
+            }
+        }
+    }
+}
+
+//! @brief Pick where sync flags are allocated
+//! With xgmi every gpu keeps its own slots and peers poll them over xgmi.
+//! With pcie peer polls of device memory are no faster than of host memory,
+//! so flags stay on host
+void RingNodePool_t::SelectSyncPlacement() {
+    sync_placement_ = RcclGetSyncPlacementFromName(getenv("RCCL_SYNC"));
+    if (sync_placement_ != krccl_num_syncs) {
+        return;
+    }
+
+    sync_placement_ =
+        topology_ == krccl_topo_xgmi ? krccl_sync_spread : krccl_sync_host;
+}
+
+//! @brief Find if peers can be synced with stream memory operations
+//! hipStreamWaitValue32 is not supported on all gpus. Kernels and stream
+//! memory operations follow the same protocol on Barrier_t and
+//! RcclPeerFlags_t, the whole pool uses one of them to keep it simple
+void RingNodePool_t::DetectStreamOps() {
+    const char* env = getenv("RCCL_STREAM_OPS");
+    bool stream_ops = env == nullptr || atoi(env) != 0;
+
+    for (int i = 0; i < num_devices_ && stream_ops; i++) {
+        int supported = 0;
+        if (hipDeviceGetAttribute(&supported,
+                                  hipDeviceAttributeCanUseStreamWaitValue,
+                                  device_indices_[i]) != hipSuccess ||
+            supported == 0) {
+            stream_ops = false;
+        }
     }
 
-    pool_.rbegin()->second->next_gpu = pool_.begin()->second;
-    pool_.begin()->second->prev_gpu = pool_.rbegin()->second;
+    for (auto& nodes : pool_) {
+        for (auto& node : nodes) node.second->stream_ops = stream_ops;
+    }
 }
 
 //! @brief Removes device from clique and pool
@@ -170,26 +303,29 @@ void RingNodePool_t::ResetGpuRing() {
 //! ring
 void RingNodePool_t::RemoveDevice(RcclComm_t* pcomm) {
     int rank = pcomm->rank_;
-    pool_.erase(rank);
-    if (pool_.size() != 0) ResetGpuRing();
+    for (auto& nodes : pool_) nodes.erase(rank);
+    if (pool_[0].size() != 0) ResetGpuRing();
 }
 
 //! @brief Print elements of all nodes in ring
 void RingNodePool_t::PrintAll() {
     for (int i = 0; i < num_devices_; i++) {
         std::cout << "On Device: " << device_indices_[i] << std::endl;
-        std::cout << pool_[i]->prev_gpu << std::endl;
-        std::cout << pool_[i]->next_gpu << std::endl;
-        std::cout << pool_[i]->dst_buffer << std::endl;
-        std::cout << pool_[i]->src_buffer << std::endl;
+        for (auto& nodes : pool_) {
+            std::cout << nodes[i]->prev_gpu << std::endl;
+            std::cout << nodes[i]->next_gpu << std::endl;
+            //! Slots may be in device memory, print where they are only
+            std::cout << nodes[i]->slots << std::endl;
+        }
     }
 }
 
 //! @brief Get RingNode_t from hip device index
-struct RingNode_t* RingNodePool_t::GetPoolByDeviceIndex(int device_index) {
+struct RingNode_t* RingNodePool_t::GetPoolByDeviceIndex(int device_index,
+                                                        int slot) {
     for (int i = 0; i < num_devices_; i++) {
         if (device_index == device_indices_[i]) {
-            return pool_[i];
+            return pool_[slot][i];
         }
     }
     return nullptr;
@@ -18,6 +18,9 @@ All rights reserved.
 #include <hip/hip_runtime.h>
 #include <atomic>
 #include <map>
+#include <vector>
+#include "rcclAlgoSelector.h"
+#include "rcclBarrier.h"
 #include "rcclCheck.h"
 
 #define KNRM "\x1B[0m"
@@ -45,13 +48,73 @@ constexpr unsigned knum_workitems = 1024;
 //! Limit the number of elements operated on per workgroup
 constexpr unsigned knum_vectors_per_workgroup = 1024;
 
-//! @brief Multi-GPU barrier
-//! Barrier structure is used to sync kernels from same rccl call across
-//! multiple gpus. times_done is used to track how many times a gpu used the
-//! barrier. bar_in tracks how many gpus have entered the barrier. bar_out
-//! tracks how many gpus have exited. Owned by rcclUniqueId or RingNodePool_t
-struct Barrier_t {
-    std::atomic<int> bar_in, bar_out, times_done;
+//! Number of collectives which can be in flight on a communicator at once.
+//! Each one uses its own sync slot: a ring of RingNode_t with their own
+//! RcclSyncSlots_t and Barrier_t
+constexpr int knum_sync_slots = 4;
+
+//! Bytes one-shot allreduce reduces between two barriers, and size of
+//! RcclCommSlot_t::scratch_
+constexpr size_t kone_shot_round_bytes = 1 << 16;
+
+//! @brief Where sync flags and pointer-exchange slots are allocated
+enum RcclSyncPlacement_t {
+    //! Coherent pinned host memory, every poll from a gpu goes over pcie
+    krccl_sync_host = 0,
+    //! Fine-grained memory on first gpu of the clique
+    krccl_sync_gpu,
+    //! Fine-grained memory, slots of each gpu on that gpu and barrier on first
+    //! gpu of the clique
+    krccl_sync_spread,
+    //! Total number of placements
+    krccl_num_syncs
+};
+
+//! @brief Slots written by kernels on a gpu and read by its peers
+//! Kept apart from RingNode_t, which host code reads and writes, so that they
+//! can be placed in peer-visible fine-grained device memory
+struct RcclSyncSlots_t {
+    //! We use atomic data type to store pointer to buffers on a gpu, because
+    //! there are multiple readers (all peer gpus) and single writer (current
+    //! gpu)
+
+    //! Stores source buffer on current gpu
+    void* src_buffer;
+    //! Stores destination buffer on current gpu
+    void* dst_buffer;
+
+    //! Counts workgroups of a single kernel collective (for example, one-shot
+    //! allreduce or fused mode) which arrived at a barrier on current gpu,
+    //! reset by the last one
+    std::atomic<int> exit_count;
+
+    //! Point-to-point flags set by peer gpus, indexed by rank of the peer
+    RcclPeerFlags_t peer_flags[kmax_gpus];
+};
+
+//! @brief Entry of table of tensors of rcclAllReduceMulti
+//! Table of each gpu is published in its source slot, so that peers can find
+//! buffers of every tensor of the batch
+struct RcclTensor_t {
+    //! Source buffer of tensor on current gpu
+    const void* src_buffer;
+    //! Destination buffer of tensor on current gpu
+    void* dst_buffer;
+    //! Number of elements in tensor
+    int count;
+};
+
+//! @brief Pinned host copy of table of tensors of rcclAllReduceMulti
+//! Table is written on host and copied to RcclCommSlot_t::tensors_ with
+//! hipMemcpyAsync, which does not wait for the gpu when the source is pinned
+struct RcclTensorStage_t {
+    //! Pinned host memory holding the table
+    RcclTensor_t* tensors;
+    //! Number of entries tensors can hold
+    int max_tensors;
+    //! Recorded once the table is copied to the gpu, stage can be written
+    //! again after that
+    hipEvent_t event;
 };
 
 //! @brief Node for each gpu
@@ -65,27 +128,52 @@ struct RingNode_t {
     //! Point to RingNode_t owned by next gpu in clique
     struct RingNode_t* next_gpu;
 
-    //! We use atomic data type to store pointer to buffers on a gpu, because
-    //! there are multiple readers (all peer gpus) and single writer (current
-    //! gpu)
-
-    //! Stores source buffer on current gpu
-    void* src_buffer;
-    //! Stores destination buffer on current gpu
-    void* dst_buffer;
+    //! Buffer pointers and flags of current gpu, placed according to
+    //! RcclSyncPlacement_t of the pool
+    RcclSyncSlots_t* slots;
 
     //! Stores device index according to hip programming model
     uint32_t hip_current_device_index;
 
+    //! Number of workgroups of knum_workitems which can be resident on
+    //! current gpu at once, grid-stride kernels launch at most these many
+    uint32_t max_workgroups;
+
     //! Barrier is allocated once per rcclUniqueId, owned by Rccl
     Barrier_t* barrier;
 
     //! Holds rank of each gpu
     int rank;
+
+    //! Index of sync slot whose ring current node belongs to
+    int slot;
+
+    //! Publish pointers and sync with peers using stream memory operations
+    //! instead of single workitem kernels. Same for all gpus in the pool
+    bool stream_ops;
+
+    //! Buffers last published to slots by ops enqueued on current gpu, or
+    //! nullptr if unknown. Only used by host
+    const void* published_src;
+    void* published_dst;
+
+    //! Buffers of the op being enqueued lie in buffers registered with
+    //! rcclCommRegister, so publishing them can be skipped if they are
+    //! already in slots. Set by the api before launching the op
+    bool registered;
 };
 
 struct RcclComm_t;
 
+//! @brief Internal representation of rcclRegHandle_t
+//! Buffer registered with a communicator by rcclCommRegister
+struct RcclRegHandle_t {
+    //! Start of registered buffer
+    const char* ptr;
+    //! Size of registered buffer in bytes
+    size_t bytes;
+};
+
 //! @brief Definition of RingNodePool_t
 //! Pool data structure used to store all RingNode_t data structures and track
 //! rcclComm_t accordingly
@@ -96,19 +184,40 @@ class RingNodePool_t {
     int* device_indices_;
     //! Number of devices in current pool
     int num_devices_;
-    //! Barrier used by all devices in pool
+    //! Barriers used by all devices in pool, one per sync slot
     Barrier_t* barrier_;
+    //! How devices in pool are connected, same for all of them so that every
+    //! gpu picks the same algorithm
+    RcclTopology_t topology_;
+    //! Where barrier_ and slots of RingNode_t are allocated
+    RcclSyncPlacement_t sync_placement_;
+    //! Allocate zeroed memory for sync flags according to sync_placement_,
+    //! device is the gpu which owns them
+    void* AllocSync(size_t size, int device);
+    //! Free memory allocated by AllocSync
+    void FreeSync(void* ptr);
+    //! Allocate RingNode_t of gpu for every sync slot and add them to pool_
+    void AddNodes(int device, int rank);
     //! Reset the ring from the trackers in the pool
     void ResetGpuRing();
+    //! Find topology_ once all devices are in device_indices_
+    void DetectTopology();
+    //! Pick sync_placement_ from topology_, it can be forced with RCCL_SYNC
+    //! environment variable (host, gpu or spread)
+    void SelectSyncPlacement();
+    //! Set RingNode_t::stream_ops of all nodes once all devices are in the
+    //! pool. Stream memory operations are used if every gpu supports them,
+    //! unless RCCL_STREAM_OPS environment variable is 0
+    void DetectStreamOps();
 
   public:
     //! Counter to track how many devices are active in pool. Used to know when
     //! we can destroy the pool and all data structures
     int active_devices_;
-    //! Used to track RingNode_t structures for each gpu
+    //! Used to track RingNode_t structures for each gpu, one map per sync slot
     //! key -> rank of the gpu
     //! value -> RingNode_t* of respective gpu
-    std::map<int, RingNode_t*> pool_;
+    std::map<int, RingNode_t*> pool_[knum_sync_slots];
     //! Destroy all the elements in pool_, barrier_ and device_indices_
     ~RingNodePool_t();
     //! Construction
@@ -120,10 +229,43 @@ class RingNodePool_t {
     void RemoveDevice(RcclComm_t* pcomm);
     //! Get number of devices the pool is allocated for
     int GetNumDevices() const { return num_devices_; }
+    //! Get how devices in the pool are connected
+    RcclTopology_t GetTopology() const { return topology_; }
+    //! Get where sync flags of the pool are allocated
+    RcclSyncPlacement_t GetSyncPlacement() const { return sync_placement_; }
     //! Print data in pool
     void PrintAll();
-    //! Given a device index, get RingNode_t structure
-    RingNode_t* GetPoolByDeviceIndex(int device_index);
+    //! Given a device index and sync slot, get RingNode_t structure
+    RingNode_t* GetPoolByDeviceIndex(int device_index, int slot);
+};
+
+//! @brief State of a communicator for one sync slot
+struct RcclCommSlot_t {
+    //! RingNode_t* corresponding to current gpu in ring of the slot
+    RingNode_t* track_;
+    //! The stream on which the last rccl call using the slot is made
+    hipStream_t stream_;
+    //! Event recorded after the last rccl call using the slot, with which
+    //! inter-stream synchronization is done. Also, used to flush L2 caches
+    //! after hipMemcpyAsync, rccl kernels release their stores themselves
+    hipEvent_t event_;
+    //! Variable to track how many times barrier of the slot is used by the gpu
+    int this_time_;
+    //! Variable to track how many collectives used point-to-point flags of the
+    //! slot, same on all gpus of the clique
+    int p2p_time_;
+    //! Device memory holding table of tensors of rcclAllReduceMulti using the
+    //! slot, grown on demand and freed by destructor of RcclComm_t
+    RcclTensor_t* tensors_;
+    //! Number of entries tensors_ can hold
+    int max_tensors_;
+    //! Pinned host tables of ops using the slot whose copy to tensors_ may
+    //! not be done yet, a new one is added only if all of them are in use
+    std::vector<RcclTensorStage_t> stages_;
+    //! Device memory of kone_shot_round_bytes holding results of in-place
+    //! one-shot allreduce until peers are done reading the buffer, freed by
+    //! destructor of RcclComm_t
+    void* scratch_;
 };
 
 //! @brief Internal representation of rcclComm_t structure, which is allocated
@@ -132,22 +274,52 @@ struct RcclComm_t {
   public:
     //! Pool of gpus rcclComm_t is created with
     RingNodePool_t* pool_;
-    //! RingNode_t* corresponding to current gpu
-    RingNode_t* track_;
-    //! The stream on which the last rccl call is made using same rcclComm_t
-    hipStream_t stream_;
-    //! Event with which inter-stream synchronization is done. Also, used to
-    //! flush L2 caches after copy and reduction operation. Event is created by
-    //! AddDevice method in RingNodePool_t and destroyed by destructor
-    hipEvent_t event_;
-    //! Variable to track how many times barrier is used by the gpu
-    int this_time_;
+    //! State of each sync slot. Events are created when the communicator is
+    //! created and destroyed by destructor
+    RcclCommSlot_t slots_[knum_sync_slots];
+    //! Slot used by rccl call being launched, set by PreEnqueueEventRecord
+    RcclCommSlot_t* slot_;
+    //! Number of rccl calls made with the communicator. Calls are made in the
+    //! same order on all gpus, so call seq_ uses the same slot on all of them
+    int seq_;
     //! Number of devices the communicator is created with
     int num_devices_;
     //! Device index of a gpu
     int device_;
     //! Rank of current gpu
     int rank_;
-    // Destroy hipEvent_t at deletion of current object
-    ~RcclComm_t() { HIPCHECK(hipEventDestroy(event_)); }
+    //! Slot the next rccl call is launched on, PreEnqueueEventRecord sets
+    //! slot_ to it
+    RcclCommSlot_t* NextSlot() { return &(slots_[seq_ % knum_sync_slots]); }
+    //! Buffers registered with rcclCommRegister and not yet deregistered
+    std::vector<RcclRegHandle_t*> registered_;
+    //! Check if bytes bytes starting at ptr lie in a registered buffer
+    bool IsRegistered(const void* ptr, size_t bytes) const {
+        const char* begin = static_cast<const char*>(ptr);
+        for (const RcclRegHandle_t* handle : registered_) {
+            if (begin >= handle->ptr &&
+                begin + bytes <= handle->ptr + handle->bytes) {
+                return true;
+            }
+        }
+        return false;
+    }
+    // Destroy hipEvent_t, tables and registrations at deletion of current
+    // object
+    ~RcclComm_t() {
+        for (int slot = 0; slot < knum_sync_slots; slot++) {
+            HIPCHECK(hipEventDestroy(slots_[slot].event_));
+            if (slots_[slot].tensors_ != nullptr) {
+                HIPCHECK(hipFree(slots_[slot].tensors_));
+            }
+            HIPCHECK(hipFree(slots_[slot].scratch_));
+            for (RcclTensorStage_t& stage : slots_[slot].stages_) {
+                HIPCHECK(hipHostFree(stage.tensors));
+                HIPCHECK(hipEventDestroy(stage.event));
+            }
+        }
+        for (RcclRegHandle_t* handle : registered_) {
+            delete handle;
+        }
+    }
 };
@@ -0,0 +1,128 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+/**
+ * @file rcclTree.cpp
+ * @brief Implementation of rcclTree.h
+ *
+ * This file contains implementation of binary trees declared in rcclTree.h
+ */
+
+#include "rcclTree.h"
+
+#include <algorithm>
+
+//! @brief Get links of rank in an in-order binary tree rooted at rank 0
+//! The level of a rank in the tree is given by its lowest set bit. Rank 0 has
+//! a single child which is the largest power of two less than num_ranks.
+static void RcclGetBinaryTreeLinks(int num_ranks, int rank, int* parent,
+                                   int* child0, int* child1) {
+    //! Find lowest set bit of rank
+    int bit;
+    for (bit = 1; bit < num_ranks; bit <<= 1) {
+        if (bit & rank) break;
+    }
+
+    if (rank == 0) {
+        *parent = -1;
+        *child0 = -1;
+        *child1 = num_ranks > 1 ? bit >> 1 : -1;
+        return;
+    }
+
+    //! Parent is one level above current rank, fall back to the lower one if
+    //! it is out of range
+    int up = (rank ^ bit) | (bit << 1);
+    if (up >= num_ranks) up = rank ^ bit;
+    *parent = up;
+
+    //! Children are one level below current rank, left child is always in
+    //! range, go down the levels until right child is in range
+    int lowbit = bit >> 1;
+    *child0 = lowbit == 0 ? -1 : rank - lowbit;
+
+    int down = lowbit == 0 ? -1 : rank + lowbit;
+    while (down >= num_ranks) {
+        lowbit >>= 1;
+        down = lowbit == 0 ? -1 : rank + lowbit;
+    }
+    *child1 = down;
+}
+
+//! @brief Get links of rank in tree 0 or tree 1 of double binary tree
+static void RcclGetTreeLinks(int num_ranks, int rank, int tree, int* parent,
+                             int* child0, int* child1) {
+    if (tree == 0) {
+        RcclGetBinaryTreeLinks(num_ranks, rank, parent, child0, child1);
+        return;
+    }
+
+    int up, down0, down1;
+    if (num_ranks % 2 == 1) {
+        //! Shift tree 0 by one rank
+        auto shift = [num_ranks](int r) {
+            return r == -1 ? -1 : (r + 1) % num_ranks;
+        };
+        RcclGetBinaryTreeLinks(num_ranks, (rank - 1 + num_ranks) % num_ranks,
+                               &up, &down0, &down1);
+        *parent = shift(up);
+        *child0 = shift(down0);
+        *child1 = shift(down1);
+    } else {
+        //! Mirror tree 0
+        auto mirror = [num_ranks](int r) {
+            return r == -1 ? -1 : num_ranks - 1 - r;
+        };
+        RcclGetBinaryTreeLinks(num_ranks, num_ranks - 1 - rank, &up, &down0,
+                               &down1);
+        *parent = mirror(up);
+        *child0 = mirror(down1);
+        *child1 = mirror(down0);
+    }
+}
+
+//! @brief Get height of sub-tree rooted at rank
+static int RcclGetSubTreeHeight(int num_ranks, int rank, int tree) {
+    int parent, children[2];
+    RcclGetTreeLinks(num_ranks, rank, tree, &parent, &children[0],
+                     &children[1]);
+
+    int height = 0;
+    for (int i = 0; i < 2; i++) {
+        if (children[i] != -1) {
+            height = std::max(
+                height, RcclGetSubTreeHeight(num_ranks, children[i], tree) + 1);
+        }
+    }
+    return height;
+}
+
+//! @brief Definition of RcclGetTreeNode
+void RcclGetTreeNode(int num_ranks, int rank, int tree, RcclTreeNode_t* node) {
+    RcclGetTreeLinks(num_ranks, rank, tree, &node->parent, &node->children[0],
+                     &node->children[1]);
+
+    //! Walk up to root to find depth of current rank and root of the tree
+    int root = rank;
+    int depth = 0;
+    int up = node->parent;
+    while (up != -1) {
+        int down0, down1;
+        root = up;
+        depth++;
+        RcclGetTreeLinks(num_ranks, root, tree, &up, &down0, &down1);
+    }
+
+    node->depth = depth;
+    node->height = RcclGetSubTreeHeight(num_ranks, rank, tree);
+    node->tree_height = RcclGetSubTreeHeight(num_ranks, root, tree);
+}
+
+//! @brief Definition of RcclGetDoubleBinaryTree
+void RcclGetDoubleBinaryTree(int num_ranks, int rank, RcclTreeNode_t* nodes) {
+    for (int tree = 0; tree < knum_trees; tree++) {
+        RcclGetTreeNode(num_ranks, rank, tree, &nodes[tree]);
+    }
+}
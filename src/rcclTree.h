@@ -0,0 +1,59 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+/**
+ * @file rcclTree.h
+ * @brief Binary trees used by tree based collectives
+ *
+ * This file contains helpers which compute position of a rank in binary trees
+ * spanning all the gpus in a clique. The trees are computed on host only and
+ * do not depend on HIP.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+//! @brief Position of a rank in a binary tree
+struct RcclTreeNode_t {
+    //! Rank of parent, -1 for root of the tree
+    int parent;
+    //! Ranks of children, -1 if child is not present
+    int children[2];
+    //! Number of edges from current rank to root
+    int depth;
+    //! Number of edges on longest path from current rank down to a leaf. Leaves
+    //! have height 0
+    int height;
+    //! Height of root of the tree, same for all ranks in the tree
+    int tree_height;
+};
+
+//! Number of trees in a double binary tree
+constexpr int knum_trees = 2;
+//! Size of a chunk pipelined through the trees in bytes
+constexpr size_t ktree_chunk_bytes = 1 << 18;
+//! Limit the number of chunks, each chunk adds a step to both phases
+constexpr int kmax_tree_chunks = 8;
+
+//! Get position of rank in one of the two complementary binary trees spanning
+//! num_ranks ranks. Tree 0 is an in-order binary tree rooted at rank 0. Tree 1
+//! is tree 0 mirrored (even num_ranks) or shifted by one rank (odd num_ranks),
+//! so that most ranks which are interior nodes in one tree are leaves in the
+//! other. Using both trees, each on half of the buffer, keeps both directions
+//! of every link busy.
+
+//! \param [in] num_ranks Number of ranks in the clique
+//! \param [in] rank Rank of current gpu
+//! \param [in] tree Index of the tree, 0 or 1
+//! \param [out] node Position of rank in the tree
+void RcclGetTreeNode(int num_ranks, int rank, int tree, RcclTreeNode_t* node);
+
+//! Get position of rank in both trees of a double binary tree
+
+//! \param [in] num_ranks Number of ranks in the clique
+//! \param [in] rank Rank of current gpu
+//! \param [out] nodes Array of knum_trees positions, one per tree
+void RcclGetDoubleBinaryTree(int num_ranks, int rank, RcclTreeNode_t* nodes);
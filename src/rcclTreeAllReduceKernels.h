@@ -0,0 +1,107 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+#pragma once
+
+/**
+ * @file rcclTreeAllReduceKernels.h
+ * @brief Kernels to implement double binary tree allreduce
+ *
+ * This file contains implementation of kernels used by tree based
+ * rcclAllReduce. Each kernel does one pipeline step on both trees, tree index
+ * is blockIdx.y.
+ */
+
+#include "rcclReduceOps.h"
+#include "rcclTracker.h"
+
+//! @brief Work done by a gpu in one tree for one pipeline step
+//! Computed on host, passed to kernel by value
+struct RcclTreeStep_t {
+    //! Children while reducing up the tree, parent while broadcasting down
+    RingNode_t* peers[2];
+    //! Read RingNode_t::src_buffer of peer (leaf child) instead of
+    //! RingNode_t::dst_buffer (partial result of interior child)
+    bool peer_src[2];
+    //! Number of valid entries in peers
+    int num_peers;
+    //! First element of the chunk
+    int offset;
+    //! Number of elements in the chunk, 0 if there is nothing to do
+    int count;
+};
+
+//! @brief Definition of RcclKernelTreeReduceStep
+//! Reduce chunk of source buffer with partial results of children and store
+//! it to destination buffer, so that parent can read it once current gpu
+//! signals the step
+template <typename DataType_t, rcclRedOp_t Op>
+__global__ void RcclKernelTreeReduceStep(RcclTreeStep_t step0,
+                                         RcclTreeStep_t step1,
+                                         const void* send_buff,
+                                         void* recv_buff) {
+    int tx = threadIdx.x;
+    int bx = blockIdx.x;
+    int tid = tx + bx * blockDim.x;
+    int stride = blockDim.x * gridDim.x;
+
+    const RcclTreeStep_t& step = blockIdx.y == 0 ? step0 : step1;
+
+    //! Get buffers of children once per workgroup
+    __shared__ const DataType_t* peer_buffs[2];
+    if (tx < step.num_peers) {
+        peer_buffs[tx] = reinterpret_cast<const DataType_t*>(
+            step.peer_src[tx] ? step.peers[tx]->slots->src_buffer
+                              : step.peers[tx]->slots->dst_buffer);
+    }
+    __syncthreads();
+    RcclAcquireFence();
+
+    for (int i = tid; i < step.count; i += stride) {
+        int index = i + step.offset;
+
+        DataType_t result =
+            reinterpret_cast<const DataType_t*>(send_buff)[index];
+
+        //! Gather partial results from children and do reduction on them
+        for (int peer = 0; peer < step.num_peers; peer++) {
+            RcclReduceOp<DataType_t, Op>(result, peer_buffs[peer][index]);
+        }
+
+        reinterpret_cast<DataType_t*>(recv_buff)[index] = result;
+    }
+
+    RcclReleaseFence();
+}
+
+//! @brief Definition of RcclKernelTreeBroadcastStep
+//! Copy chunk of final result from parent destination buffer
+template <typename DataType_t>
+__global__ void RcclKernelTreeBroadcastStep(RcclTreeStep_t step0,
+                                            RcclTreeStep_t step1,
+                                            void* recv_buff) {
+    int tx = threadIdx.x;
+    int bx = blockIdx.x;
+    int tid = tx + bx * blockDim.x;
+    int stride = blockDim.x * gridDim.x;
+
+    const RcclTreeStep_t& step = blockIdx.y == 0 ? step0 : step1;
+
+    //! Get destination buffer of parent once per workgroup
+    __shared__ const DataType_t* peer_buff;
+    if (tx == 0 && step.count > 0) {
+        peer_buff = reinterpret_cast<const DataType_t*>(
+            step.peers[0]->slots->dst_buffer);
+    }
+    __syncthreads();
+    RcclAcquireFence();
+
+    for (int i = tid; i < step.count; i += stride) {
+        int index = i + step.offset;
+        reinterpret_cast<DataType_t*>(recv_buff)[index] = peer_buff[index];
+    }
+
+    RcclReleaseFence();
+}
@@ -0,0 +1,292 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+/**
+ * @file rcclTreeAllReduceRuntime.h
+ * @brief Host code which launches kernels to do tree based rcclAllReduce
+ *
+ * This file contains host code which launches kernels implementing
+ * rcclAllReduce using a pipelined double binary tree
+ */
+
+#pragma once
+
+#include <algorithm>
+
+#include "rcclLaunch.h"
+#include "rcclSync.h"
+#include "rcclTree.h"
+#include "rcclTreeAllReduceKernels.h"
+
+extern int RCCL_TRACE_RT;
+
+//! @brief Fill chunk of tree step
+//! Chunk chunk of a tree operating on tree_count elements starting at
+//! tree_offset, with each chunk (except the last) holding chunk_count elements
+inline void RcclSetTreeStepChunk(RcclTreeStep_t* step, int tree_offset,
+                                 int tree_count, int chunk, int chunk_count) {
+    int offset = chunk * chunk_count;
+    step->offset = tree_offset + offset;
+    step->count = std::max(0, std::min(chunk_count, tree_count - offset));
+}
+
+//! @brief Definition of RcclAddTreePeer
+//! Add ppeer_track to array of num_peers distinct tree neighbors
+inline void RcclAddTreePeer(RingNode_t** peers, int* num_peers,
+                            RingNode_t* ppeer_track) {
+    for (int i = 0; i < *num_peers; i++) {
+        if (peers[i] == ppeer_track) return;
+    }
+    peers[(*num_peers)++] = ppeer_track;
+}
+
+//! @brief Definition of RcclGetTreeAllReduceConfig
+//! Compute launch configuration of RcclInternalAllReduceTree for elements of
+//! type_size bytes, with peers from sync slot of pcurr_track
+inline void RcclGetTreeAllReduceConfig(RingNodePool_t* ppool,
+                                       const RingNode_t* pcurr_track,
+                                       int count, size_t type_size,
+                                       int num_gpus, int rank,
+                                       RcclTreeAllReduceConfig_t* config) {
+    //! Get position of current gpu in both trees
+    RcclGetDoubleBinaryTree(num_gpus, rank, config->nodes);
+
+    //! Tree 0 operates on first half of the buffer, tree 1 on the second half
+    config->tree_offset[0] = 0;
+    config->tree_offset[1] = count / 2;
+    config->tree_count[0] = count / 2;
+    config->tree_count[1] = count - count / 2;
+
+    //! Split each half into chunks, second half is the larger one
+    int num_chunks = static_cast<int>(
+        (config->tree_count[1] * type_size + ktree_chunk_bytes - 1) /
+        ktree_chunk_bytes);
+    config->num_chunks = std::min(std::max(num_chunks, 1), kmax_tree_chunks);
+    config->chunk_count =
+        (config->tree_count[1] + config->num_chunks - 1) / config->num_chunks;
+
+    //! Size grid for a chunk, one row of workgroups per tree
+    RcclGetLaunchDims(pcurr_track, config->chunk_count,
+                      &(config->num_workitems), &(config->num_workgroups),
+                      knum_trees);
+
+    //! Find RingNode_t of children and parent in both trees
+    //! RingNode_t of all gpus in sync slot of current gpu, by rank
+    std::map<int, RingNode_t*>& slot_pool = ppool->pool_[pcurr_track->slot];
+    config->num_parents = 0;
+    config->num_children = 0;
+    config->num_neighbors = 0;
+    int tree_height = 0;
+    for (int tree = 0; tree < knum_trees; tree++) {
+        const RcclTreeNode_t& node = config->nodes[tree];
+        config->num_child_peers[tree] = 0;
+        for (int i = 0; i < 2; i++) {
+            int child = node.children[i];
+            if (child != -1) {
+                RcclTreeNode_t child_node;
+                RcclGetTreeNode(num_gpus, child, tree, &child_node);
+                int peer = config->num_child_peers[tree]++;
+                config->child_peers[tree][peer] = slot_pool[child];
+                config->child_leaf[tree][peer] = child_node.height == 0;
+                config->child_height[tree][peer] = child_node.height;
+                RcclAddTreePeer(config->children, &(config->num_children),
+                                slot_pool[child]);
+                RcclAddTreePeer(config->neighbors, &(config->num_neighbors),
+                                slot_pool[child]);
+            }
+        }
+
+        config->parent_peer[tree] = nullptr;
+        if (node.parent != -1) {
+            RingNode_t* pparent_track = slot_pool[node.parent];
+            config->parent_peer[tree] = pparent_track;
+            RcclAddTreePeer(config->parents, &(config->num_parents),
+                            pparent_track);
+            RcclAddTreePeer(config->neighbors, &(config->num_neighbors),
+                            pparent_track);
+        }
+
+        tree_height = std::max(tree_height, node.tree_height);
+    }
+
+    config->num_steps = config->num_chunks + tree_height - 1;
+}
+
+//! @brief Definition of RcclInternalAllReduceTree
+//! Buffer is split in two halves, first half is reduced and broadcasted over
+//! tree 0 and second half over tree 1 of a double binary tree (see
+//! rcclTree.h). Trees are built from ranks in RingNodePool_t::pool_. As a rank
+//! is an interior node in at most one tree, both directions of links are used.
+//! Each half is split into chunks which are pipelined through the tree:
+//! - Reduce: rank with height h reduces chunk k of its source buffer with
+//! partial results of its children in step k + h - 1 and stores it to its
+//! destination buffer. Leaves do nothing, their source buffer is read
+//! directly.
+//! - Broadcast: rank with depth d copies chunk k of final result from parent
+//! destination buffer in step k + d - 1.
+//! Gpus only sync with their parents and children, through point-to-point
+//! flags for collective epochs starting at *p2p_time:
+//! - ready flag of a gpu holds the number of reduce steps it finished, so a
+//! gpu waits for a child of height h until it finished step k + h - 1 before
+//! reading chunk k. Epoch *p2p_time tells neighbors the buffers are set.
+//! - done flag of a gpu holds the number of broadcast steps it finished, so a
+//! gpu waits for a parent of depth d until it finished step k + d - 1. Root
+//! is waited for on its ready flag.
+//! At the end a gpu waits until its children finished reading its destination
+//! buffer. Its parents finished reading it before the final result reached
+//! current gpu. Step kernels release their stores to the system so no l2
+//! flush is needed. If pconfig is not nullptr, it is the launch configuration
+//! computed by a persistent plan for the sync slot, otherwise it is computed
+//! on every call.
+template <typename DataType_t, typename VectorType_t, rcclRedOp_t Op>
+void RcclInternalAllReduceTree(RingNodePool_t* ppool, RingNode_t* pcurr_track,
+                               const void* send_buff, void* recv_buff,
+                               hipStream_t stream, int count, int num_gpus,
+                               int rank, int* p2p_time,
+                               const RcclTreeAllReduceConfig_t* pconfig =
+                                   nullptr) {
+    //! Use configuration computed by a plan if there is one
+    RcclTreeAllReduceConfig_t config;
+    if (pconfig != nullptr) {
+        config = *pconfig;
+    } else {
+        RcclGetTreeAllReduceConfig(ppool, pcurr_track, count,
+                                   sizeof(DataType_t), num_gpus, rank,
+                                   &config);
+    }
+    const RcclTreeNode_t* nodes = config.nodes;
+    int num_chunks = config.num_chunks;
+    int num_steps = config.num_steps;
+
+    //! Peers of step kernels, children while reducing and parent while
+    //! broadcasting
+    RcclTreeStep_t reduce_peers[knum_trees];
+    RcclTreeStep_t bcast_peers[knum_trees];
+    for (int tree = 0; tree < knum_trees; tree++) {
+        RcclTreeStep_t& reduce = reduce_peers[tree];
+        reduce.num_peers = config.num_child_peers[tree];
+        for (int i = 0; i < reduce.num_peers; i++) {
+            reduce.peers[i] = config.child_peers[tree][i];
+            reduce.peer_src[i] = config.child_leaf[tree][i];
+        }
+        RcclTreeStep_t& bcast = bcast_peers[tree];
+        bcast.num_peers = config.parent_peer[tree] != nullptr ? 1 : 0;
+        bcast.peers[0] = config.parent_peer[tree];
+        bcast.peer_src[0] = false;
+    }
+
+    int epoch = *p2p_time;
+
+    //! Set source and destination buffers for current gpu
+    RcclInternalSetSrcDstPtr(pcurr_track, stream, send_buff, recv_buff);
+
+    //! Tell neighbors the buffers are set and wait until they set theirs
+    for (int i = 0; i < config.num_neighbors; i++) {
+        RcclInternalSignalPeers(pcurr_track, config.neighbors[i], stream,
+                                krccl_peer_ready, epoch);
+    }
+    for (int i = 0; i < config.num_neighbors; i++) {
+        RcclInternalWaitPeers(pcurr_track, config.neighbors[i], stream,
+                              krccl_peer_ready, epoch);
+    }
+
+    //! Reduce up the trees
+    for (int s = 0; s < num_steps; s++) {
+        bool has_work = false;
+        for (int tree = 0; tree < knum_trees; tree++) {
+            RcclTreeStep_t& step = reduce_peers[tree];
+            int chunk = s - (nodes[tree].height - 1);
+            step.count = 0;
+            if (nodes[tree].height > 0 && chunk >= 0 && chunk < num_chunks) {
+                RcclSetTreeStepChunk(&step, config.tree_offset[tree],
+                                     config.tree_count[tree], chunk,
+                                     config.chunk_count);
+            }
+            if (step.count == 0) continue;
+            has_work = true;
+
+            //! Wait until interior children reduced the chunk
+            for (int i = 0; i < step.num_peers; i++) {
+                if (step.peer_src[i]) continue;
+                RcclInternalWaitPeers(pcurr_track, step.peers[i], stream,
+                                      krccl_peer_ready,
+                                      epoch + chunk +
+                                          config.child_height[tree][i]);
+            }
+        }
+
+        if (!has_work) continue;
+
+        hipLaunchKernelGGL((RcclKernelTreeReduceStep<DataType_t, Op>),
+                           dim3(config.num_workgroups, knum_trees, 1),
+                           dim3(config.num_workitems, 1, 1), 0, stream,
+                           reduce_peers[0], reduce_peers[1], send_buff,
+                           recv_buff);
+
+        //! Tell parents, and children if current gpu is a root, that the
+        //! step is finished
+        for (int i = 0; i < config.num_neighbors; i++) {
+            RcclInternalSignalPeers(pcurr_track, config.neighbors[i], stream,
+                                    krccl_peer_ready, epoch + 1 + s);
+        }
+    }
+
+    //! Broadcast down the trees
+    for (int s = 0; s < num_steps; s++) {
+        bool has_work = false;
+        for (int tree = 0; tree < knum_trees; tree++) {
+            RcclTreeStep_t& step = bcast_peers[tree];
+            int depth = nodes[tree].depth;
+            int chunk = s - (depth - 1);
+            step.count = 0;
+            if (depth > 0 && chunk >= 0 && chunk < num_chunks) {
+                RcclSetTreeStepChunk(&step, config.tree_offset[tree],
+                                     config.tree_count[tree], chunk,
+                                     config.chunk_count);
+            }
+            if (step.count == 0) continue;
+            has_work = true;
+
+            //! Wait until parent holds final result of the chunk
+            if (depth == 1) {
+                RcclInternalWaitPeers(pcurr_track, step.peers[0], stream,
+                                      krccl_peer_ready,
+                                      epoch + chunk + nodes[tree].tree_height);
+            } else {
+                RcclInternalWaitPeers(pcurr_track, step.peers[0], stream,
+                                      krccl_peer_done,
+                                      epoch + chunk + depth - 2);
+            }
+        }
+
+        if (!has_work) continue;
+
+        hipLaunchKernelGGL((RcclKernelTreeBroadcastStep<DataType_t>),
+                           dim3(config.num_workgroups, knum_trees, 1),
+                           dim3(config.num_workitems, 1, 1), 0, stream,
+                           bcast_peers[0], bcast_peers[1], recv_buff);
+
+        //! Tell children the step is finished
+        for (int i = 0; i < config.num_children; i++) {
+            RcclInternalSignalPeers(pcurr_track, config.children[i], stream,
+                                    krccl_peer_done, epoch + s);
+        }
+    }
+
+    //! Tell parents current gpu finished reading from them and wait until
+    //! children finished reading from current gpu, so that no gpu exits while
+    //! its buffers are still being read
+    for (int i = 0; i < config.num_parents; i++) {
+        RcclInternalSignalPeers(pcurr_track, config.parents[i], stream,
+                                krccl_peer_done, epoch + num_steps - 1);
+    }
+    for (int i = 0; i < config.num_children; i++) {
+        RcclInternalWaitPeers(pcurr_track, config.children[i], stream,
+                              krccl_peer_done, epoch + num_steps - 1);
+    }
+
+    //! Update communicator with epochs used by the op
+    *p2p_time = epoch + num_steps + 1;
+}
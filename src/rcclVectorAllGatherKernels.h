@@ -0,0 +1,68 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+#pragma once
+
+/**
+ * @file rcclVectorAllGatherKernels.h
+ * @brief Kernels to implement allgather operation with 16 byte accesses
+ *
+ * This file contains vectorized version of kernel in
+ * rcclScalarAllGatherKernels.h
+ */
+
+#include "rcclPeerTable.h"
+#include "rcclVectorOps.h"
+
+//! @brief Definition of RcclKernelVectorAllGather
+//! Gather data from all gpus and store to current gpu destination buffer
+template <typename DataType_t, typename VectorType_t>
+__global__ void RcclKernelVectorAllGather(RingNode_t* pcurr_track, int rank,
+                                          int count, bool nontemporal) {
+    //! Get buffers of all gpus once per workgroup
+    __shared__ RcclPeerTable_t peers;
+    RcclLoadPeerTable(pcurr_track, &peers);
+
+    //! Get pointer to current gpu destination buffer
+    DataType_t* curr_dst_buff =
+        reinterpret_cast<DataType_t*>(peers.dst_buffer[0]);
+
+    //! Iterate over all the gpus (current gpu last) and gather data from them
+    for (int i = 1; i <= peers.num_gpus; i++) {
+        int peer = i % peers.num_gpus;
+        RcclCopyVectorRange<DataType_t, VectorType_t>(
+            curr_dst_buff + static_cast<size_t>(peers.rank[peer]) * count,
+            reinterpret_cast<const DataType_t*>(peers.src_buffer[peer]),
+            count, nontemporal);
+    }
+
+    RcclReleaseFence();
+}
+
+//! @brief Definition of RcclKernelVectorPushAllGather
+//! Push mode counterpart of RcclKernelVectorAllGather. Write source buffer of
+//! current gpu to its slot in destination buffers of all the gpus
+template <typename DataType_t, typename VectorType_t>
+__global__ void RcclKernelVectorPushAllGather(RingNode_t* pcurr_track,
+                                              int rank, int count,
+                                              bool nontemporal) {
+    //! Get destination buffers of all gpus once per workgroup
+    __shared__ RcclPeerTable_t peers;
+    RcclLoadPeerTable(pcurr_track, &peers);
+
+    const DataType_t* curr_src_buff =
+        reinterpret_cast<const DataType_t*>(peers.src_buffer[0]);
+
+    //! Iterate over all the gpus (current gpu last) and write data to them
+    for (int i = 1; i <= peers.num_gpus; i++) {
+        int peer = i % peers.num_gpus;
+        RcclCopyVectorRange<DataType_t, VectorType_t>(
+            reinterpret_cast<DataType_t*>(peers.dst_buffer[peer]) +
+                static_cast<size_t>(rank) * count,
+            curr_src_buff, count, nontemporal);
+    }
+
+    RcclReleaseFence();
+}
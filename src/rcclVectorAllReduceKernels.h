@@ -0,0 +1,192 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+#pragma once
+
+/**
+ * @file rcclVectorAllReduceKernels.h
+ * @brief Kernels to implement allreduce operation with 16 byte accesses
+ *
+ * This file contains vectorized version of kernel in
+ * rcclScalarAllReduceKernels.h, and kernels which gather or push chunks
+ * reduced by every gpu. Workitems loop over the range with a stride
+ * of the grid size, so the grid can be sized for vectors while scalar head
+ * and tail (and scalar fallback) are still covered.
+ */
+
+#include "rcclPeerTable.h"
+#include "rcclVectorOps.h"
+
+//! @brief Reduce count elements starting at offset from all gpus
+//! Gather data from all gpus, does reduction on them and store to current gpu
+//! destination buffer. Peer buffers are known only on gpu, so if any of them
+//! has a different alignment than destination buffer, whole range is done
+//! with scalars. peers is the table loaded by RcclLoadPeerTable. If NumGpus is
+//! not 0, it is the number of gpus in clique and loop over peers is unrolled.
+//! Buffers are accessed with streaming loads and stores if nontemporal is set
+template <typename DataType_t, typename VectorType_t, rcclRedOp_t Op,
+          int NumGpus>
+__device__ inline void RcclAllReduceVectorRange(const RcclPeerTable_t& peers,
+                                                const void* send_buff,
+                                                void* recv_buff, int count,
+                                                int offset,
+                                                bool nontemporal = false) {
+    constexpr int kwidth = sizeof(VectorType_t) / sizeof(DataType_t);
+    int tid = threadIdx.x + blockIdx.x * blockDim.x;
+    int stride = blockDim.x * gridDim.x;
+
+    //! Get pointers to range of current gpu source and destination buffers
+    DataType_t* curr_dst_buff =
+        reinterpret_cast<DataType_t*>(recv_buff) + offset;
+    const DataType_t* curr_src_buff =
+        reinterpret_cast<const DataType_t*>(send_buff) + offset;
+
+    //! Check if all buffers can be accessed with vectors
+    bool aligned = RcclIsSameVectorAlignment<VectorType_t>(curr_dst_buff,
+                                                           curr_src_buff);
+    for (int peer = 1; peer < peers.num_gpus; peer++) {
+        aligned = aligned &&
+                  RcclIsSameVectorAlignment<VectorType_t>(
+                      curr_dst_buff, reinterpret_cast<const DataType_t*>(
+                                         peers.src_buffer[peer]) +
+                                         offset);
+    }
+
+    int head = aligned
+                   ? RcclGetVectorHead<DataType_t, VectorType_t>(curr_dst_buff,
+                                                                 count)
+                   : count;
+    int num_vectors = (count - head) / kwidth;
+    int tail = head + num_vectors * kwidth;
+
+    //! Scalar head and tail, or whole range if buffers are misaligned
+    for (int j = tid; j < head + count - tail; j += stride) {
+        int i = j < head ? j : tail + j - head;
+
+        DataType_t result;
+        RcclLoad(result, curr_src_buff + i, nontemporal);
+        if (NumGpus > 1) {
+            RcclReducePeers<DataType_t, DataType_t, Op, NumGpus>(
+                result, peers, offset, i, nontemporal);
+        } else {
+            for (int peer = 1; peer < peers.num_gpus; peer++) {
+                const DataType_t* next_src_buff =
+                    reinterpret_cast<const DataType_t*>(
+                        peers.src_buffer[peer]) +
+                    offset;
+                DataType_t val;
+                RcclLoad(val, next_src_buff + i, nontemporal);
+                RcclReduceOp<DataType_t, Op>(result, val);
+            }
+        }
+        RcclStore(curr_dst_buff + i, result, nontemporal);
+    }
+
+    //! Body, one 16 byte load per gpu and one 16 byte store per iteration.
+    //! Peer loads are pipelined across iterations if number of gpus is known
+    VectorType_t* vdst = reinterpret_cast<VectorType_t*>(curr_dst_buff + head);
+    const VectorType_t* vsrc =
+        reinterpret_cast<const VectorType_t*>(curr_src_buff + head);
+    if (NumGpus > 1) {
+        RcclReducePeersPipelined<DataType_t, VectorType_t, Op, NumGpus>(
+            vdst, vsrc, peers, offset + head, tid, num_vectors, stride,
+            nontemporal);
+        return;
+    }
+    for (int i = tid; i < num_vectors; i += stride) {
+        VectorType_t result;
+        RcclLoad(result, vsrc + i, nontemporal);
+        for (int peer = 1; peer < peers.num_gpus; peer++) {
+            const VectorType_t* next_src_buff =
+                reinterpret_cast<const VectorType_t*>(
+                    reinterpret_cast<const DataType_t*>(
+                        peers.src_buffer[peer]) +
+                    offset + head);
+            VectorType_t val;
+            RcclLoad(val, next_src_buff + i, nontemporal);
+            RcclReduceVectorOp<DataType_t, VectorType_t, Op>(result, val);
+        }
+        RcclStore(vdst + i, result, nontemporal);
+    }
+}
+
+//! @brief Definition of RcclKernelVectorAllReduce
+//! Do reduction on portion of the buffer current gpu operates on
+template <typename DataType_t, typename VectorType_t, rcclRedOp_t Op,
+          int NumGpus>
+__global__ void RcclKernelVectorAllReduce(RingNode_t* pcurr_track,
+                                          const void* send_buff,
+                                          void* recv_buff, int count,
+                                          int offset, bool nontemporal) {
+    __shared__ RcclPeerTable_t peers;
+    RcclLoadPeerTable(pcurr_track, &peers);
+
+    RcclAllReduceVectorRange<DataType_t, VectorType_t, Op, NumGpus>(
+        peers, send_buff, recv_buff, count, offset, nontemporal);
+
+    RcclReleaseFence();
+}
+
+//! @brief Definition of RcclKernelVectorCopyRest
+//! Gather data (which is not operated on by current gpu) from all gpus
+template <typename DataType_t, typename VectorType_t>
+__global__ void RcclKernelVectorCopyRest(RingNode_t* pcurr_track, int num_gpus,
+                                         int rank, int count_per_gpu,
+                                         int max_count_per_gpu,
+                                         bool nontemporal) {
+    //! Get destination buffers of all gpus once per workgroup
+    __shared__ RcclPeerTable_t peers;
+    RcclLoadPeerTable(pcurr_track, &peers);
+
+    //! Get pointer to current gpu destination buffer
+    DataType_t* curr_dst_buff =
+        reinterpret_cast<DataType_t*>(peers.dst_buffer[0]);
+
+    //! Iterate over all the gpus and gather data from them
+    for (int peer = 1; peer < peers.num_gpus; peer++) {
+        int curr_rank = peers.rank[peer];
+        int offset = curr_rank * count_per_gpu;
+
+        //! If the rank of peer gpu is last the last gpu, update the number of
+        //! elements it operates on
+        int count = curr_rank == num_gpus - 1 ? max_count_per_gpu
+                                              : count_per_gpu;
+
+        RcclCopyVectorRange<DataType_t, VectorType_t>(
+            curr_dst_buff + offset,
+            reinterpret_cast<const DataType_t*>(peers.dst_buffer[peer]) +
+                offset,
+            count, nontemporal);
+    }
+
+    RcclReleaseFence();
+}
+
+//! @brief Definition of RcclKernelVectorPushRest
+//! Push mode counterpart of RcclKernelVectorCopyRest. Write portion of the
+//! buffer current gpu operated on from its destination buffer to destination
+//! buffers of all the other gpus, remote writes do not stall on round trips
+//! like remote reads
+template <typename DataType_t, typename VectorType_t>
+__global__ void RcclKernelVectorPushRest(RingNode_t* pcurr_track, int rank,
+                                         int count_per_gpu, int count,
+                                         bool nontemporal) {
+    //! Get destination buffers of all gpus once per workgroup
+    __shared__ RcclPeerTable_t peers;
+    RcclLoadPeerTable(pcurr_track, &peers);
+
+    int offset = rank * count_per_gpu;
+    const DataType_t* curr_dst_buff =
+        reinterpret_cast<const DataType_t*>(peers.dst_buffer[0]) + offset;
+
+    //! Iterate over all the gpus and write data to them
+    for (int peer = 1; peer < peers.num_gpus; peer++) {
+        RcclCopyVectorRange<DataType_t, VectorType_t>(
+            reinterpret_cast<DataType_t*>(peers.dst_buffer[peer]) + offset,
+            curr_dst_buff, count, nontemporal);
+    }
+
+    RcclReleaseFence();
+}
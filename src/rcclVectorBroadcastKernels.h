@@ -0,0 +1,60 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+/**
+ * @file rcclVectorBroadcastKernels.h
+ * @brief Implementation of root copy kernel with 16 byte accesses
+ *
+ * This file contains kernels used by rcclBcast. Non-root gpus read from root
+ * gpu in pull mode, root gpu writes to non-root gpus in push mode
+ */
+#pragma once
+
+#include "rcclPeerTable.h"
+#include "rcclVectorOps.h"
+
+//! @brief Definition of RcclKernelVectorCopyFromRoot
+template <typename DataType_t, typename VectorType_t>
+__global__ void RcclKernelVectorCopyFromRoot(RingNode_t* proot_track,
+                                             void* recv_buff, int count,
+                                             bool nontemporal) {
+    //! Get root gpu source buffer once per workgroup
+    __shared__ const DataType_t* root_src_buff;
+    if (threadIdx.x == 0) {
+        root_src_buff = reinterpret_cast<const DataType_t*>(
+            proot_track->slots->src_buffer);
+    }
+    __syncthreads();
+    RcclAcquireFence();
+
+    //! Copy data from root gpu source buffer to current gpu destination
+    //! buffer
+    RcclCopyVectorRange<DataType_t, VectorType_t>(
+        reinterpret_cast<DataType_t*>(recv_buff), root_src_buff, count,
+        nontemporal);
+
+    RcclReleaseFence();
+}
+
+//! @brief Definition of RcclKernelVectorPushFromRoot
+//! Push mode counterpart of RcclKernelVectorCopyFromRoot, run on root gpu.
+//! Write root gpu source buffer to destination buffers of all the other gpus
+template <typename DataType_t, typename VectorType_t>
+__global__ void RcclKernelVectorPushFromRoot(RingNode_t* proot_track,
+                                             const void* send_buff,
+                                             int count, bool nontemporal) {
+    //! Get destination buffers of all gpus once per workgroup
+    __shared__ RcclPeerTable_t peers;
+    RcclLoadPeerTable(proot_track, &peers);
+
+    for (int peer = 1; peer < peers.num_gpus; peer++) {
+        RcclCopyVectorRange<DataType_t, VectorType_t>(
+            reinterpret_cast<DataType_t*>(peers.dst_buffer[peer]),
+            reinterpret_cast<const DataType_t*>(send_buff), count,
+            nontemporal);
+    }
+
+    RcclReleaseFence();
+}
@@ -0,0 +1,270 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+/**
+ * @file rcclVectorOps.h
+ * @brief Helpers used by kernels doing 16 byte loads and stores
+ *
+ * This file contains helpers to split a range of elements into a scalar head,
+ * a body of VectorType_t vectors and a scalar tail, and to do reduction op on
+ * vectors. A range can only be vectorized if all the buffers it touches have
+ * the same alignment, otherwise kernels fall back to scalar accesses. Large
+ * collectives access their buffers with non-temporal loads and stores, see
+ * RcclIsNonTemporal.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "rcclLaunch.h"
+#include "rcclPeerTable.h"
+#include "rcclReduceOps.h"
+#include "rcclTracker.h"
+
+//! @brief Check if vector accesses can be done on both buffers
+//! Elements at the same index of a and b can be accessed with a single
+//! VectorType_t load or store only if both buffers have the same offset from
+//! a VectorType_t boundary
+template <typename VectorType_t>
+__host__ __device__ inline bool RcclIsSameVectorAlignment(const void* a,
+                                                          const void* b) {
+    return reinterpret_cast<uintptr_t>(a) % sizeof(VectorType_t) ==
+           reinterpret_cast<uintptr_t>(b) % sizeof(VectorType_t);
+}
+
+//! @brief Get number of scalar elements before first vector boundary
+//! Returns number of DataType_t elements of buff (not more than count) which
+//! have to be accessed as scalars before buff is aligned to VectorType_t
+template <typename DataType_t, typename VectorType_t>
+__device__ inline int RcclGetVectorHead(const void* buff, int count) {
+    int misalignment =
+        reinterpret_cast<uintptr_t>(buff) % sizeof(VectorType_t);
+    int head = misalignment == 0 ? 0
+                                 : (sizeof(VectorType_t) - misalignment) /
+                                       sizeof(DataType_t);
+    return head < count ? head : count;
+}
+
+//! @brief Definition of RcclLoad
+//! Load element at ptr to val. If nontemporal is set, the load is marked as
+//! streaming so that it does not evict data of the application from gpu
+//! caches. val is an output argument as __fp16 can not be returned
+template <typename ElementType_t>
+__device__ inline void RcclLoad(ElementType_t& val, const ElementType_t* ptr,
+                                bool nontemporal) {
+    if (nontemporal) {
+        val = __builtin_nontemporal_load(ptr);
+    } else {
+        val = *ptr;
+    }
+}
+
+//! @brief Definition of RcclStore
+//! Store val to ptr, as a streaming store if nontemporal is set
+template <typename ElementType_t>
+__device__ inline void RcclStore(ElementType_t* ptr, const ElementType_t& val,
+                                 bool nontemporal) {
+    if (nontemporal) {
+        __builtin_nontemporal_store(val, ptr);
+    } else {
+        *ptr = val;
+    }
+}
+
+//! @brief Definition of RcclCopyElement
+//! Copy element at src to dst, with streaming accesses if nontemporal is set
+template <typename ElementType_t>
+__device__ inline void RcclCopyElement(ElementType_t* dst,
+                                       const ElementType_t* src,
+                                       bool nontemporal) {
+    if (nontemporal) {
+        __builtin_nontemporal_store(__builtin_nontemporal_load(src), dst);
+    } else {
+        *dst = *src;
+    }
+}
+
+//! @brief Definition of RcclReduceVectorOp
+//! Do reduction op on each element of result and val, and store it back to
+//! result
+template <typename DataType_t, typename VectorType_t, rcclRedOp_t Op>
+__device__ inline void RcclReduceVectorOp(VectorType_t& result,
+                                          const VectorType_t& val) {
+    if (Op == rcclSum) result = result + val;
+    if (Op == rcclProd) result = result * val;
+    if (Op == rcclMax || Op == rcclMin) {
+        constexpr int kwidth = sizeof(VectorType_t) / sizeof(DataType_t);
+        for (int i = 0; i < kwidth; i++) {
+            DataType_t element = result[i];
+            RcclReduceOp<DataType_t, Op>(element, val[i]);
+            result[i] = element;
+        }
+    }
+}
+
+//! @brief Definition of RcclElementOp_t
+//! Do reduction op on ElementType_t, which is either DataType_t or a vector
+//! of DataType_t
+template <typename DataType_t, typename ElementType_t, rcclRedOp_t Op>
+struct RcclElementOp_t {
+    __device__ static inline void Reduce(ElementType_t& result,
+                                         const ElementType_t& val) {
+        RcclReduceVectorOp<DataType_t, ElementType_t, Op>(result, val);
+    }
+};
+
+template <typename DataType_t, rcclRedOp_t Op>
+struct RcclElementOp_t<DataType_t, DataType_t, Op> {
+    __device__ static inline void Reduce(DataType_t& result,
+                                         const DataType_t& val) {
+        RcclReduceOp<DataType_t, Op>(result, val);
+    }
+};
+
+//! @brief Load element i of source buffers of all peer gpus into vals
+//! Peer buffers are viewed as arrays of ElementType_t starting base DataType_t
+//! elements after RcclPeerTable_t::src_buffer. NumGpus is the number of gpus
+//! in clique known at compile time, so the loop over peers is unrolled and
+//! all the peer loads are issued back to back. Only called when NumGpus > 1
+template <typename DataType_t, typename ElementType_t, int NumGpus>
+__device__ inline void RcclLoadPeers(ElementType_t* vals,
+                                     const RcclPeerTable_t& peers, int base,
+                                     int i, bool nontemporal = false) {
+    constexpr int knum_peers = NumGpus > 1 ? NumGpus - 1 : 1;
+
+#pragma unroll
+    for (int peer = 0; peer < knum_peers; peer++) {
+        RcclLoad(vals[peer],
+                 reinterpret_cast<const ElementType_t*>(
+                     reinterpret_cast<const DataType_t*>(
+                         peers.src_buffer[peer + 1]) +
+                     base) +
+                     i,
+                 nontemporal);
+    }
+}
+
+//! @brief Reduce values loaded by RcclLoadPeers into result
+//! Values are reduced pairwise, vals is clobbered
+template <typename DataType_t, typename ElementType_t, rcclRedOp_t Op,
+          int NumGpus>
+__device__ inline void RcclReducePeerVals(ElementType_t& result,
+                                          ElementType_t* vals) {
+    constexpr int knum_peers = NumGpus > 1 ? NumGpus - 1 : 1;
+
+#pragma unroll
+    for (int width = 1; width < knum_peers; width *= 2) {
+#pragma unroll
+        for (int peer = 0; peer + width < knum_peers; peer += 2 * width) {
+            RcclElementOp_t<DataType_t, ElementType_t, Op>::Reduce(
+                vals[peer], vals[peer + width]);
+        }
+    }
+    RcclElementOp_t<DataType_t, ElementType_t, Op>::Reduce(result, vals[0]);
+}
+
+//! @brief Reduce element i of source buffers of all peer gpus into result
+//! See RcclLoadPeers. Only called when NumGpus > 1
+template <typename DataType_t, typename ElementType_t, rcclRedOp_t Op,
+          int NumGpus>
+__device__ inline void RcclReducePeers(ElementType_t& result,
+                                       const RcclPeerTable_t& peers, int base,
+                                       int i, bool nontemporal = false) {
+    constexpr int knum_peers = NumGpus > 1 ? NumGpus - 1 : 1;
+    ElementType_t vals[knum_peers];
+    RcclLoadPeers<DataType_t, ElementType_t, NumGpus>(vals, peers, base, i,
+                                                      nontemporal);
+    RcclReducePeerVals<DataType_t, ElementType_t, Op, NumGpus>(result, vals);
+}
+
+//! @brief Reduce a range with peer loads software pipelined across iterations
+//! Workitem reduces dst[i] = src[i] op element i of all peers (see
+//! RcclLoadPeers) for i = first, first + stride, ... < count. Peer loads of
+//! the next element of the workitem are issued into a second set of
+//! registers before the current element is reduced and stored, so the round
+//! trip of remote loads overlaps the work on previous element instead of being
+//! exposed on every iteration. Only called when NumGpus > 1
+template <typename DataType_t, typename ElementType_t, rcclRedOp_t Op,
+          int NumGpus>
+__device__ inline void RcclReducePeersPipelined(
+    ElementType_t* dst, const ElementType_t* src, const RcclPeerTable_t& peers,
+    int base, int first, int count, int stride, bool nontemporal = false) {
+    constexpr int knum_peers = NumGpus > 1 ? NumGpus - 1 : 1;
+    ElementType_t vals[knum_peers];
+    ElementType_t next_vals[knum_peers];
+
+    if (first < count) {
+        RcclLoadPeers<DataType_t, ElementType_t, NumGpus>(vals, peers, base,
+                                                          first, nontemporal);
+    }
+
+    for (int i = first; i < count; i += stride) {
+        ElementType_t result;
+        RcclLoad(result, src + i, nontemporal);
+
+        //! Stage peer data of next iteration while reducing current one
+        int next = i + stride;
+        if (next < count) {
+            RcclLoadPeers<DataType_t, ElementType_t, NumGpus>(
+                next_vals, peers, base, next, nontemporal);
+        }
+
+        RcclReducePeerVals<DataType_t, ElementType_t, Op, NumGpus>(result,
+                                                                   vals);
+        RcclStore(dst + i, result, nontemporal);
+
+#pragma unroll
+        for (int peer = 0; peer < knum_peers; peer++) {
+            vals[peer] = next_vals[peer];
+        }
+    }
+}
+
+//! @brief Copy count elements from src to dst using all workitems in grid
+//! Falls back to scalar copy if src and dst have different alignment. Uses
+//! streaming accesses if nontemporal is set
+template <typename DataType_t, typename VectorType_t>
+__device__ inline void RcclCopyVectorRange(DataType_t* dst,
+                                           const DataType_t* src, int count,
+                                           bool nontemporal = false) {
+    constexpr int kwidth = sizeof(VectorType_t) / sizeof(DataType_t);
+    int tid = threadIdx.x + blockIdx.x * blockDim.x;
+    int stride = blockDim.x * gridDim.x;
+
+    int head = RcclIsSameVectorAlignment<VectorType_t>(dst, src)
+                   ? RcclGetVectorHead<DataType_t, VectorType_t>(dst, count)
+                   : count;
+    int num_vectors = (count - head) / kwidth;
+    int tail = head + num_vectors * kwidth;
+
+    //! Scalar head and tail
+    for (int i = tid; i < head; i += stride) {
+        RcclCopyElement(dst + i, src + i, nontemporal);
+    }
+    for (int i = tail + tid; i < count; i += stride) {
+        RcclCopyElement(dst + i, src + i, nontemporal);
+    }
+
+    //! Body, one 16 byte load and store per iteration
+    VectorType_t* vdst = reinterpret_cast<VectorType_t*>(dst + head);
+    const VectorType_t* vsrc =
+        reinterpret_cast<const VectorType_t*>(src + head);
+    for (int i = tid; i < num_vectors; i += stride) {
+        RcclCopyElement(vdst + i, vsrc + i, nontemporal);
+    }
+}
+
+//! @brief Get launch configuration of a kernel using VectorType_t
+//! Launch one workitem per vector, grid is capped by RcclGetLaunchDims
+template <typename DataType_t, typename VectorType_t>
+inline void RcclGetVectorLaunchDims(const RingNode_t* pcurr_track, int count,
+                                    int* num_workitems, int* num_workgroups,
+                                    int grid_height = 1) {
+    constexpr int kwidth = sizeof(VectorType_t) / sizeof(DataType_t);
+    int num_vectors = (count + kwidth - 1) / kwidth;
+    RcclGetLaunchDims(pcurr_track, num_vectors, num_workitems, num_workgroups,
+                      grid_height);
+}
@@ -0,0 +1,33 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+#pragma once
+
+/**
+ * @file rcclVectorReduceKernels.h
+ * @brief Kernels to implement reduce operation with 16 byte accesses
+ *
+ * This file contains vectorized version of kernel in
+ * rcclScalarReduceKernels.h
+ */
+
+#include "rcclVectorAllReduceKernels.h"
+
+//! @brief Definition of RcclKernelVectorReduce
+//! Gather data from non-root gpus and do reduction op on it. It is the same
+//! as allreduce on the whole buffer
+template <typename DataType_t, typename VectorType_t, rcclRedOp_t Op,
+          int NumGpus>
+__global__ void RcclKernelVectorReduce(RingNode_t* pcurr_track,
+                                       const void* send_buff, void* recv_buff,
+                                       int count, bool nontemporal) {
+    __shared__ RcclPeerTable_t peers;
+    RcclLoadPeerTable(pcurr_track, &peers);
+
+    RcclAllReduceVectorRange<DataType_t, VectorType_t, Op, NumGpus>(
+        peers, send_buff, recv_buff, count, 0, nontemporal);
+
+    RcclReleaseFence();
+}
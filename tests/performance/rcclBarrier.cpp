@@ -0,0 +1,56 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+//
+// Runs the multi-gpu barrier protocol (src/rcclBarrier.h) on host threads
+// and prints average time per barrier instance
+//
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "rcclBarrier.h"
+
+double TimeBarrier(int num_threads, int num_iters) {
+    Barrier_t barrier;
+    for (auto& arrived : barrier.arrived) arrived = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < num_iters; i++) {
+                RcclBarrierWait(&barrier, t, i, num_threads);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    auto stop = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration_cast<std::chrono::duration<double>>(stop -
+                                                                     start)
+               .count() /
+           num_iters;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cout << "Usage: ./a.out <max threads> <num iterations>"
+                  << std::endl;
+        std::cout << "./a.out 8 100000" << std::endl;
+        return 0;
+    }
+
+    int max_threads = atoi(argv[1]);
+    int num_iters = atoi(argv[2]);
+    for (int num_threads = 2; num_threads <= max_threads; num_threads++) {
+        std::cout << "Threads: " << num_threads << " Barrier: "
+                  << TimeBarrier(num_threads, num_iters) * 1.0E9 << " ns"
+                  << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,162 @@
+#include <cstdio>
+#include <fstream>
+#include "gtest/gtest.h"
+#include "rcclAlgoSelector.h"
+
+//
+// Forced algorithm is used if collective implements it for number of gpus,
+// otherwise cost model picks one
+//
+TEST(AlgoSelectorTest, Forced) {
+    RcclAlgoSelector_t selector;
+    EXPECT_EQ(krccl_algo_ring,
+              selector.Select(krccl_coll_allreduce, 4, 1 << 20, 4,
+                              krccl_topo_pcie, krccl_algo_ring));
+    EXPECT_EQ(krccl_algo_rhd,
+              selector.Select(krccl_coll_allreduce, 4, 1 << 20, 8,
+                              krccl_topo_pcie, krccl_algo_rhd));
+    EXPECT_NE(krccl_algo_rhd,
+              selector.Select(krccl_coll_allreduce, 4, 1 << 20, 6,
+                              krccl_topo_pcie, krccl_algo_rhd));
+    EXPECT_EQ(krccl_algo_mesh,
+              selector.Select(krccl_coll_bcast, 4, 1 << 20, 4,
+                              krccl_topo_pcie, krccl_algo_tree));
+}
+
+//
+// Selected algorithm is always supported and has the lowest estimate
+//
+TEST(AlgoSelectorTest, Cheapest) {
+    RcclAlgoSelector_t selector;
+    for (int coll = 0; coll < krccl_num_colls; coll++) {
+        for (int topo = 0; topo < krccl_num_topos; topo++) {
+            for (int num_gpus = 2; num_gpus <= 16; num_gpus++) {
+                for (size_t count = 1; count <= (1 << 26); count *= 4) {
+                    RcclCollective_t c = static_cast<RcclCollective_t>(coll);
+                    RcclTopology_t t = static_cast<RcclTopology_t>(topo);
+                    RcclAlgo_t algo = selector.Select(
+                        c, 4, count, num_gpus, t, krccl_algo_default);
+                    ASSERT_TRUE(selector.IsSupported(c, algo, num_gpus));
+                    double time =
+                        selector.EstimateTime(c, algo, t, 4 * count, num_gpus);
+                    for (int i = krccl_algo_mesh; i < krccl_num_algos; i++) {
+                        EXPECT_LE(time, selector.EstimateTime(
+                                            c, static_cast<RcclAlgo_t>(i), t,
+                                            4 * count, num_gpus));
+                    }
+                }
+            }
+        }
+    }
+}
+
+//
+// Tiny allreduce is latency bound, large one is bandwidth bound
+//
+TEST(AlgoSelectorTest, Defaults) {
+    RcclAlgoSelector_t selector;
+    EXPECT_EQ(krccl_algo_oneshot,
+              selector.Select(krccl_coll_allreduce, 4, 256, 8,
+                              krccl_topo_pcie, krccl_algo_default));
+    EXPECT_NE(krccl_algo_oneshot,
+              selector.Select(krccl_coll_allreduce, 4, 1 << 24, 8,
+                              krccl_topo_pcie, krccl_algo_default));
+    EXPECT_EQ(krccl_algo_ring,
+              selector.Select(krccl_coll_allreduce, 4, 1 << 24, 6,
+                              krccl_topo_pcie, krccl_algo_default));
+}
+
+//
+// One-shot allreduce is not picked above its size limit, even where the
+// model alone prefers it
+//
+TEST(AlgoSelectorTest, OneShotLimit) {
+    RcclAlgoSelector_t selector;
+    for (int num_gpus = 2; num_gpus <= 8; num_gpus++) {
+        EXPECT_EQ(krccl_algo_oneshot,
+                  selector.Select(krccl_coll_allreduce, 4, 1024, num_gpus,
+                                  krccl_topo_xgmi, krccl_algo_default));
+        EXPECT_NE(krccl_algo_oneshot,
+                  selector.Select(krccl_coll_allreduce, 4, 1 << 15, num_gpus,
+                                  krccl_topo_xgmi, krccl_algo_default));
+    }
+
+    selector.SetMaxOneShotBytes(krccl_topo_xgmi, 1 << 20);
+    EXPECT_EQ(krccl_algo_oneshot,
+              selector.Select(krccl_coll_allreduce, 4, 1 << 15, 2,
+                              krccl_topo_xgmi, krccl_algo_default));
+    EXPECT_EQ(krccl_algo_oneshot,
+              selector.Select(krccl_coll_allreduce, 4, 1 << 24, 2,
+                              krccl_topo_xgmi, krccl_algo_oneshot));
+}
+
+//
+// Tuning table changes the choice, and survives a save and load
+//
+TEST(AlgoSelectorTest, TuningFile) {
+    const char* path = "rcclAlgoSelectorTest.txt";
+    {
+        std::ofstream file(path);
+        file << "# make ring free\n\n";
+        file << "allreduce pcie ring 0 0\n";
+        file << "channels xgmi 2\n";
+        file << "push pcie 0\n";
+    }
+
+    RcclAlgoSelector_t selector;
+    ASSERT_TRUE(selector.LoadTuningFile(path));
+    EXPECT_EQ(krccl_algo_ring,
+              selector.Select(krccl_coll_allreduce, 4, 256, 8,
+                              krccl_topo_pcie, krccl_algo_default));
+    EXPECT_NE(krccl_algo_ring,
+              selector.Select(krccl_coll_allreduce, 4, 256, 8,
+                              krccl_topo_xgmi, krccl_algo_default));
+    EXPECT_EQ(2, selector.GetNumChannels(krccl_topo_xgmi));
+    EXPECT_FALSE(selector.GetPush(krccl_topo_pcie));
+    selector.SetPush(krccl_topo_xgmi, true);
+
+    RcclAlgoCost_t cost = {1.5, 2.5e-5};
+    selector.SetCost(krccl_coll_allgather, krccl_topo_xgmi, krccl_algo_mesh,
+                     cost);
+    ASSERT_TRUE(selector.SaveTuningFile(path));
+
+    RcclAlgoSelector_t loaded;
+    ASSERT_TRUE(loaded.LoadTuningFile(path));
+    for (int coll = 0; coll < krccl_num_colls; coll++) {
+        for (int topo = 0; topo < krccl_num_topos; topo++) {
+            for (int algo = krccl_algo_mesh; algo < krccl_num_algos; algo++) {
+                RcclCollective_t c = static_cast<RcclCollective_t>(coll);
+                RcclTopology_t t = static_cast<RcclTopology_t>(topo);
+                RcclAlgo_t a = static_cast<RcclAlgo_t>(algo);
+                EXPECT_EQ(selector.GetCost(c, t, a).alpha,
+                          loaded.GetCost(c, t, a).alpha);
+                EXPECT_EQ(selector.GetCost(c, t, a).beta,
+                          loaded.GetCost(c, t, a).beta);
+            }
+            RcclTopology_t t = static_cast<RcclTopology_t>(topo);
+            EXPECT_EQ(selector.GetNumChannels(t), loaded.GetNumChannels(t));
+            EXPECT_EQ(selector.GetPush(t), loaded.GetPush(t));
+            EXPECT_EQ(selector.GetMaxOneShotBytes(t),
+                      loaded.GetMaxOneShotBytes(t));
+        }
+    }
+
+    {
+        std::ofstream file(path);
+        file << "allreduce pcie mesh 7 7\n";
+        file << "channels pcie\n";
+    }
+    EXPECT_FALSE(loaded.LoadTuningFile(path));
+    EXPECT_EQ(selector.GetCost(krccl_coll_allreduce, krccl_topo_pcie,
+                               krccl_algo_mesh).alpha,
+              loaded.GetCost(krccl_coll_allreduce, krccl_topo_pcie,
+                             krccl_algo_mesh).alpha);
+    {
+        std::ofstream file(path);
+        file << "push xgmi 2\n";
+    }
+    EXPECT_FALSE(loaded.LoadTuningFile(path));
+    EXPECT_FALSE(loaded.LoadTuningFile("rcclAlgoSelectorMissing.txt"));
+
+    remove(path);
+}
@@ -0,0 +1,41 @@
+#include <rccl/rccl.h>
+#include "gtest/gtest.h"
+
+TEST(AllReduceMultiTest, T01) {
+    size_t counts[1] = {1};
+    EXPECT_EQ(rcclInvalidArgument,
+              rcclAllReduceMulti(nullptr, nullptr, counts, 1, rcclFloat,
+                                 rcclSum, nullptr, 0));
+}
+TEST(AllReduceMultiTest, T02) {
+    rcclUniqueId id;
+    rcclComm_t comm;
+    float* buff;
+    EXPECT_EQ(hipSuccess, hipMalloc(&buff, 2048 * sizeof(float)));
+    EXPECT_EQ(rcclSuccess, rcclGetUniqueId(&id));
+    EXPECT_EQ(rcclSuccess, rcclCommInitRank(&comm, 1, id, 0));
+
+    const void* sendbuffs[2] = {buff, buff + 512};
+    void* recvbuffs[2] = {buff + 1024, nullptr};
+    size_t counts[2] = {512, 512};
+    EXPECT_EQ(rcclInvalidDevicePointer,
+              rcclAllReduceMulti(sendbuffs, recvbuffs, counts, 2, rcclFloat,
+                                 rcclSum, comm, 0));
+    recvbuffs[1] = buff + 1536;
+    EXPECT_EQ(rcclInvalidArgument,
+              rcclAllReduceMulti(sendbuffs, recvbuffs, counts, 0, rcclFloat,
+                                 rcclSum, comm, 0));
+    counts[1] = 0;
+    EXPECT_EQ(rcclInvalidArgument,
+              rcclAllReduceMulti(sendbuffs, recvbuffs, counts, 2, rcclFloat,
+                                 rcclSum, comm, 0));
+    counts[1] = size_t(1) << 31;
+    EXPECT_EQ(rcclInvalidArgument,
+              rcclAllReduceMulti(sendbuffs, recvbuffs, counts, 2, rcclFloat,
+                                 rcclSum, comm, 0));
+    counts[1] = 512;
+    EXPECT_EQ(rcclInvalidOperation,
+              rcclAllReduceMulti(sendbuffs, recvbuffs, counts, 2, rcclFloat,
+                                 rccl_NUM_OPS, comm, 0));
+    EXPECT_EQ(hipSuccess, hipFree(buff));
+}
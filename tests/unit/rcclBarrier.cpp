@@ -0,0 +1,140 @@
+#include <atomic>
+#include <climits>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "rcclBarrier.h"
+
+//
+// Run num_iters barrier instances starting at first_time on num_threads host
+// threads. No thread may leave an instance before every thread entered it
+//
+static void RunBarrier(int num_threads, int first_time, int num_iters) {
+    Barrier_t barrier;
+    for (int t = 0; t < num_threads; t++) {
+        barrier.arrived[t] = static_cast<unsigned int>(first_time);
+    }
+
+    std::vector<std::atomic<int>> entered(num_threads);
+    for (auto& count : entered) count = 0;
+    std::atomic<int> errors(0);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < num_iters; i++) {
+                entered[t] = i + 1;
+                RcclBarrierWait(&barrier, t, first_time + i, num_threads);
+                for (int peer = 0; peer < num_threads; peer++) {
+                    if (entered[peer] < i + 1) errors++;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    EXPECT_EQ(0, errors.load());
+    EXPECT_TRUE(
+        RcclBarrierIsDone(&barrier, first_time + num_iters - 1, num_threads));
+    EXPECT_FALSE(
+        RcclBarrierIsDone(&barrier, first_time + num_iters, num_threads));
+}
+
+//
+// Threads never run ahead of the slowest one
+//
+TEST(BarrierTest, Wait) {
+    for (int num_threads = 1; num_threads <= 4; num_threads++) {
+        RunBarrier(num_threads, 0, 200);
+    }
+}
+
+//
+// Arrival entries wrap around 2^32 in the middle of the run
+//
+TEST(BarrierTest, WrapAround) {
+    for (int num_threads = 2; num_threads <= 4; num_threads++) {
+        int first_time = static_cast<int>(UINT_MAX) - 20;
+        RunBarrier(num_threads, first_time, 40);
+    }
+}
+
+//
+// WaitDone does not enter the barrier and returns once everyone else did
+//
+TEST(BarrierTest, WaitDone) {
+    const int num_threads = 4;
+    Barrier_t barrier;
+    for (auto& arrived : barrier.arrived) arrived = 0;
+
+    std::atomic<bool> done(false);
+    std::thread watcher([&]() {
+        RcclBarrierWaitDone(&barrier, 0, num_threads);
+        done = true;
+    });
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads - 1; t++) {
+        threads.emplace_back(
+            [&, t]() { RcclBarrierWait(&barrier, t, 0, num_threads); });
+    }
+    for (int t = 0; t < num_threads - 1; t++) {
+        while (barrier.arrived[t].load() != 1) {
+        }
+    }
+    EXPECT_FALSE(done.load());
+
+    RcclBarrierArrive(&barrier, num_threads - 1, 0);
+    watcher.join();
+    for (auto& thread : threads) thread.join();
+    EXPECT_TRUE(done.load());
+}
+
+//
+// Flag set for an epoch is seen as set for it and all earlier epochs only
+//
+TEST(PeerFlagTest, IsSet) {
+    std::atomic<unsigned int> flag(0);
+    EXPECT_FALSE(RcclFlagIsSet(&flag, 0));
+
+    RcclFlagSet(&flag, 3);
+    EXPECT_TRUE(RcclFlagIsSet(&flag, 0));
+    EXPECT_TRUE(RcclFlagIsSet(&flag, 3));
+    EXPECT_FALSE(RcclFlagIsSet(&flag, 4));
+
+    // Epoch counter wraps around 2^32
+    int last_epoch = static_cast<int>(UINT_MAX);
+    RcclFlagSet(&flag, last_epoch);
+    EXPECT_TRUE(RcclFlagIsSet(&flag, last_epoch - 1));
+    EXPECT_FALSE(RcclFlagIsSet(&flag, last_epoch + 1));
+    RcclFlagSet(&flag, last_epoch + 1);
+    EXPECT_TRUE(RcclFlagIsSet(&flag, last_epoch + 1));
+}
+
+//
+// Root publishes data to a peer with ready and waits for done, like rcclBcast
+//
+TEST(PeerFlagTest, ReadyDone) {
+    const int num_epochs = 200;
+    RcclPeerFlags_t root_to_peer, peer_to_root;
+    root_to_peer.ready = 0;
+    peer_to_root.done = 0;
+    int data = -1;
+    std::atomic<int> errors(0);
+
+    std::thread peer([&]() {
+        for (int epoch = 0; epoch < num_epochs; epoch++) {
+            RcclFlagWait(&(root_to_peer.ready), epoch);
+            if (data != epoch) errors++;
+            RcclFlagSet(&(peer_to_root.done), epoch);
+        }
+    });
+    for (int epoch = 0; epoch < num_epochs; epoch++) {
+        data = epoch;
+        RcclFlagSet(&(root_to_peer.ready), epoch);
+        RcclFlagWait(&(peer_to_root.done), epoch);
+    }
+    peer.join();
+
+    EXPECT_EQ(0, errors.load());
+}
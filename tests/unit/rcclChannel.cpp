@@ -0,0 +1,52 @@
+#include <vector>
+#include "gtest/gtest.h"
+#include "rcclChannel.h"
+
+//
+// Ring of every channel visits all the ranks, and prev/next/position agree
+// with each other
+//
+TEST(ChannelTest, Rings) {
+    for (int num_ranks = 1; num_ranks <= 16; num_ranks++) {
+        for (int channel = 0; channel < kmax_channels; channel++) {
+            std::vector<int> visited(num_ranks, 0);
+            for (int rank = 0; rank < num_ranks; rank++) {
+                RcclChannelRing_t ring;
+                RcclGetChannelRing(num_ranks, rank, channel, &ring);
+                ASSERT_LT(ring.position, num_ranks);
+                EXPECT_EQ(rank,
+                          RcclGetChannelRank(num_ranks, channel,
+                                             ring.position));
+                EXPECT_EQ(ring.prev,
+                          RcclGetChannelRank(
+                              num_ranks, channel,
+                              (ring.position + num_ranks - 1) % num_ranks));
+                EXPECT_EQ(ring.next,
+                          RcclGetChannelRank(num_ranks, channel,
+                                             (ring.position + 1) % num_ranks));
+                visited[ring.position]++;
+            }
+            for (int position = 0; position < num_ranks; position++) {
+                EXPECT_EQ(1, visited[position]);
+            }
+        }
+    }
+}
+
+//
+// Neighbouring channels go around the same ring in opposite directions, and
+// more channels read from more peers
+//
+TEST(ChannelTest, Peers) {
+    for (int num_ranks = 3; num_ranks <= 16; num_ranks++) {
+        for (int channel = 0; channel + 1 < kmax_channels; channel += 2) {
+            EXPECT_EQ(num_ranks,
+                      RcclGetChannelStride(num_ranks, channel) +
+                          RcclGetChannelStride(num_ranks, channel + 1));
+        }
+        EXPECT_EQ(1, RcclGetNumChannelPeers(num_ranks, 1));
+        EXPECT_EQ(2, RcclGetNumChannelPeers(num_ranks, 2));
+    }
+    EXPECT_EQ(1, RcclGetNumChannelPeers(2, kmax_channels));
+    EXPECT_EQ(4, RcclGetNumChannelPeers(8, 4));
+}
@@ -0,0 +1,36 @@
+#include <rccl/rccl.h>
+#include "gtest/gtest.h"
+
+TEST(CommRegisterTest, T01) {
+    rcclRegHandle_t handle;
+    int buff;
+    EXPECT_EQ(rcclInvalidArgument,
+              rcclCommRegister(nullptr, &buff, sizeof(buff), &handle));
+    EXPECT_EQ(rcclInvalidArgument, rcclCommDeregister(nullptr, nullptr));
+}
+TEST(CommRegisterTest, T02) {
+    rcclUniqueId id;
+    rcclComm_t comm;
+    rcclRegHandle_t handle;
+    EXPECT_EQ(rcclSuccess, rcclGetUniqueId(&id));
+    EXPECT_EQ(rcclSuccess, rcclCommInitRank(&comm, 1, id, 0));
+    EXPECT_EQ(rcclInvalidDevicePointer,
+              rcclCommRegister(comm, nullptr, 4, &handle));
+    EXPECT_EQ(rcclInvalidArgument, rcclCommDeregister(comm, nullptr));
+}
+TEST(CommRegisterTest, T03) {
+    rcclUniqueId id;
+    rcclComm_t comm;
+    rcclRegHandle_t handle;
+    float* buff;
+    EXPECT_EQ(hipSuccess, hipMalloc(&buff, 1024 * sizeof(float)));
+    EXPECT_EQ(rcclSuccess, rcclGetUniqueId(&id));
+    EXPECT_EQ(rcclSuccess, rcclCommInitRank(&comm, 1, id, 0));
+    EXPECT_EQ(rcclInvalidArgument, rcclCommRegister(comm, buff, 0, &handle));
+    EXPECT_EQ(rcclInvalidArgument,
+              rcclCommRegister(comm, buff, 1024 * sizeof(float), nullptr));
+    EXPECT_EQ(rcclSuccess,
+              rcclCommRegister(comm, buff, 1024 * sizeof(float), &handle));
+    EXPECT_EQ(rcclSuccess, rcclCommDeregister(comm, handle));
+    EXPECT_EQ(hipSuccess, hipFree(buff));
+}
@@ -0,0 +1,33 @@
+#include <rccl/rccl.h>
+#include "gtest/gtest.h"
+
+TEST(Count64Test, T01) {
+    EXPECT_EQ(rcclInvalidDevicePointer,
+              rcclAllReduce64(nullptr, nullptr, 1, rcclFloat, rcclSum, nullptr,
+                              0));
+    EXPECT_EQ(rcclInvalidDevicePointer,
+              rcclAllGather64(nullptr, size_t(1) << 31, rcclFloat, nullptr,
+                              nullptr, 0));
+}
+TEST(Count64Test, T02) {
+    rcclUniqueId id;
+    rcclComm_t comm;
+    float* buff;
+    EXPECT_EQ(hipSuccess, hipMalloc(&buff, 1024 * sizeof(float)));
+    EXPECT_EQ(rcclSuccess, rcclGetUniqueId(&id));
+    EXPECT_EQ(rcclSuccess, rcclCommInitRank(&comm, 1, id, 0));
+    EXPECT_EQ(rcclInvalidArgument,
+              rcclAllReduce64(buff, buff, 0, rcclFloat, rcclSum, comm, 0));
+    EXPECT_EQ(rcclInvalidArgument, rcclBcast64(buff, 0, rcclFloat, 0, comm, 0));
+    EXPECT_EQ(rcclInvalidType,
+              rcclAllGather64(buff, size_t(1) << 31, rccl_NUM_TYPES, buff,
+                              comm, 0));
+
+    // Chunked allgather is refused inside a group, before reading buffers
+    EXPECT_EQ(rcclSuccess, rcclGroupStart());
+    EXPECT_EQ(rcclInvalidArgument,
+              rcclAllGather64(buff, size_t(1) << 31, rcclFloat, buff, comm,
+                              0));
+    EXPECT_EQ(rcclSuccess, rcclGroupEnd());
+    EXPECT_EQ(hipSuccess, hipFree(buff));
+}
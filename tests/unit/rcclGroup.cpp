@@ -0,0 +1,30 @@
+#include <rccl/rccl.h>
+#include "gtest/gtest.h"
+
+TEST(GroupTest, T01) {
+    EXPECT_EQ(rcclInvalidArgument, rcclGroupEnd());
+}
+TEST(GroupTest, T02) {
+    EXPECT_EQ(rcclSuccess, rcclGroupStart());
+    EXPECT_EQ(rcclSuccess, rcclGroupStart());
+    EXPECT_EQ(rcclSuccess, rcclGroupEnd());
+    EXPECT_EQ(rcclSuccess, rcclGroupEnd());
+    EXPECT_EQ(rcclInvalidArgument, rcclGroupEnd());
+}
+TEST(GroupTest, T03) {
+    rcclUniqueId id;
+    rcclComm_t comm;
+    float* buff;
+    EXPECT_EQ(hipSuccess, hipMalloc(&buff, 1024 * sizeof(float)));
+    EXPECT_EQ(rcclSuccess, rcclGetUniqueId(&id));
+    EXPECT_EQ(rcclSuccess, rcclCommInitRank(&comm, 1, id, 0));
+    EXPECT_EQ(rcclSuccess, rcclGroupStart());
+    EXPECT_EQ(rcclInvalidDevicePointer,
+              rcclAllReduce(nullptr, buff, 256, rcclFloat, rcclSum, comm, 0));
+    EXPECT_EQ(rcclInvalidArgument,
+              rcclAllReduce(buff, buff, 0, rcclFloat, rcclSum, comm, 0));
+    EXPECT_EQ(rcclInvalidType, rcclAllReduce(buff, buff, 256, rccl_NUM_TYPES,
+                                             rcclSum, comm, 0));
+    EXPECT_EQ(rcclSuccess, rcclGroupEnd());
+    EXPECT_EQ(hipSuccess, hipFree(buff));
+}
@@ -0,0 +1,37 @@
+#include <rccl/rccl.h>
+#include "gtest/gtest.h"
+
+TEST(PlanTest, T01) {
+    rcclPlan_t plan;
+    EXPECT_EQ(rcclInvalidDevicePointer,
+              rcclAllReducePlanCreate(nullptr, nullptr, 1, rcclFloat, rcclSum,
+                                      nullptr, &plan));
+    EXPECT_EQ(rcclInvalidArgument, rcclPlanExecute(nullptr, 0));
+    EXPECT_EQ(rcclInvalidArgument, rcclPlanDestroy(nullptr));
+}
+TEST(PlanTest, T02) {
+    rcclUniqueId id;
+    rcclComm_t comm;
+    rcclPlan_t plan;
+    float* buff;
+    EXPECT_EQ(hipSuccess, hipMalloc(&buff, 1024 * sizeof(float)));
+    EXPECT_EQ(rcclSuccess, rcclGetUniqueId(&id));
+    EXPECT_EQ(rcclSuccess, rcclCommInitRank(&comm, 1, id, 0));
+    EXPECT_EQ(rcclInvalidArgument,
+              rcclAllReducePlanCreate(buff, buff, 0, rcclFloat, rcclSum, comm,
+                                      &plan));
+    EXPECT_EQ(rcclInvalidType,
+              rcclAllReducePlanCreate(buff, buff, 512, rccl_NUM_TYPES, rcclSum,
+                                      comm, &plan));
+    EXPECT_EQ(rcclInvalidOperation,
+              rcclAllReducePlanCreate(buff, buff, 512, rcclFloat, rccl_NUM_OPS,
+                                      comm, &plan));
+    EXPECT_EQ(rcclInvalidArgument,
+              rcclAllReducePlanCreate(buff, buff, 512, rcclFloat, rcclSum, comm,
+                                      nullptr));
+    EXPECT_EQ(rcclSuccess, rcclAllReducePlanCreate(buff, buff + 512, 512,
+                                                   rcclFloat, rcclSum, comm,
+                                                   &plan));
+    EXPECT_EQ(rcclSuccess, rcclPlanDestroy(plan));
+    EXPECT_EQ(hipSuccess, hipFree(buff));
+}
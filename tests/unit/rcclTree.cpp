@@ -0,0 +1,79 @@
+#include <algorithm>
+#include <vector>
+#include "gtest/gtest.h"
+#include "rcclTree.h"
+
+//
+// Every rank except root has a parent which lists it as a child, and
+// depth/height are consistent with the links
+//
+TEST(TreeTest, Links) {
+    for (int num_ranks = 1; num_ranks <= 16; num_ranks++) {
+        for (int tree = 0; tree < knum_trees; tree++) {
+            std::vector<RcclTreeNode_t> nodes(num_ranks);
+            for (int rank = 0; rank < num_ranks; rank++) {
+                RcclGetTreeNode(num_ranks, rank, tree, &nodes[rank]);
+            }
+            int num_roots = 0;
+            for (int rank = 0; rank < num_ranks; rank++) {
+                const RcclTreeNode_t& node = nodes[rank];
+                EXPECT_EQ(nodes[0].tree_height, node.tree_height);
+                EXPECT_LE(node.depth + node.height, node.tree_height);
+                if (node.parent == -1) {
+                    num_roots++;
+                    EXPECT_EQ(0, node.depth);
+                    EXPECT_EQ(node.tree_height, node.height);
+                } else {
+                    const RcclTreeNode_t& parent = nodes[node.parent];
+                    EXPECT_TRUE(parent.children[0] == rank ||
+                                parent.children[1] == rank);
+                    EXPECT_EQ(parent.depth + 1, node.depth);
+                    EXPECT_LT(node.height, parent.height);
+                }
+                for (int i = 0; i < 2; i++) {
+                    int child = node.children[i];
+                    if (child != -1) {
+                        ASSERT_LT(child, num_ranks);
+                        EXPECT_EQ(rank, nodes[child].parent);
+                    }
+                }
+                if (node.children[0] == -1 && node.children[1] == -1) {
+                    EXPECT_EQ(0, node.height);
+                }
+            }
+            EXPECT_EQ(1, num_roots);
+        }
+    }
+}
+
+//
+// Tree height grows logarithmically with number of ranks
+//
+TEST(TreeTest, Height) {
+    for (int num_ranks = 2; num_ranks <= 16; num_ranks++) {
+        int log2 = 0;
+        while ((1 << log2) < num_ranks) log2++;
+        RcclTreeNode_t nodes[knum_trees];
+        RcclGetDoubleBinaryTree(num_ranks, 0, nodes);
+        EXPECT_LE(nodes[0].tree_height, log2);
+        EXPECT_LE(nodes[1].tree_height, log2);
+    }
+}
+
+//
+// Interior ranks of one tree are leaves of the other, except rank 0 which
+// has a single child in tree 0 when number of ranks is odd
+//
+TEST(TreeTest, Complementary) {
+    for (int num_ranks = 2; num_ranks <= 16; num_ranks++) {
+        for (int rank = 0; rank < num_ranks; rank++) {
+            RcclTreeNode_t nodes[knum_trees];
+            RcclGetDoubleBinaryTree(num_ranks, rank, nodes);
+            bool interior0 = nodes[0].height > 0;
+            bool interior1 = nodes[1].height > 0;
+            if (num_ranks % 2 == 0 || rank != 0) {
+                EXPECT_FALSE(interior0 && interior1);
+            }
+        }
+    }
+}
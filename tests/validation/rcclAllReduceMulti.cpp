@@ -0,0 +1,192 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+#include "rccl/rccl.h"
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include "common.h"
+#include "validation/validate.h"
+
+//
+// Number of batches of tensors allreduced on every gpu. Each batch has its
+// own stream, so that batches can be in flight at the same time on more than
+// the sync slots of a communicator. A batch has knum_tensors tensors with
+// counts going through kcount_steps
+//
+constexpr int knum_batches = 9;
+constexpr int knum_tensors = 37;
+const std::vector<size_t> kcount_steps = {1, 3, 255, 1024, 4099, 65536};
+
+//
+// Count of tensor of a batch, tensors of the same batch have different sizes
+//
+size_t TensorCount(int batch, int tensor) {
+    return kcount_steps[(batch + tensor) % kcount_steps.size()];
+}
+
+//
+// Order in which batches are made on gpus
+//
+enum BatchOrder_t {
+    // A batch is made on all gpus before the next batch
+    kbatch_major = 0,
+    // All batches are made on a gpu before the next gpu
+    kgpu_major,
+    // Same as kgpu_major, gpus in reverse order
+    kgpu_major_reverse
+};
+
+bool MultiAllReduceTest(std::vector<int>& device_list,
+                        std::vector<rcclComm_t>& rccl_comms,
+                        BatchOrder_t order) {
+    size_t num_gpus = device_list.size();
+
+    // Tensors of a batch are laid out one after another in a buffer, with one
+    // element between them which must not be written
+    std::vector<size_t> offsets(knum_batches * knum_tensors);
+    std::vector<size_t> buff_lens(knum_batches);
+    for (int batch = 0; batch < knum_batches; batch++) {
+        size_t buff_len = 0;
+        for (int tensor = 0; tensor < knum_tensors; tensor++) {
+            offsets[batch * knum_tensors + tensor] = buff_len;
+            buff_len += TensorCount(batch, tensor) + 1;
+        }
+        buff_lens[batch] = buff_len;
+    }
+
+    size_t num_buffers = knum_batches * num_gpus;
+    std::vector<float*> src_host_buffers(num_buffers);
+    std::vector<float*> dst_host_buffers(num_buffers);
+    std::vector<float*> src_device_buffers(num_buffers);
+    std::vector<float*> dst_device_buffers(num_buffers);
+    std::vector<hipStream_t> streams(num_buffers);
+
+    for (int batch = 0; batch < knum_batches; batch++) {
+        size_t buff_size = buff_lens[batch] * sizeof(float);
+        for (size_t i = 0; i < num_gpus; i++) {
+            size_t index = batch * num_gpus + i;
+            HIPCHECK(hipHostMalloc(&src_host_buffers[index], buff_size));
+            HIPCHECK(hipHostMalloc(&dst_host_buffers[index], buff_size));
+            std::fill(src_host_buffers[index],
+                      src_host_buffers[index] + buff_lens[batch],
+                      static_cast<float>(kbuffer_values[device_list[i]] *
+                                         (batch + 1)));
+        }
+    }
+
+    {  // used new scope to force current-device guard to destruct after
+       // changing active device
+        CurrDeviceGuard_t g;
+        for (size_t index = 0; index < num_buffers; index++) {
+            size_t buff_size = buff_lens[index / num_gpus] * sizeof(float);
+            HIPCHECK(hipSetDevice(device_list[index % num_gpus]));
+            HIPCHECK(hipStreamCreate(&streams[index]));
+            HIPCHECK(hipMalloc(&src_device_buffers[index], buff_size));
+            HIPCHECK(hipMalloc(&dst_device_buffers[index], buff_size));
+            HIPCHECK(hipMemcpy(src_device_buffers[index],
+                               src_host_buffers[index], buff_size,
+                               hipMemcpyHostToDevice));
+            HIPCHECK(hipMemset(dst_device_buffers[index], 0, buff_size));
+        }
+    }
+
+    // In gpu major order a gpu takes sync slots long before its peers do, and
+    // reuses them while its earlier batches still wait for peers
+    std::vector<const void*> sendbuffs(knum_tensors);
+    std::vector<void*> recvbuffs(knum_tensors);
+    std::vector<size_t> counts(knum_tensors);
+    for (size_t n = 0; n < num_buffers; n++) {
+        int batch = order == kbatch_major ? n / num_gpus : n % knum_batches;
+        size_t i = order == kbatch_major ? n % num_gpus : n / knum_batches;
+        if (order == kgpu_major_reverse) i = num_gpus - 1 - i;
+        size_t index = batch * num_gpus + i;
+        HIPCHECK(hipSetDevice(device_list[i]));
+        for (int tensor = 0; tensor < knum_tensors; tensor++) {
+            size_t offset = offsets[batch * knum_tensors + tensor];
+            sendbuffs[tensor] = src_device_buffers[index] + offset;
+            recvbuffs[tensor] = dst_device_buffers[index] + offset;
+            counts[tensor] = TensorCount(batch, tensor);
+        }
+        RCCLCHECK(rcclAllReduceMulti(sendbuffs.data(), recvbuffs.data(),
+                                     counts.data(), knum_tensors,
+                                     rcclFloat, rcclSum, rccl_comms[i],
+                                     streams[index]));
+    }
+
+    bool passed = true;
+    for (int batch = 0; batch < knum_batches; batch++) {
+        float sum_val = 0.0f;
+        for (size_t i = 0; i < num_gpus; i++) {
+            sum_val += static_cast<float>(kbuffer_values[device_list[i]] *
+                                          (batch + 1));
+        }
+        std::vector<float> expected(buff_lens[batch], 0.0f);
+        for (int tensor = 0; tensor < knum_tensors; tensor++) {
+            size_t offset = offsets[batch * knum_tensors + tensor];
+            std::fill(expected.begin() + offset,
+                      expected.begin() + offset + TensorCount(batch, tensor),
+                      sum_val);
+        }
+
+        for (size_t i = 0; i < num_gpus; i++) {
+            size_t index = batch * num_gpus + i;
+            HIPCHECK(hipSetDevice(device_list[i]));
+            HIPCHECK(hipMemcpyAsync(dst_host_buffers[index],
+                                    dst_device_buffers[index],
+                                    buff_lens[batch] * sizeof(float),
+                                    hipMemcpyDeviceToHost, streams[index]));
+            HIPCHECK(hipStreamSynchronize(streams[index]));
+            if (!validate(dst_host_buffers[index], expected.data(),
+                          buff_lens[batch], 0, 0)) {
+                std::cerr << "batch " << batch << " failed on gpu "
+                          << device_list[i] << std::endl;
+                passed = false;
+            }
+        }
+    }
+
+    for (size_t index = 0; index < num_buffers; index++) {
+        HIPCHECK(hipSetDevice(device_list[index % num_gpus]));
+        HIPCHECK(hipFree(src_device_buffers[index]));
+        HIPCHECK(hipFree(dst_device_buffers[index]));
+        HIPCHECK(hipHostFree(src_host_buffers[index]));
+        HIPCHECK(hipHostFree(dst_host_buffers[index]));
+        HIPCHECK(hipStreamDestroy(streams[index]));
+    }
+
+    return passed;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::cout << "Usage: ./a.out <num gpus>" << std::endl;
+        std::cout << "./a.out 4" << std::endl;
+        return 0;
+    }
+
+    int num_gpus = atoi(argv[1]);
+    std::vector<int> device_list(num_gpus);
+    for (int i = 0; i < num_gpus; i++) {
+        device_list[i] = i;
+    }
+    EnableDevicePeerAccess(device_list);
+
+    std::vector<rcclComm_t> rccl_comms(num_gpus);
+    RCCLCHECK(rcclCommInitAll(rccl_comms.data(), num_gpus, device_list.data()));
+
+    // Batch major order goes first, tables of tensors of sync slots are
+    // allocated by then and later orders do not allocate while batches wait
+    // for peers
+    bool passed = MultiAllReduceTest(device_list, rccl_comms, kbatch_major);
+    passed = MultiAllReduceTest(device_list, rccl_comms, kgpu_major) && passed;
+    passed = MultiAllReduceTest(device_list, rccl_comms, kgpu_major_reverse) &&
+             passed;
+    for (int i = 0; i < num_gpus; i++) {
+        RCCLCHECK(rcclCommDestroy(rccl_comms[i]));
+    }
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,151 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+#include "rccl/rccl.h"
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include "common.h"
+#include "validation/validate.h"
+
+//
+// Allreduces are made back to back on registered buffers. Ops go round the
+// sync slots of the communicator, and each gpu switches between two pairs of
+// buffers every kswitch_ops ops, so that a slot sees both the buffers of its
+// previous op (pointers are not published again) and other buffers
+//
+constexpr int knum_ops = 24;
+constexpr int kswitch_ops = 8;
+
+bool RegisteredAllReduceTest(std::vector<int>& device_list, size_t buff_len) {
+    size_t num_gpus = device_list.size();
+    size_t buff_size = buff_len * sizeof(float);
+    EnableDevicePeerAccess(device_list);
+
+    std::vector<rcclComm_t> rccl_comms(num_gpus);
+    RCCLCHECK(rcclCommInitAll(rccl_comms.data(), num_gpus, device_list.data()));
+
+    // Two pairs of source and destination buffers per gpu
+    std::vector<float*> src_device_buffers(2 * num_gpus);
+    std::vector<float*> dst_device_buffers(2 * num_gpus);
+    std::vector<rcclRegHandle_t> handles(4 * num_gpus);
+    std::vector<hipStream_t> streams(num_gpus);
+
+    // Source and result of every op, so that ops are not separated by a sync
+    std::vector<float*> src_host_buffers(knum_ops * num_gpus);
+    std::vector<float*> dst_host_buffers(knum_ops * num_gpus);
+    for (int op = 0; op < knum_ops; op++) {
+        for (size_t i = 0; i < num_gpus; i++) {
+            float** psrc = &src_host_buffers[op * num_gpus + i];
+            float** pdst = &dst_host_buffers[op * num_gpus + i];
+            HIPCHECK(hipHostMalloc(psrc, buff_size));
+            HIPCHECK(hipHostMalloc(pdst, buff_size));
+            std::fill(*psrc, *psrc + buff_len,
+                      static_cast<float>(kbuffer_values[device_list[i]] *
+                                         (op + 1)));
+        }
+    }
+
+    {  // used new scope to force current-device guard to destruct after
+       // changing active device
+        CurrDeviceGuard_t g;
+        for (size_t i = 0; i < num_gpus; i++) {
+            HIPCHECK(hipSetDevice(device_list[i]));
+            HIPCHECK(hipStreamCreate(&streams[i]));
+            for (size_t pair = 0; pair < 2; pair++) {
+                size_t index = 2 * i + pair;
+                HIPCHECK(hipMalloc(&src_device_buffers[index], buff_size));
+                HIPCHECK(hipMalloc(&dst_device_buffers[index], buff_size));
+                RCCLCHECK(rcclCommRegister(rccl_comms[i],
+                                           src_device_buffers[index],
+                                           buff_size, &handles[2 * index]));
+                RCCLCHECK(rcclCommRegister(rccl_comms[i],
+                                           dst_device_buffers[index],
+                                           buff_size, &handles[2 * index + 1]));
+            }
+        }
+    }
+
+    for (int op = 0; op < knum_ops; op++) {
+        size_t pair = (op / kswitch_ops) % 2;
+        for (size_t i = 0; i < num_gpus; i++) {
+            HIPCHECK(hipSetDevice(device_list[i]));
+            HIPCHECK(hipMemcpyAsync(src_device_buffers[2 * i + pair],
+                                    src_host_buffers[op * num_gpus + i],
+                                    buff_size, hipMemcpyHostToDevice,
+                                    streams[i]));
+            RCCLCHECK(rcclAllReduce(src_device_buffers[2 * i + pair],
+                                    dst_device_buffers[2 * i + pair], buff_len,
+                                    rcclFloat, rcclSum, rccl_comms[i],
+                                    streams[i]));
+            HIPCHECK(hipMemcpyAsync(dst_host_buffers[op * num_gpus + i],
+                                    dst_device_buffers[2 * i + pair],
+                                    buff_size, hipMemcpyDeviceToHost,
+                                    streams[i]));
+        }
+    }
+
+    for (size_t i = 0; i < num_gpus; i++) {
+        HIPCHECK(hipSetDevice(device_list[i]));
+        HIPCHECK(hipStreamSynchronize(streams[i]));
+    }
+
+    bool passed = true;
+    for (int op = 0; op < knum_ops; op++) {
+        float sum_val = 0.0f;
+        for (size_t i = 0; i < num_gpus; i++) {
+            sum_val += static_cast<float>(kbuffer_values[device_list[i]] *
+                                          (op + 1));
+        }
+        for (size_t i = 0; i < num_gpus; i++) {
+            if (!validate(dst_host_buffers[op * num_gpus + i], sum_val,
+                          buff_len, 0, 0)) {
+                std::cerr << "op " << op << " failed on gpu "
+                          << device_list[i] << std::endl;
+                passed = false;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < num_gpus; i++) {
+        HIPCHECK(hipSetDevice(device_list[i]));
+        for (size_t handle = 0; handle < 4; handle++) {
+            RCCLCHECK(rcclCommDeregister(rccl_comms[i],
+                                         handles[4 * i + handle]));
+        }
+        for (size_t pair = 0; pair < 2; pair++) {
+            HIPCHECK(hipFree(src_device_buffers[2 * i + pair]));
+            HIPCHECK(hipFree(dst_device_buffers[2 * i + pair]));
+        }
+        HIPCHECK(hipStreamDestroy(streams[i]));
+        RCCLCHECK(rcclCommDestroy(rccl_comms[i]));
+    }
+    for (size_t i = 0; i < src_host_buffers.size(); i++) {
+        HIPCHECK(hipHostFree(src_host_buffers[i]));
+        HIPCHECK(hipHostFree(dst_host_buffers[i]));
+    }
+
+    return passed;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cout << "Usage: ./a.out <num gpus> <number of elements>"
+                  << std::endl;
+        std::cout << "./a.out 4 1048579" << std::endl;
+        return 0;
+    }
+
+    int num_gpus = atoi(argv[1]);
+    size_t buff_len = atol(argv[2]);
+    std::vector<int> device_list(num_gpus);
+    for (int i = 0; i < num_gpus; i++) {
+        device_list[i] = i;
+    }
+
+    bool passed = RegisteredAllReduceTest(device_list, buff_len);
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
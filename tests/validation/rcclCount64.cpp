@@ -0,0 +1,185 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+#include "rccl/rccl.h"
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include "common.h"
+#include "validation/validate.h"
+
+//
+// Ops with size_t counts past 2^30 elements are split into chunks. Data is
+// unsigned char, so that a buffer of that many elements fits in gpu memory
+// and can be set with hipMemset. Sum over 16 gpus still fits in a byte
+//
+typedef unsigned char T;
+
+//
+// Copy count elements at offset of device buffer to host and compare them
+// with val, in slices so that host memory stays small
+//
+bool ValidateDevice(const T* device_buffer, size_t offset, size_t count, T val,
+                    std::vector<T>& host_buffer) {
+    for (size_t done = 0; done < count; done += host_buffer.size()) {
+        size_t len = std::min(host_buffer.size(), count - done);
+        HIPCHECK(hipMemcpy(host_buffer.data(), device_buffer + offset + done,
+                           len * sizeof(T), hipMemcpyDeviceToHost));
+        if (!validate(host_buffer.data(), val, len, 0, 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Count64Test(std::vector<int>& device_list, size_t count) {
+    size_t num_gpus = device_list.size();
+    size_t buff_size = count * sizeof(T);
+    EnableDevicePeerAccess(device_list);
+
+    std::vector<rcclComm_t> rccl_comms(num_gpus);
+    RCCLCHECK(rcclCommInitAll(rccl_comms.data(), num_gpus, device_list.data()));
+
+    std::vector<T*> src_device_buffers(num_gpus);
+    std::vector<T*> dst_device_buffers(num_gpus);
+    std::vector<hipStream_t> streams(num_gpus);
+    std::vector<T> host_buffer(std::min(count, size_t(1) << 26));
+
+    T sum_val = 0;
+    for (size_t i = 0; i < num_gpus; i++) {
+        sum_val += static_cast<T>(kbuffer_values[device_list[i]]);
+    }
+
+    {  // used new scope to force current-device guard to destruct after
+       // changing active device
+        CurrDeviceGuard_t g;
+        for (size_t i = 0; i < num_gpus; i++) {
+            HIPCHECK(hipSetDevice(device_list[i]));
+            HIPCHECK(hipStreamCreate(&streams[i]));
+            HIPCHECK(hipMalloc(&src_device_buffers[i], buff_size));
+            HIPCHECK(hipMalloc(&dst_device_buffers[i], buff_size));
+        }
+    }
+
+    bool passed = true;
+    auto sync = [&]() {
+        for (size_t i = 0; i < num_gpus; i++) {
+            HIPCHECK(hipSetDevice(device_list[i]));
+            HIPCHECK(hipStreamSynchronize(streams[i]));
+        }
+    };
+
+    // Allreduce
+    for (size_t i = 0; i < num_gpus; i++) {
+        HIPCHECK(hipSetDevice(device_list[i]));
+        HIPCHECK(hipMemset(src_device_buffers[i],
+                           kbuffer_values[device_list[i]], buff_size));
+        HIPCHECK(hipMemset(dst_device_buffers[i], 0, buff_size));
+    }
+    for (size_t i = 0; i < num_gpus; i++) {
+        HIPCHECK(hipSetDevice(device_list[i]));
+        RCCLCHECK(rcclAllReduce64(src_device_buffers[i], dst_device_buffers[i],
+                                  count, rcclUchar, rcclSum, rccl_comms[i],
+                                  streams[i]));
+    }
+    sync();
+    for (size_t i = 0; i < num_gpus; i++) {
+        HIPCHECK(hipSetDevice(device_list[i]));
+        if (!ValidateDevice(dst_device_buffers[i], 0, count, sum_val,
+                            host_buffer)) {
+            std::cerr << "rcclAllReduce64 failed on gpu " << device_list[i]
+                      << std::endl;
+            passed = false;
+        }
+    }
+
+    // Reduce to the last gpu, then broadcast its result to the others
+    int root = device_list[num_gpus - 1];
+    for (size_t i = 0; i < num_gpus; i++) {
+        HIPCHECK(hipSetDevice(device_list[i]));
+        HIPCHECK(hipMemset(dst_device_buffers[i], 0, buff_size));
+    }
+    for (size_t i = 0; i < num_gpus; i++) {
+        HIPCHECK(hipSetDevice(device_list[i]));
+        RCCLCHECK(rcclReduce64(src_device_buffers[i], dst_device_buffers[i],
+                               count, rcclUchar, rcclSum, root, rccl_comms[i],
+                               streams[i]));
+    }
+    for (size_t i = 0; i < num_gpus; i++) {
+        HIPCHECK(hipSetDevice(device_list[i]));
+        RCCLCHECK(rcclBcast64(dst_device_buffers[i], count, rcclUchar, root,
+                              rccl_comms[i], streams[i]));
+    }
+    sync();
+    for (size_t i = 0; i < num_gpus; i++) {
+        HIPCHECK(hipSetDevice(device_list[i]));
+        if (!ValidateDevice(dst_device_buffers[i], 0, count, sum_val,
+                            host_buffer)) {
+            std::cerr << "rcclReduce64 and rcclBcast64 failed on gpu "
+                      << device_list[i] << std::endl;
+            passed = false;
+        }
+    }
+
+    // Allgather into a buffer of num_gpus slots on each gpu
+    for (size_t i = 0; i < num_gpus; i++) {
+        HIPCHECK(hipSetDevice(device_list[i]));
+        HIPCHECK(hipFree(dst_device_buffers[i]));
+        HIPCHECK(hipMalloc(&dst_device_buffers[i], num_gpus * buff_size));
+    }
+    for (size_t i = 0; i < num_gpus; i++) {
+        HIPCHECK(hipSetDevice(device_list[i]));
+        RCCLCHECK(rcclAllGather64(src_device_buffers[i], count, rcclUchar,
+                                  dst_device_buffers[i], rccl_comms[i],
+                                  streams[i]));
+    }
+    sync();
+    for (size_t i = 0; i < num_gpus; i++) {
+        HIPCHECK(hipSetDevice(device_list[i]));
+        for (size_t slot = 0; slot < num_gpus; slot++) {
+            if (!ValidateDevice(
+                    dst_device_buffers[i], slot * count, count,
+                    static_cast<T>(kbuffer_values[device_list[slot]]),
+                    host_buffer)) {
+                std::cerr << "rcclAllGather64 failed on gpu " << device_list[i]
+                          << " in slot " << slot << std::endl;
+                passed = false;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < num_gpus; i++) {
+        HIPCHECK(hipSetDevice(device_list[i]));
+        HIPCHECK(hipFree(src_device_buffers[i]));
+        HIPCHECK(hipFree(dst_device_buffers[i]));
+        HIPCHECK(hipStreamDestroy(streams[i]));
+        RCCLCHECK(rcclCommDestroy(rccl_comms[i]));
+    }
+
+    return passed;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 3) {
+        std::cout << "Usage: ./a.out <num gpus> [number of elements]"
+                  << std::endl;
+        std::cout << "./a.out 4 1073741829" << std::endl;
+        return 0;
+    }
+
+    int num_gpus = atoi(argv[1]);
+    // Past 2^30 elements by default, so that ops are chunked and the last
+    // chunk is not a multiple of number of gpus
+    size_t count = argc == 3 ? static_cast<size_t>(atoll(argv[2]))
+                             : (size_t(1) << 30) + 5;
+    std::vector<int> device_list(num_gpus);
+    for (int i = 0; i < num_gpus; i++) {
+        device_list[i] = i;
+    }
+
+    bool passed = Count64Test(device_list, count);
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,176 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+#include "rccl/rccl.h"
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include "common.h"
+#include "validation/validate.h"
+
+//
+// Tensors allreduced in a group made by a single thread for all gpus. The
+// first five follow each other and are fused into one tensor, a gap of kgap
+// elements makes the next two a separate tensor of the same fused
+// multi-tensor op, and the last one is too large to be fused
+//
+const std::vector<size_t> ktensor_counts = {1,    255, 1024, 4093,
+                                            8192, 2048, 17,  100000};
+constexpr size_t kgap_tensor = 5;
+constexpr size_t kgap = 3;
+constexpr float ksentinel = -1.0f;
+
+//
+// Make allreduce of every tensor on every gpu in one group. Ops are made
+// either tensor by tensor across gpus, or gpu by gpu in a nested group
+//
+void GroupAllReduce(std::vector<int>& device_list,
+                    std::vector<rcclComm_t>& rccl_comms,
+                    std::vector<hipStream_t>& streams,
+                    std::vector<float*>& src_device_buffers,
+                    std::vector<float*>& dst_device_buffers,
+                    std::vector<size_t>& offsets, bool gpu_major) {
+    size_t num_gpus = device_list.size();
+    size_t num_tensors = ktensor_counts.size();
+
+    RCCLCHECK(rcclGroupStart());
+    for (size_t outer = 0; outer < (gpu_major ? num_gpus : num_tensors);
+         outer++) {
+        if (gpu_major) {
+            RCCLCHECK(rcclGroupStart());
+        }
+        for (size_t inner = 0; inner < (gpu_major ? num_tensors : num_gpus);
+             inner++) {
+            size_t i = gpu_major ? outer : inner;
+            size_t t = gpu_major ? inner : outer;
+            HIPCHECK(hipSetDevice(device_list[i]));
+            RCCLCHECK(rcclAllReduce(src_device_buffers[i] + offsets[t],
+                                    dst_device_buffers[i] + offsets[t],
+                                    ktensor_counts[t], rcclFloat, rcclSum,
+                                    rccl_comms[i], streams[i]));
+        }
+        if (gpu_major) {
+            RCCLCHECK(rcclGroupEnd());
+        }
+    }
+    RCCLCHECK(rcclGroupEnd());
+}
+
+bool GroupTest(std::vector<int>& device_list) {
+    size_t num_gpus = device_list.size();
+    size_t num_tensors = ktensor_counts.size();
+    EnableDevicePeerAccess(device_list);
+
+    std::vector<rcclComm_t> rccl_comms(num_gpus);
+    RCCLCHECK(rcclCommInitAll(rccl_comms.data(), num_gpus, device_list.data()));
+
+    // Offset of each tensor in buffers of a gpu
+    std::vector<size_t> offsets(num_tensors);
+    size_t buff_len = 0;
+    for (size_t t = 0; t < num_tensors; t++) {
+        if (t == kgap_tensor) buff_len += kgap;
+        offsets[t] = buff_len;
+        buff_len += ktensor_counts[t];
+    }
+    size_t buff_size = buff_len * sizeof(float);
+
+    std::vector<float*> src_host_buffers(num_gpus);
+    std::vector<float*> dst_host_buffers(num_gpus);
+    std::vector<float*> src_device_buffers(num_gpus);
+    std::vector<float*> dst_device_buffers(num_gpus);
+    std::vector<hipStream_t> streams(num_gpus);
+    std::vector<float> expected(buff_len, ksentinel);
+
+    for (size_t i = 0; i < num_gpus; i++) {
+        HIPCHECK(hipHostMalloc(&src_host_buffers[i], buff_size));
+        HIPCHECK(hipHostMalloc(&dst_host_buffers[i], buff_size));
+        std::fill(src_host_buffers[i], src_host_buffers[i] + buff_len,
+                  ksentinel);
+        for (size_t t = 0; t < num_tensors; t++) {
+            float val = static_cast<float>(kbuffer_values[device_list[i]] *
+                                           (t + 1));
+            std::fill(src_host_buffers[i] + offsets[t],
+                      src_host_buffers[i] + offsets[t] + ktensor_counts[t],
+                      val);
+            std::fill(expected.begin() + offsets[t],
+                      expected.begin() + offsets[t] + ktensor_counts[t],
+                      i == 0 ? val : expected[offsets[t]] + val);
+        }
+    }
+
+    {  // used new scope to force current-device guard to destruct after
+       // changing active device
+        CurrDeviceGuard_t g;
+        for (size_t i = 0; i < num_gpus; i++) {
+            HIPCHECK(hipSetDevice(device_list[i]));
+            HIPCHECK(hipStreamCreate(&streams[i]));
+            HIPCHECK(hipMalloc(&src_device_buffers[i], buff_size));
+            HIPCHECK(hipMalloc(&dst_device_buffers[i], buff_size));
+        }
+    }
+
+    bool passed = true;
+    for (int gpu_major = 0; gpu_major < 2; gpu_major++) {
+        // Gaps of destination buffers hold ksentinel, fused ops must not
+        // write to them
+        for (size_t i = 0; i < num_gpus; i++) {
+            HIPCHECK(hipSetDevice(device_list[i]));
+            HIPCHECK(hipMemcpyAsync(src_device_buffers[i], src_host_buffers[i],
+                                    buff_size, hipMemcpyHostToDevice,
+                                    streams[i]));
+            HIPCHECK(hipMemcpyAsync(dst_device_buffers[i], src_host_buffers[i],
+                                    buff_size, hipMemcpyHostToDevice,
+                                    streams[i]));
+        }
+
+        GroupAllReduce(device_list, rccl_comms, streams, src_device_buffers,
+                       dst_device_buffers, offsets, gpu_major == 1);
+
+        for (size_t i = 0; i < num_gpus; i++) {
+            HIPCHECK(hipSetDevice(device_list[i]));
+            HIPCHECK(hipMemcpyAsync(dst_host_buffers[i], dst_device_buffers[i],
+                                    buff_size, hipMemcpyDeviceToHost,
+                                    streams[i]));
+            HIPCHECK(hipStreamSynchronize(streams[i]));
+            if (!validate(dst_host_buffers[i], expected.data(), buff_len, 0,
+                          0)) {
+                std::cerr << (gpu_major ? "gpu major" : "tensor major")
+                          << " group failed on gpu " << device_list[i]
+                          << std::endl;
+                passed = false;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < num_gpus; i++) {
+        HIPCHECK(hipSetDevice(device_list[i]));
+        HIPCHECK(hipFree(src_device_buffers[i]));
+        HIPCHECK(hipFree(dst_device_buffers[i]));
+        HIPCHECK(hipHostFree(src_host_buffers[i]));
+        HIPCHECK(hipHostFree(dst_host_buffers[i]));
+        HIPCHECK(hipStreamDestroy(streams[i]));
+        RCCLCHECK(rcclCommDestroy(rccl_comms[i]));
+    }
+
+    return passed;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::cout << "Usage: ./a.out <num gpus>" << std::endl;
+        std::cout << "./a.out 4" << std::endl;
+        return 0;
+    }
+
+    int num_gpus = atoi(argv[1]);
+    std::vector<int> device_list(num_gpus);
+    for (int i = 0; i < num_gpus; i++) {
+        device_list[i] = i;
+    }
+
+    bool passed = GroupTest(device_list);
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
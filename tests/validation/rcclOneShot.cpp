@@ -0,0 +1,117 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+#include "rccl/rccl.h"
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include "common.h"
+#include "validation/validate.h"
+
+//
+// Allreduce of buffers up to 64 KB uses the one-shot kernel, in which every
+// gpu reads the whole buffer of every peer. In place, a gpu must not store
+// a result while peers may still read the element it overwrites. Run with
+// RCCL_ALGO=oneshot so that the larger sizes, which take several rounds of
+// the kernel, use it too
+//
+const std::vector<size_t> kbuff_lens = {1, 255, 4093, 16384, 16385, 40000};
+
+bool OneShotTest(std::vector<int>& device_list, std::vector<rcclComm_t>& comms,
+                 size_t buff_len, rcclRedOp_t op, bool in_place) {
+    size_t num_gpus = device_list.size();
+    size_t buff_size = buff_len * sizeof(float);
+
+    std::vector<float*> src_device_buffers(num_gpus);
+    std::vector<float*> dst_device_buffers(num_gpus);
+    std::vector<hipStream_t> streams(num_gpus);
+    std::vector<float> host_buffer(buff_len);
+
+    float expected = 0.0f;
+    for (size_t i = 0; i < num_gpus; i++) {
+        float val = static_cast<float>(kbuffer_values[device_list[i]]);
+        expected = op == rcclSum ? expected + val : std::max(expected, val);
+    }
+
+    {  // used new scope to force current-device guard to destruct after
+       // changing active device
+        CurrDeviceGuard_t g;
+        for (size_t i = 0; i < num_gpus; i++) {
+            HIPCHECK(hipSetDevice(device_list[i]));
+            HIPCHECK(hipStreamCreate(&streams[i]));
+            HIPCHECK(hipMalloc(&src_device_buffers[i], buff_size));
+            HIPCHECK(hipMalloc(&dst_device_buffers[i], buff_size));
+            std::fill(host_buffer.begin(), host_buffer.end(),
+                      static_cast<float>(kbuffer_values[device_list[i]]));
+            HIPCHECK(hipMemcpy(src_device_buffers[i], host_buffer.data(),
+                               buff_size, hipMemcpyHostToDevice));
+        }
+    }
+
+    for (size_t i = 0; i < num_gpus; i++) {
+        HIPCHECK(hipSetDevice(device_list[i]));
+        float* dst = in_place ? src_device_buffers[i] : dst_device_buffers[i];
+        RCCLCHECK(rcclAllReduce(src_device_buffers[i], dst, buff_len,
+                                rcclFloat, op, comms[i], streams[i]));
+    }
+
+    bool passed = true;
+    for (size_t i = 0; i < num_gpus; i++) {
+        HIPCHECK(hipSetDevice(device_list[i]));
+        HIPCHECK(hipStreamSynchronize(streams[i]));
+        float* dst = in_place ? src_device_buffers[i] : dst_device_buffers[i];
+        HIPCHECK(hipMemcpy(host_buffer.data(), dst, buff_size,
+                           hipMemcpyDeviceToHost));
+        if (!validate(host_buffer.data(), expected, buff_len, 0, 0)) {
+            std::cerr << (in_place ? "in-place" : "out-of-place")
+                      << " allreduce of " << buff_len
+                      << " elements failed on gpu " << device_list[i]
+                      << std::endl;
+            passed = false;
+        }
+    }
+
+    for (size_t i = 0; i < num_gpus; i++) {
+        HIPCHECK(hipSetDevice(device_list[i]));
+        HIPCHECK(hipFree(src_device_buffers[i]));
+        HIPCHECK(hipFree(dst_device_buffers[i]));
+        HIPCHECK(hipStreamDestroy(streams[i]));
+    }
+
+    return passed;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::cout << "Usage: ./a.out <num gpus>" << std::endl;
+        std::cout << "RCCL_ALGO=oneshot ./a.out 4" << std::endl;
+        return 0;
+    }
+
+    int num_gpus = atoi(argv[1]);
+    std::vector<int> device_list(num_gpus);
+    for (int i = 0; i < num_gpus; i++) {
+        device_list[i] = i;
+    }
+    EnableDevicePeerAccess(device_list);
+
+    std::vector<rcclComm_t> comms(num_gpus);
+    RCCLCHECK(rcclCommInitAll(comms.data(), num_gpus, device_list.data()));
+
+    bool passed = true;
+    for (size_t buff_len : kbuff_lens) {
+        for (rcclRedOp_t op : {rcclSum, rcclMax}) {
+            passed &= OneShotTest(device_list, comms, buff_len, op, true);
+            passed &= OneShotTest(device_list, comms, buff_len, op, false);
+        }
+    }
+
+    for (int i = 0; i < num_gpus; i++) {
+        RCCLCHECK(rcclCommDestroy(comms[i]));
+    }
+
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
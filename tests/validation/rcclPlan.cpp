@@ -0,0 +1,142 @@
+/*
+Copyright (c) 2017 - Present Advanced Micro Devices, Inc.
+All rights reserved.
+*/
+
+#include "rccl/rccl.h"
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include "common.h"
+#include "validation/validate.h"
+
+//
+// A plan is executed more times than there are sync slots in a communicator,
+// with new data each time and without a sync in between, so that it runs on
+// every slot and its precomputed launch configuration is reused
+//
+constexpr int knum_executions = 6;
+
+bool PlanAllReduceTest(std::vector<int>& device_list, size_t buff_len,
+                       rcclRedOp_t op) {
+    size_t num_gpus = device_list.size();
+    size_t buff_size = buff_len * sizeof(float);
+
+    std::vector<rcclComm_t> rccl_comms(num_gpus);
+    RCCLCHECK(rcclCommInitAll(rccl_comms.data(), num_gpus, device_list.data()));
+
+    std::vector<float*> src_device_buffers(num_gpus);
+    std::vector<float*> dst_device_buffers(num_gpus);
+    std::vector<rcclPlan_t> plans(num_gpus);
+    std::vector<hipStream_t> streams(num_gpus);
+
+    // Source and result of every execution
+    std::vector<float*> src_host_buffers(knum_executions * num_gpus);
+    std::vector<float*> dst_host_buffers(knum_executions * num_gpus);
+    for (int exec = 0; exec < knum_executions; exec++) {
+        for (size_t i = 0; i < num_gpus; i++) {
+            float** psrc = &src_host_buffers[exec * num_gpus + i];
+            float** pdst = &dst_host_buffers[exec * num_gpus + i];
+            HIPCHECK(hipHostMalloc(psrc, buff_size));
+            HIPCHECK(hipHostMalloc(pdst, buff_size));
+            std::fill(*psrc, *psrc + buff_len,
+                      static_cast<float>(kbuffer_values[device_list[i]] +
+                                         exec));
+        }
+    }
+
+    {  // used new scope to force current-device guard to destruct after
+       // changing active device
+        CurrDeviceGuard_t g;
+        for (size_t i = 0; i < num_gpus; i++) {
+            HIPCHECK(hipSetDevice(device_list[i]));
+            HIPCHECK(hipStreamCreate(&streams[i]));
+            HIPCHECK(hipMalloc(&src_device_buffers[i], buff_size));
+            HIPCHECK(hipMalloc(&dst_device_buffers[i], buff_size));
+            RCCLCHECK(rcclAllReducePlanCreate(
+                src_device_buffers[i], dst_device_buffers[i], buff_len,
+                rcclFloat, op, rccl_comms[i], &plans[i]));
+        }
+    }
+
+    for (int exec = 0; exec < knum_executions; exec++) {
+        for (size_t i = 0; i < num_gpus; i++) {
+            HIPCHECK(hipSetDevice(device_list[i]));
+            HIPCHECK(hipMemcpyAsync(src_device_buffers[i],
+                                    src_host_buffers[exec * num_gpus + i],
+                                    buff_size, hipMemcpyHostToDevice,
+                                    streams[i]));
+            RCCLCHECK(rcclPlanExecute(plans[i], streams[i]));
+            HIPCHECK(hipMemcpyAsync(dst_host_buffers[exec * num_gpus + i],
+                                    dst_device_buffers[i], buff_size,
+                                    hipMemcpyDeviceToHost, streams[i]));
+        }
+    }
+
+    for (size_t i = 0; i < num_gpus; i++) {
+        HIPCHECK(hipSetDevice(device_list[i]));
+        HIPCHECK(hipStreamSynchronize(streams[i]));
+    }
+
+    bool passed = true;
+    for (int exec = 0; exec < knum_executions; exec++) {
+        float expected = 0.0f;
+        for (size_t i = 0; i < num_gpus; i++) {
+            float val =
+                static_cast<float>(kbuffer_values[device_list[i]] + exec);
+            expected = op == rcclSum ? expected + val : std::max(expected, val);
+        }
+        for (size_t i = 0; i < num_gpus; i++) {
+            if (!validate(dst_host_buffers[exec * num_gpus + i], expected,
+                          buff_len, 0, 0)) {
+                std::cerr << "execution " << exec << " of " << buff_len
+                          << " elements failed on gpu " << device_list[i]
+                          << std::endl;
+                passed = false;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < num_gpus; i++) {
+        HIPCHECK(hipSetDevice(device_list[i]));
+        RCCLCHECK(rcclPlanDestroy(plans[i]));
+        HIPCHECK(hipFree(src_device_buffers[i]));
+        HIPCHECK(hipFree(dst_device_buffers[i]));
+        HIPCHECK(hipStreamDestroy(streams[i]));
+        RCCLCHECK(rcclCommDestroy(rccl_comms[i]));
+    }
+    for (size_t i = 0; i < src_host_buffers.size(); i++) {
+        HIPCHECK(hipHostFree(src_host_buffers[i]));
+        HIPCHECK(hipHostFree(dst_host_buffers[i]));
+    }
+
+    return passed;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cout << "Usage: ./a.out <num gpus> <number of elements>"
+                  << std::endl;
+        std::cout << "./a.out 4 1048579" << std::endl;
+        return 0;
+    }
+
+    int num_gpus = atoi(argv[1]);
+    std::vector<int> device_list(num_gpus);
+    for (int i = 0; i < num_gpus; i++) {
+        device_list[i] = i;
+    }
+    EnableDevicePeerAccess(device_list);
+
+    // Plans of buffers smaller than, not divisible by, and of the given
+    // number of elements
+    std::vector<size_t> buff_lens = {1, 1027,
+                                     static_cast<size_t>(atol(argv[2]))};
+    bool passed = true;
+    for (size_t buff_len : buff_lens) {
+        passed = PlanAllReduceTest(device_list, buff_len, rcclSum) && passed;
+        passed = PlanAllReduceTest(device_list, buff_len, rcclMax) && passed;
+    }
+    std::cout << (passed ? "PASSED" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}